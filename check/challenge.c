@@ -9,6 +9,11 @@
 
 //defines:
 #define DEFAULT 0
+#define UNUSED_PERIOD -1
+
+//Static functions list:
+static WindowBucket *window_bucket(ChallengeWindow *window, int time);
+static void return_lent_name(Challenge *challenge);
 
 //functions:
 /*  Function initializes a specific challenge
@@ -23,18 +28,18 @@ Result init_challenge(Challenge *challenge, int id, char *name, Level level) {
     if ( challenge ==  NULL || name == NULL) {
         return NULL_PARAMETER;
     }
-    char *name_copy = malloc((strlen(name) + 1)*(sizeof(char)));
-    //adds 1 for "\0" - end of string.
-    //verify allocation
-    if (name_copy == NULL) {
-        return MEMORY_PROBLEM;
+    challenge -> name = NULL;
+    challenge -> name_block = NULL;
+    Result result = store_name(&challenge->name, challenge->inline_name, name);
+    if (result != OK) {
+        return result;
     }
-    strcpy(name_copy, name);
     challenge -> id = id;
-    challenge -> name = name_copy;
     challenge -> level = level;
     challenge -> best_time = DEFAULT;
     challenge -> num_visits = DEFAULT;
+    memset(&challenge->completions, 0, sizeof(challenge->completions));
+    set_challenge_window_width(challenge, CHALLENGE_WINDOW_WIDTH);
     return OK;
 }
 
@@ -46,11 +51,11 @@ Result reset_challenge(Challenge *challenge) {
     if (challenge ==  NULL) {
         return NULL_PARAMETER;
     }
-    //check if the name field contains a string to be freed
-    if (challenge -> name != NULL ) {
-        free(challenge->name);
+    //releases the name if it was allocated
+    if (challenge->name_block) {
+        return_lent_name(challenge);
     }
-    challenge -> name = NULL;
+    release_name(&challenge->name, challenge->inline_name);
     challenge -> id = DEFAULT;
     challenge -> level = (Level) DEFAULT;
     challenge -> best_time = DEFAULT;
@@ -68,18 +73,150 @@ Result change_name(Challenge *challenge, char *name) {
     if ( challenge ==  NULL || name == NULL) {
         return NULL_PARAMETER;
     }
-    char *name_copy = malloc((strlen(name) + 1)*(sizeof(char)));
-    //adds 1 for "\0" - end of string.
-    //verify allocation
-    if (name_copy == NULL) {
-        return MEMORY_PROBLEM;
+    if (challenge->name_block) {
+        //the lent name stays readable for the copy, it may be the new name.
+        char *lent_name = challenge->name;
+        NameBlock *block = challenge->name_block;
+        challenge -> name = NULL;
+        Result result = store_name(&challenge->name, challenge->inline_name,
+                                   name);
+        if (result != OK) {
+            challenge -> name = lent_name;
+            return result;
+        }
+        challenge -> name_block = NULL;
+        release_name_block(block);
+        return OK;
+    }
+    return store_name(&challenge->name, challenge->inline_name, name);
+}
+
+/*Function moves the name of a challenge to another one, releasing the name
+ * the other one had. the source is left with no name, ready to be reset.
+ * moving allocates nothing, so it can't fail.
+ * Receives: the Challenge pointer that takes the name
+ *           the Challenge pointer that gives it
+ * Error Codes: NULL_PARAMETER if a challenge is NULL or the source has no
+ *              name*/
+Result move_name(Challenge *challenge, Challenge *source) {
+    //input check
+    if ( challenge == NULL || source == NULL || source->name == NULL ) {
+        return NULL_PARAMETER;
+    }
+    if ( challenge == source ) {
+        return OK;
+    }
+    if (challenge->name_block) {
+        return_lent_name(challenge);
+    }
+    release_name(&challenge->name, challenge->inline_name);
+    if (NAME_ON_HEAP(source->name, source->inline_name)) {
+        challenge -> name = source->name;
+    }
+    else {
+        strcpy(challenge->inline_name, source->inline_name);
+        challenge -> name = challenge->inline_name;
+    }
+    challenge -> name_block = source->name_block;
+    source -> name = NULL;
+    source -> name_block = NULL;
+    return OK;
+}
+
+/*Function makes a challenge use a name of a block, without copying it. the
+ * block is kept alive until the challenge drops the name.
+ * Receives: Challenge pointer
+ *           the block holding the name
+ *           the name to use
+ * Error Codes: NULL_PARAMETER if challenge, block or name is NULL*/
+Result lend_name(Challenge *challenge, NameBlock *block, char *name) {
+    if (challenge == NULL || block == NULL || name == NULL) {
+        return NULL_PARAMETER;
+    }
+    block -> references++;
+    if (challenge->name_block) {
+        return_lent_name(challenge);
+    }
+    release_name(&challenge->name, challenge->inline_name);
+    challenge -> name = name;
+    challenge -> name_block = block;
+    return OK;
+}
+
+/*Function allocates a block for names of the given total size and puts it
+ * first in a list. the caller holds the one reference of the new block, and
+ * releases it with release_name_block when it is done lending its names.
+ * Receives: the list of blocks
+ *           the size of the names, with their terminating '\0'
+ * Returns the new block, or NULL if the system was unable to allocate it*/
+NameBlock *create_name_block(NameBlock **list, size_t size) {
+    NameBlock *block = malloc(sizeof(*block) + size);
+    if (block == NULL) {
+        return NULL;
+    }
+    block -> names = (char *)(block + 1);
+    block -> references = 1;
+    block -> next = *list;
+    block -> link = list;
+    if (block->next) {
+        block -> next -> link = &block->next;
+    }
+    *list = block;
+    return block;
+}
+
+/*Function drops a reference of a name block, and takes it out of its list
+ * and frees it if it was the last one.
+ * Receives: the block, may be NULL*/
+void release_name_block(NameBlock *block) {
+    if (block == NULL || --block->references > 0) {
+        return;
+    }
+    *block->link = block->next;
+    if (block->next) {
+        block -> next -> link = block->link;
+    }
+    free(block);
+}
+
+/*Function stores a copy of a name in the inline buffer of its owner if it
+ * fits, or on the heap otherwise, and releases the name it replaces. the new
+ * name may be the current one.
+ * Receives: name - the name pointer of the owner, NULL if it has no name yet
+ *           inline name - the NAME_INLINE_SIZE buffer of the owner
+ *           new name as string
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory*/
+Result store_name(char **name, char *inline_name, char *new_name) {
+    size_t length = strlen(new_name);
+    char *old_name = *name;
+    if (length < NAME_INLINE_SIZE) {
+        memmove(inline_name, new_name, length + 1);
+        *name = inline_name;
+    }
+    else {
+        char *name_copy = malloc(length + 1);
+        if (name_copy == NULL) {
+            return MEMORY_PROBLEM;
+        }
+        memcpy(name_copy, new_name, length + 1);
+        *name = name_copy;
+    }
+    if (old_name != NULL && NAME_ON_HEAP(old_name, inline_name)) {
+        free(old_name);
     }
-    strcpy(name_copy, name);
-    free(challenge->name);
-    challenge -> name = name_copy;
     return OK;
 }
 
+/*Function releases a name stored by store_name and sets it to NULL.
+ * Receives: name - the name pointer of the owner
+ *           inline name - the inline buffer of the owner*/
+void release_name(char **name, char *inline_name) {
+    if (*name != NULL && NAME_ON_HEAP(*name, inline_name)) {
+        free(*name);
+    }
+    *name = NULL;
+}
+
 /*Function sets the best_time field in a challenge to given time parameter
  * Receives: Challenge pointer
  *           time to set
@@ -134,3 +271,208 @@ Result num_visits(Challenge *challenge, int *visits) {
     *visits = challenge -> num_visits;
     return OK;
 }
+
+/*Function lowers the best time of a challenge to the given time, if the
+ * challenge has no best time yet or a higher one.
+ *  * Receives: Challenge pointer
+ *              the time to offer
+ * Error Codes: NULL_PARAMETER if challenge is NULL
+ *              ILLEGAL_PARAMETER if time isn't positive*/
+Result offer_best_time_of_challenge(Challenge *challenge, int time) {
+    //input check
+    if ( challenge == NULL ) {
+        return NULL_PARAMETER;
+    }
+    if ( time <= 0 ) {
+        return ILLEGAL_PARAMETER;
+    }
+    if ( challenge->best_time == 0 || time < challenge->best_time ) {
+        challenge -> best_time = time;
+    }
+    return OK;
+}
+
+/*Function sets the length of the periods the recent activity of a challenge
+ * is kept in, and forgets the activity recorded so far.
+ *  * Receives: Challenge pointer
+ *              the period length in time units
+ * Error Codes: NULL_PARAMETER if challenge is NULL
+ *              ILLEGAL_PARAMETER if bucket width isn't positive*/
+Result set_challenge_window_width(Challenge *challenge, int bucket_width) {
+    //input check
+    if ( challenge == NULL ) {
+        return NULL_PARAMETER;
+    }
+    if ( bucket_width <= 0 ) {
+        return ILLEGAL_PARAMETER;
+    }
+    challenge -> window.bucket_width = bucket_width;
+    for (int i = 0; i < CHALLENGE_WINDOW_BUCKETS; ++i) {
+        challenge -> window.buckets[i].period = UNUSED_PERIOD;
+    }
+    return OK;
+}
+
+/*Function counts a visit to a challenge in the period of the given time.
+ *  * Receives: Challenge pointer
+ *              the time the visit started
+ * Error Codes: NULL_PARAMETER if challenge is NULL
+ *              ILLEGAL_PARAMETER if time is negative*/
+Result record_challenge_visit(Challenge *challenge, int time) {
+    //input check
+    if ( challenge == NULL ) {
+        return NULL_PARAMETER;
+    }
+    if ( time < 0 ) {
+        return ILLEGAL_PARAMETER;
+    }
+    window_bucket(&challenge->window, time) -> visits++;
+    return OK;
+}
+
+/*Function lowers the best time of the period of the given time if needed,
+ * and adds the duration to the completion sketch of a challenge.
+ *  * Receives: Challenge pointer
+ *              the time the visitor quit
+ *              the time the visitor spent in the challenge
+ * Error Codes: NULL_PARAMETER if challenge is NULL
+ *              ILLEGAL_PARAMETER if time is negative*/
+Result record_challenge_completion(Challenge *challenge, int time,
+                                   int duration) {
+    //input check
+    if ( challenge == NULL ) {
+        return NULL_PARAMETER;
+    }
+    if ( time < 0 ) {
+        return ILLEGAL_PARAMETER;
+    }
+    WindowBucket *bucket = window_bucket(&challenge->window, time);
+    if ( duration > 0 && (bucket->best_time == 0 ||
+                          duration < bucket->best_time) ) {
+        bucket -> best_time = duration;
+    }
+    if ( duration >= 0 ) {
+        CompletionSketch *sketch = &challenge->completions;
+        int index = histogram_bucket_index(duration);
+        unsigned short *count = &sketch->counts[index];
+        if ( *count < COMPLETION_COUNT_MAX ) {
+            (*count)++;
+            sketch -> total++;
+        }
+        if ( duration > sketch->max_time ) {
+            sketch -> max_time = duration;
+        }
+    }
+    return OK;
+}
+
+/*Function sums the activity of a challenge over the periods that cover the
+ * last window time units before now, in whole periods.
+ *  * Receives: Challenge pointer
+ *              the current time
+ *              the window length in time units, at most
+ *              CHALLENGE_WINDOW_BUCKETS periods are kept
+ *              int pointer to return the visits in the window
+ *              int pointer to return the best time in the window, 0 if none
+ * Error Codes: NULL_PARAMETER if challenge, visits or best time is NULL
+ *              ILLEGAL_PARAMETER if now is negative or window isn't
+ *              positive*/
+Result challenge_window_stats(Challenge *challenge, int now, int window,
+                              int *visits, int *best_time) {
+    //input check
+    if ( challenge == NULL || visits == NULL || best_time == NULL ) {
+        return NULL_PARAMETER;
+    }
+    if ( now < 0 || window <= 0 ) {
+        return ILLEGAL_PARAMETER;
+    }
+    int width = challenge -> window.bucket_width;
+    int num_periods = window / width + (window % width != 0);
+    if ( num_periods > CHALLENGE_WINDOW_BUCKETS ) {
+        num_periods = CHALLENGE_WINDOW_BUCKETS;
+    }
+    int last_period = now / width;
+    *visits = 0;
+    *best_time = 0;
+    for (int i = 0; i < CHALLENGE_WINDOW_BUCKETS; ++i) {
+        WindowBucket *bucket = &challenge->window.buckets[i];
+        if ( bucket->period == UNUSED_PERIOD ||
+             bucket->period > last_period ||
+             bucket->period <= last_period - num_periods ) {
+            continue;
+        }
+        *visits += bucket -> visits;
+        if ( bucket->best_time != 0 && (*best_time == 0 ||
+                                        bucket->best_time < *best_time) ) {
+            *best_time = bucket -> best_time;
+        }
+    }
+    return OK;
+}
+
+/*Function estimates a percentile of the completion times of a challenge,
+ * within the bucket precision of latency_histogram.h.
+ *  * Receives: Challenge pointer
+ *              the percentile wanted, between 0 and 100
+ *              int pointer to return the estimate, 0 if no visitor completed
+ *              the challenge yet
+ * Error Codes: NULL_PARAMETER if challenge or time is NULL
+ *              ILLEGAL_PARAMETER if percentile is out of range*/
+Result challenge_completion_percentile(Challenge *challenge, double percentile,
+                                       int *time) {
+    //input check
+    if ( challenge == NULL || time == NULL ) {
+        return NULL_PARAMETER;
+    }
+    if ( percentile < 0 || percentile > 100 ) {
+        return ILLEGAL_PARAMETER;
+    }
+    CompletionSketch *sketch = &challenge->completions;
+    *time = 0;
+    if ( sketch->total == 0 ) {
+        return OK;
+    }
+    unsigned long long rank = (unsigned long long)
+            (percentile / 100.0 * sketch->total + 0.5);
+    if ( rank == 0 ) {
+        rank = 1;
+    }
+    unsigned long long seen = 0;
+    for (int i = 0; i < COMPLETION_BUCKETS; ++i) {
+        seen += sketch->counts[i];
+        if ( seen >= rank ) {
+            unsigned long long top = histogram_bucket_value(i);
+            //the bucket upper bound may overshoot the real maximum.
+            *time = top < (unsigned long long)sketch->max_time ?
+                    (int)top : sketch->max_time;
+            return OK;
+        }
+    }
+    *time = sketch -> max_time;
+    return OK;
+}
+
+//static functions:
+
+/*Function makes a challenge drop the name a block lends it. the challenge
+ * is left with no name.*/
+static void return_lent_name(Challenge *challenge) {
+    NameBlock *block = challenge->name_block;
+    challenge -> name = NULL;
+    challenge -> name_block = NULL;
+    release_name_block(block);
+}
+
+/*Function returns the bucket of the period of the given time, emptying it
+ * first if it still holds an older period.*/
+static WindowBucket *window_bucket(ChallengeWindow *window, int time) {
+    int period = time / window->bucket_width;
+    WindowBucket *bucket = &window->buckets[period % CHALLENGE_WINDOW_BUCKETS];
+    if ( bucket->period != period ) {
+        bucket -> period = period;
+        bucket -> visits = DEFAULT;
+        bucket -> best_time = DEFAULT;
+    }
+    return bucket;
+}
+
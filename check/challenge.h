@@ -1,15 +1,83 @@
 #ifndef CHALLENGE_H_
 #define CHALLENGE_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <limits.h>
+
 #include "constants.h"
+#include "latency_histogram.h"
+
+/* names shorter than NAME_INLINE_SIZE are kept in a buffer inside the struct
+ * that owns them, and only longer names are allocated. the name pointer
+ * points to whichever holds the name, so it is read the same way.*/
+#define NAME_INLINE_SIZE 24
+#define NAME_ON_HEAP(name, inline_name) ((name) != (inline_name))
+
+/* recent activity of a challenge is kept in a ring of the last
+ * CHALLENGE_WINDOW_BUCKETS periods of bucket_width time units each, so the
+ * default ring covers a day of minutes in hourly buckets. a window is
+ * counted in whole periods back from the period of now: it is rounded up to
+ * a multiple of bucket_width and always starts at a period boundary, so it
+ * may reach up to one period further back than asked, or less than asked
+ * when now is early in its period. activity older than the last
+ * CHALLENGE_WINDOW_BUCKETS periods is gone.*/
+#define CHALLENGE_WINDOW_BUCKETS 24
+#define CHALLENGE_WINDOW_WIDTH 60
+
+typedef struct SWindowBucket
+{
+   int period; //time / bucket_width of the bucket, -1 while unused.
+   int visits;
+   int best_time;
+} WindowBucket;
+
+typedef struct SChallengeWindow
+{
+   int bucket_width;
+   WindowBucket buckets[CHALLENGE_WINDOW_BUCKETS];
+} ChallengeWindow;
+
+/* completion times of a challenge, in the log buckets of latency_histogram.h
+ * cut down to the range of an int. a bucket stops counting at
+ * COMPLETION_COUNT_MAX, and total only counts the completions the buckets
+ * kept, so a duration that common weighs less in the percentiles than it
+ * should.*/
+#define COMPLETION_BUCKETS ((32 - HISTOGRAM_SUB_BUCKET_BITS) * \
+                            HISTOGRAM_SUB_BUCKETS)
+#define COMPLETION_COUNT_MAX USHRT_MAX
+
+typedef struct SCompletionSketch
+{
+   unsigned short counts[COMPLETION_BUCKETS];
+   unsigned int total;
+   int max_time;
+} CompletionSketch;
+
+/* names allocated together and lent to challenges instead of copied. a block
+ * counts the challenges using one of its names, plus whoever is still filling
+ * it, and is released when the count drops to 0. the owner keeps its blocks
+ * in a list; link is the pointer of the list that points to the block, so
+ * the block can leave the list without the owner.*/
+typedef struct SNameBlock
+{
+   struct SNameBlock *next;
+   struct SNameBlock **link;
+   int references;
+   char *names; //right after the block header.
+} NameBlock;
 
 typedef struct SChallenge
 {
    int id;
    char *name;
+   char inline_name[NAME_INLINE_SIZE];
+   NameBlock *name_block; //lends the name, NULL if the challenge owns it.
    Level level;
    int best_time;
    int num_visits;
+   ChallengeWindow window;
+   CompletionSketch completions;
 } Challenge;
 
 Result init_challenge(Challenge *challenge, int id, char *name, Level level);
@@ -18,6 +86,18 @@ Result reset_challenge(Challenge *challenge);
 
 Result change_name(Challenge *challenge, char *name);
 
+Result move_name(Challenge *challenge, Challenge *source);
+
+Result lend_name(Challenge *challenge, NameBlock *block, char *name);
+
+NameBlock *create_name_block(NameBlock **list, size_t size);
+
+void release_name_block(NameBlock *block);
+
+Result store_name(char **name, char *inline_name, char *new_name);
+
+void release_name(char **name, char *inline_name);
+
 Result set_best_time_of_challenge(Challenge *challenge, int time);
 
 Result best_time_of_challenge(Challenge *challenge, int *time);
@@ -26,5 +106,20 @@ Result inc_num_visits(Challenge *challenge);
 
 Result num_visits(Challenge *challenge, int *visits);
 
+Result offer_best_time_of_challenge(Challenge *challenge, int time);
+
+Result set_challenge_window_width(Challenge *challenge, int bucket_width);
+
+Result record_challenge_visit(Challenge *challenge, int time);
+
+Result record_challenge_completion(Challenge *challenge, int time,
+                                   int duration);
+
+Result challenge_window_stats(Challenge *challenge, int now, int window,
+                              int *visits, int *best_time);
+
+Result challenge_completion_percentile(Challenge *challenge, double percentile,
+                                       int *time);
+
 #endif // CHALLENGE_H_
 
@@ -8,11 +8,29 @@
 
 char *name;
 Challenge **challenges;
+ChallengeIndexEntry *challenge_index;
+ChallengeNameEntry *challenge_names;
+NameBlock *name_blocks;
 int challenge_array_size;
 int room_array_size;
 ChallengeRoom **rooms;
 int time_log;
-VisitorList *first_visitor;
+VisitorTable visitors;
+VisitorHandle dummy_visitor; //NO_VISITOR once all the visitors quit.
+TaskExecutor *executor;
+SnapshotDomain *snapshots;
+struct SSystemJournal *journal;
+RoomLoad *room_load; //NULL until visitor_arrive_any_room is first used.
+ChallengeRoom **draining_rooms; //retired by reload_system, still occupied.
+int num_draining_rooms;
+Challenge **retired_challenges; //released with the last draining room.
+int num_retired_challenges;
+ActivityGroups activity_groups; //empty until an all_visitors_quit on the
+                                //executor, and again after a reload.
+#ifdef CHALLENGE_SYSTEM_STATS
+SystemStats stats;
+LatencyHistogram latency[API_COUNT];
+#endif
 
 
 #endif // _H_
\ No newline at end of file
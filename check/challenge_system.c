@@ -3,47 +3,226 @@
 #include <stdbool.h>
 #include <string.h>
 #include <assert.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
 
 
 #include "challenge_system.h"
+#include "latency_histogram.h"
+#include "parallel_for.h"
+#include "system_journal.h"
 
 //Defines:
 #define MAX_LINE_LENGTH 51
 #define DUMMY "dummy_name"
 #define DUMMY_ID -1
 #define START_VALUE -2
+#define NO_CHALLENGE -1
 
 #define SYSTEM_HANDEL(error_code, result)  \
-   if (!(result)) {free (dummy); \
-                    free(name_copy); \
+   if (!(result)) {free(name_copy); \
                     free(*sys); \
                     fclose (system_file); \
                     return error_code;} \
 
 
+/* whitespace separated tokens of an init file, read in one go for the
+ * parallel loader.*/
+typedef struct SInitTokens
+{
+   char *buffer;
+   char **tokens;
+   int num_tokens;
+} InitTokens;
+
+/* first failure a loader chunk ran into, by record position*/
+typedef struct SLoadError
+{
+   int position;
+   Result result;
+   int heap_names; //names too long to be kept inline.
+} LoadError;
+
+/* shared state of the parallel challenge and room loaders*/
+typedef struct SSystemLoad
+{
+   ChallengeRoomSystem *sys;
+   char **tokens;
+   int first_challenge_token;
+   int *room_tokens; //first token of every room record.
+   LoadError *errors; //one per worker.
+} SystemLoad;
+
+/* winners of one chunk of the teardown reduction, as challenge positions*/
+typedef struct STeardownPartial
+{
+   int most_popular;
+   int best_time;
+   int visits;
+} TeardownPartial;
+
+/* shared state of the parallel teardown*/
+typedef struct SSystemTeardown
+{
+   ChallengeRoomSystem *sys;
+   TeardownPartial *partials; //one per worker.
+} SystemTeardown;
+
+/* shared state of a bulk operation over the rooms*/
+typedef struct SRoomsTask
+{
+   ChallengeRoomSystem *sys;
+   Level level;
+   int time;
+   int *places; //one per room, may be NULL.
+   int *totals; //one per worker.
+   OccupancyEntry *entries;
+   int capacity;
+} RoomsTask;
+
+/* how reload_system lays a freshly loaded system over the live one*/
+typedef struct SReloadPlan
+{
+   ChallengeRoomSystem *fresh;
+   Challenge **challenges; //the challenges after the reload, in file order.
+   int *kept_positions; //live position each one keeps, or NO_CHALLENGE.
+   bool *kept_challenges; //by live position.
+   ChallengeRoom **rooms; //the rooms after the reload, in file order.
+   ChallengeRoom **live_rooms; //the live rooms, sorted by name.
+   bool *kept_rooms; //by place in live rooms.
+} ReloadPlan;
+
+
 //Static functions list:
 static Result challenge_read(FILE* file, char* name, int* num_of_challenges,
                              ChallengeRoomSystem **sys);
 static Result room_read(FILE* file, char* name, ChallengeRoomSystem **sys,
-                        int challenges_arr_size, int* room_arr_size);
+                        int* room_arr_size);
 static Result set_challenges_in_array (FILE* file, int num_of_challenges,
                                        ChallengeRoomSystem **sys,
-                                       ChallengeRoom* room,
-                                       int challenge_arr_size);
+                                       ChallengeRoom* room);
+static Level resolve_level(int level);
+static Result build_challenge_index(ChallengeRoomSystem *sys);
+static int compare_index_entries(const void *first, const void *second);
+static Challenge *find_challenge_by_id(ChallengeRoomSystem *sys, int id);
+static int last_challenge_position(ChallengeRoomSystem *sys, int id);
+static int first_challenge_position(ChallengeRoomSystem *sys, int id);
+static int first_index_entry(ChallengeRoomSystem *sys, int id);
+static int compare_name_entries(const void *first, const void *second);
+static int find_name_entry(ChallengeRoomSystem *sys, char *name, int position);
+static void reposition_name_entry(ChallengeRoomSystem *sys, int entry);
+static Result rename_challenge_at(ChallengeRoomSystem *sys, int position,
+                                  char *new_name);
+static Result read_init_tokens(char *init_file, InitTokens *init);
+static bool parse_int(char *token, int *value);
+static void record_load_error(LoadError *error, int position, Result result);
+static Result first_load_error(LoadError *errors, int num_workers);
+static void load_challenges(void *context, int begin, int end, int worker);
+static void load_rooms(void *context, int begin, int end, int worker);
+static Result find_room_records(InitTokens *init, int first_token,
+                                int num_of_rooms, int *room_tokens);
+static void free_loaded_rooms(ChallengeRoomSystem *sys);
+static Result create_system_parallel_untimed(char *init_file,
+                                             ChallengeRoomSystem **sys,
+                                             int num_threads);
+static Result plan_reload_challenges(ChallengeRoomSystem *sys,
+                                     ReloadPlan *plan);
+static void plan_reload_rooms(ChallengeRoomSystem *sys, ReloadPlan *plan);
+static int compare_room_names(const void *first, const void *second);
+static Challenge *reloaded_challenge(ReloadPlan *plan, Challenge *challenge);
+static bool same_activities(ReloadPlan *plan, ChallengeRoom *live,
+                            ChallengeRoom *fresh);
+static void free_reload_plan(ReloadPlan *plan);
+static void release_system_shell(ChallengeRoomSystem *sys);
+static bool room_is_empty(ChallengeRoom *room);
+static void release_drained_room(ChallengeRoomSystem *sys,
+                                 ChallengeRoom *room);
+static void release_retired_challenges(ChallengeRoomSystem *sys);
+static Result quit_room_waiters(ChallengeRoomSystem *sys, ChallengeRoom *room,
+                                int quit_time);
+static size_t heap_name_size(char *name, char *inline_name);
+static void count_challenge_memory(Challenge *challenge, MemoryUsage *usage);
+static void count_room_memory(ChallengeRoom *room, MemoryUsage *usage);
+static size_t snapshot_size(SystemSnapshot *snapshot);
+static size_t executor_size(TaskExecutor *executor);
+static bool more_popular(Challenge *candidate, Challenge *current);
+static bool better_time(Challenge *candidate, Challenge *current);
+static void reduce_challenges(void *context, int begin, int end, int worker);
+static void release_rooms(void *context, int begin, int end, int worker);
+static void release_challenges(void *context, int begin, int end, int worker);
+static Result copy_challenge_name(Challenge *challenge, char **name);
+static Challenge *find_most_popular(ChallengeRoomSystem *sys);
+static Result run_on_rooms(ChallengeRoomSystem *sys, TaskBody body,
+                           void *context);
+static void count_free_places(void *context, int item, int worker);
+static void quit_room_visitors(void *context, int item, int worker);
+static void quit_challenge_visitors(void *context, int item, int worker);
+static Result group_activities(ChallengeRoomSystem *sys);
+static int compare_activity_challenges(const void *first, const void *second);
+static void release_activity_groups(ChallengeRoomSystem *sys);
+static void count_occupied(void *context, int item, int worker);
+static void fill_occupancy(void *context, int item, int worker);
+static int write_room_occupancy(ChallengeRoom *room, int room_index,
+                                OccupancyEntry *entries, int first,
+                                int capacity);
+static void note_system_change(ChallengeRoomSystem *sys);
+static Result build_snapshot(ChallengeRoomSystem *sys,
+                             SystemSnapshot **snapshot);
+static void release_snapshots(ChallengeRoomSystem *sys);
 static void free_allocated(void** array, int finish);
 static Result find_room(ChallengeRoomSystem *sys,char* room_name,
                         ChallengeRoom** room);
-static Result add_to_list(ChallengeRoomSystem *sys,Visitor *visitor);
-static  Result remove_from_list(ChallengeRoomSystem *sys, Visitor *visitor);
-static Result find_visitor_in_list(ChallengeRoomSystem *sys, Visitor *visitor,
-                                   VisitorList** pointer);
+static Result add_visitor(ChallengeRoomSystem *sys, char *visitor_name,
+                          int visitor_id, VisitorHandle *handle);
+static void remove_visitor(ChallengeRoomSystem *sys, VisitorHandle handle);
+static bool visitor_taken(ChallengeRoomSystem *sys, char *visitor_name,
+                          int visitor_id);
 static Result find_visitor_by_id(ChallengeRoomSystem *sys, int visitor_id,
-                                 Visitor** visitor);
+                                 VisitorHandle *handle);
+static Visitor *find_visitor_by_name(ChallengeRoomSystem *sys,
+                                     char *visitor_name);
 static Result find_challenge(ChallengeRoomSystem *sys, char* challenge_name,
                              Challenge** ptr);
-static Result create_list(Visitor *visitor, ChallengeRoomSystem *sys);
+static Result open_visitor_table(ChallengeRoomSystem *sys);
 static Result free_challenges(ChallengeRoomSystem *sys, char **best_time);
 static void free_challenges_memory(ChallengeRoomSystem *sys);
+static Result create_system_untimed(char *init_file,
+                                    ChallengeRoomSystem **sys);
+static Result visitor_arrive_untimed(ChallengeRoomSystem* sys, char* room_name,
+                                     char* visitor_name, int visitor_id,
+                                     Level level, int start_time,
+                                     bool *waiting);
+static Result visitor_arrive_any_room_untimed(ChallengeRoomSystem *sys,
+                                              char *visitor_name,
+                                              int visitor_id, Level level,
+                                              int start_time,
+                                              ChallengeRoom **room);
+static Result arrive_in_room(ChallengeRoomSystem *sys, ChallengeRoom *room,
+                             char *visitor_name, int visitor_id, Level level,
+                             int start_time, bool *waiting);
+static Result visitor_quit_untimed(ChallengeRoomSystem *sys, int visitor_id,
+                                   int quit_time);
+static void quit_visitor_at(ChallengeRoomSystem *sys, VisitorHandle handle,
+                            int quit_time);
+static Result all_visitors_quit_untimed(ChallengeRoomSystem *sys,
+                                        int quit_time);
+static Result system_room_of_visitor_untimed(ChallengeRoomSystem *sys,
+                                             char *visitor_name,
+                                             char **room_name);
+static Result change_challenge_name_untimed(ChallengeRoomSystem *sys,
+                                            int challenge_id, char *new_name);
+static Result change_challenge_names_untimed(ChallengeRoomSystem *sys,
+                                             ChallengeRename *renames,
+                                             int num_renames);
+static Result change_system_room_name_untimed(ChallengeRoomSystem *sys,
+                                              char *current_name,
+                                              char *new_name);
+static Result best_time_of_system_challenge_untimed(ChallengeRoomSystem *sys,
+                                                    char *challenge_name,
+                                                    int *time);
+static Result most_popular_challenge_untimed(ChallengeRoomSystem *sys,
+                                             char **challenge_name);
 
 
 //.h functions:
@@ -54,6 +233,15 @@ static void free_challenges_memory(ChallengeRoomSystem *sys);
  *              MEMORY_PROBLEM if system was unable to allocate memory.
  *              ILLEGAL_PARAMETER if the file is incorrect*/
 Result create_system(char *init_file, ChallengeRoomSystem **sys){
+    STATS_API_BEGIN();
+    Result result = create_system_untimed(init_file, sys);
+    if (result == OK)
+        STATS_API_END(*sys, API_CREATE_SYSTEM);
+    return result;
+}
+
+static Result create_system_untimed(char *init_file,
+                                    ChallengeRoomSystem **sys){
     if(sys == NULL)
         return NULL_PARAMETER;
     FILE* system_file = fopen(init_file, "r");
@@ -61,37 +249,138 @@ Result create_system(char *init_file, ChallengeRoomSystem **sys){
         printf("Error: cannot open system initiation file.\n");
         return ILLEGAL_PARAMETER;
     }
-    *sys = malloc(sizeof(ChallengeRoomSystem));
+    *sys = calloc(1, sizeof(ChallengeRoomSystem));
     if (!(*sys))
         return MEMORY_PROBLEM;
+    STATS_ADD(*sys, allocations, 1);
     char name[MAX_LINE_LENGTH];
     Result result;
-    Visitor* dummy = NULL;
     fscanf(system_file, "%s ", name);
     int num_of_challenges = START_VALUE, num_of_rooms = START_VALUE;
     char *name_copy = malloc((strlen(name)+1)* sizeof(char));
     SYSTEM_HANDEL(MEMORY_PROBLEM, name_copy);
-    dummy = malloc(sizeof( Visitor ));
-    SYSTEM_HANDEL(MEMORY_PROBLEM, dummy);
+    STATS_ADD(*sys, allocations, 1);
     strcpy(name_copy, name);
     (*sys)->name =  name_copy;
     result = challenge_read(system_file, name, &num_of_challenges, sys);
     SYSTEM_HANDEL(result , result == OK);
     (*sys)->challenge_array_size = num_of_challenges;
-    result = room_read(system_file, name, sys,
-                       num_of_challenges, &num_of_rooms);
+    result = build_challenge_index(*sys);
+    if (result != OK)
+        free_challenges_memory(*sys);
+    SYSTEM_HANDEL(result , result == OK);
+    result = room_read(system_file, name, sys, &num_of_rooms);
     SYSTEM_HANDEL(result , result == OK);
     (*sys)->room_array_size = num_of_rooms;
     (*sys)->time_log = 0;
-    (*sys)->first_visitor = malloc(sizeof(VisitorList));
-    result = init_visitor(dummy, DUMMY, DUMMY_ID);
-    SYSTEM_HANDEL(result , result == OK);
-    result = create_list(dummy, *sys);
+    result = open_visitor_table(*sys);
     SYSTEM_HANDEL(result , result == OK);
     fclose(system_file);
     return OK;
 }
 
+/*  Function initializes the system like create_system, but parses the
+ * challenge records and then the room records in parallel chunks. the file is
+ * read in one go and split on whitespace, so its records may be laid out the
+ * same way create_system accepts. when several records are bad, the error of
+ * the first one in the file is returned.
+ * Receives: **sys - return pointer. via it user gains access to initiated system.
+ *          init file - string. the name of the file with the init information.
+ *          num threads - number of threads to parse with, 1 parses in place.
+ * Error Codes: NULL_PARAMETER if system is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.
+ *              ILLEGAL_PARAMETER if the file is incorrect or num threads < 1*/
+Result create_system_parallel(char *init_file, ChallengeRoomSystem **sys,
+                              int num_threads){
+    STATS_API_BEGIN();
+    Result result = create_system_parallel_untimed(init_file, sys,
+                                                   num_threads);
+    if (result == OK)
+        STATS_API_END(*sys, API_CREATE_SYSTEM_PARALLEL);
+    return result;
+}
+
+static Result create_system_parallel_untimed(char *init_file,
+                                             ChallengeRoomSystem **sys,
+                                             int num_threads){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (num_threads < 1)
+        return ILLEGAL_PARAMETER;
+    InitTokens init;
+    Result result = read_init_tokens(init_file, &init);
+    if (result != OK)
+        return result;
+    int num_of_challenges, num_of_rooms;
+    if (init.num_tokens < 3 || !parse_int(init.tokens[1], &num_of_challenges)
+        || num_of_challenges < 0
+        || num_of_challenges > (init.num_tokens - 3) / 3
+        || !parse_int(init.tokens[2 + 3 * num_of_challenges], &num_of_rooms)
+        || num_of_rooms < 0 || num_of_rooms > init.num_tokens){
+        free(init.tokens);
+        free(init.buffer);
+        return ILLEGAL_PARAMETER;
+    }
+    ChallengeRoomSystem *new_sys = calloc(1, sizeof(ChallengeRoomSystem));
+    SystemLoad load = {new_sys, init.tokens, 2, NULL, NULL};
+    load.errors = malloc(sizeof(LoadError) * num_threads);
+    load.room_tokens = malloc(sizeof(int) * (num_of_rooms + 1));
+    if (new_sys)
+        new_sys->name = malloc(strlen(init.tokens[0]) + 1);
+    if (new_sys && new_sys->name && load.errors && load.room_tokens){
+        strcpy(new_sys->name, init.tokens[0]);
+        new_sys->challenges = calloc(num_of_challenges + 1,
+                                     sizeof(Challenge*));
+        new_sys->rooms = calloc(num_of_rooms + 1, sizeof(ChallengeRoom*));
+        result = new_sys->challenges && new_sys->rooms ? OK : MEMORY_PROBLEM;
+    }
+    else
+        result = MEMORY_PROBLEM;
+    if (result == OK){
+        new_sys->challenge_array_size = num_of_challenges;
+        new_sys->room_array_size = num_of_rooms;
+        STATS_ADD(new_sys, allocations, 4 + num_of_challenges);
+        for (int i = 0; i < num_threads; ++i) {
+            load.errors[i].position = INT_MAX;
+            load.errors[i].heap_names = 0;
+        }
+        result = parallel_for(num_of_challenges, num_threads,
+                              load_challenges, &load);
+    }
+    if (result == OK)
+        result = first_load_error(load.errors, num_threads);
+    if (result == OK)
+        result = build_challenge_index(new_sys);
+    if (result == OK)
+        result = find_room_records(&init, 3 + 3 * num_of_challenges,
+                                   num_of_rooms, load.room_tokens);
+    if (result == OK){
+        STATS_ADD(new_sys, allocations, 1 + 2 * num_of_rooms);
+        result = parallel_for(num_of_rooms, num_threads, load_rooms, &load);
+    }
+    if (result == OK)
+        result = first_load_error(load.errors, num_threads);
+    for (int i = 0; i < num_threads && result == OK; ++i)
+        STATS_ADD(new_sys, allocations, load.errors[i].heap_names);
+    if (result == OK)
+        result = open_visitor_table(new_sys);
+    free(load.room_tokens);
+    free(load.errors);
+    free(init.tokens);
+    free(init.buffer);
+    if (result != OK){
+        if (new_sys){
+            free_loaded_rooms(new_sys);
+            free_challenges_memory(new_sys);
+            free(new_sys->name);
+        }
+        free(new_sys);
+        return result;
+    }
+    *sys = new_sys;
+    return OK;
+}
+
 /*  Function deletes the system. frees all allocated space.
  * Receives: *sys - points to the relevent system to destroy.
  *          destroy time - the time to log as the finish system time.
@@ -110,24 +399,253 @@ Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
         return NULL_PARAMETER;
     if(destroy_time < sys->time_log)
         return ILLEGAL_TIME;
+    release_snapshots(sys);
     Result result = all_visitors_quit(sys, destroy_time);
     if (result != OK)
         return result;
-    free(sys->first_visitor);
+    close_system_journal(sys);
+    destroy_room_load(sys->room_load);
+    sys->room_load = NULL;
+    release_activity_groups(sys);
+    destroy_visitor_table(&sys->visitors);
     for (int i = 0; i < sys->room_array_size ; ++i) {
         result = reset_room(sys->rooms[i]);
         assert(result == OK); //already check that room != NULL.
         free((sys->rooms[i]));
     }
     free(sys->rooms); // finished releasing all room related memory.
+    free(sys->draining_rooms); //drained by the quits above.
     result = most_popular_challenge(sys, most_popular_challenge_p);
     if (result != OK)
         return result;
     result = free_challenges(sys, challenge_best_time);
     if (result != OK)
         return result;
+    if (sys->executor)
+        destroy_task_executor(sys->executor);
+    free(sys->name);
+    free(sys);
+    return OK;
+}
+
+/*  Function deletes the system like destroy_system, but releases the rooms
+ * and the challenges on num threads threads, and finds the most popular and
+ * best timed challenges with a parallel reduction. the visitors quit through
+ * all_visitors_quit, on the system executor when one is set.
+ * Receives: *sys - points to the relevent system to destroy.
+ *          destroy time - the time to log as the finish system time.
+ *          **most_popular_challenge_p, **challenge_best_time - return values
+ *                                  as in destroy_system.
+ *          num threads - number of threads to tear down with.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if num threads < 1
+ *              MEMORY_PROBLEM if system was unable to allocate memory.
+ *              ILLEGAL_TIME the given time is lesser than current system time*/
+Result destroy_system_parallel(ChallengeRoomSystem *sys, int destroy_time,
+                               char **most_popular_challenge_p,
+                               char **challenge_best_time, int num_threads){
+    if (!sys)
+        return NULL_PARAMETER;
+    if (num_threads < 1)
+        return ILLEGAL_PARAMETER;
+    if(destroy_time < sys->time_log)
+        return ILLEGAL_TIME;
+    SystemTeardown teardown = {sys, NULL};
+    teardown.partials = malloc(sizeof(TeardownPartial) * num_threads);
+    if (!teardown.partials)
+        return MEMORY_PROBLEM;
+    for (int i = 0; i < num_threads; ++i) {
+        teardown.partials[i].most_popular = NO_CHALLENGE;
+        teardown.partials[i].best_time = NO_CHALLENGE;
+        teardown.partials[i].visits = 0;
+    }
+    release_snapshots(sys);
+    Result result = all_visitors_quit(sys, destroy_time);
+    if (result == OK){
+        close_system_journal(sys);
+        destroy_room_load(sys->room_load);
+        sys->room_load = NULL;
+        release_activity_groups(sys);
+    }
+    if (result == OK)
+        result = parallel_for(sys->challenge_array_size, num_threads,
+                              reduce_challenges, &teardown);
+    Challenge *popular = NULL, *best = NULL;
+    int sum_of_visits = 0;
+    for (int i = 0; i < num_threads && result == OK; ++i) {
+        TeardownPartial *partial = &teardown.partials[i];
+        if (partial->most_popular == NO_CHALLENGE)
+            continue; //the chunk was empty.
+        sum_of_visits += partial->visits;
+        Challenge *candidate = sys->challenges[partial->most_popular];
+        if (!popular || more_popular(candidate, popular))
+            popular = candidate;
+        candidate = sys->challenges[partial->best_time];
+        if (!best || better_time(candidate, best))
+            best = candidate;
+    }
+    free(teardown.partials);
+    char *popular_name = NULL, *best_name = NULL;
+    if (result == OK && sum_of_visits)
+        result = copy_challenge_name(popular, &popular_name);
+    if (result == OK && best && best->best_time != 0)
+        result = copy_challenge_name(best, &best_name);
+    if (result != OK){
+        free(popular_name);
+        return result;
+    }
+    destroy_visitor_table(&sys->visitors);
+    parallel_for(sys->room_array_size, num_threads, release_rooms, sys);
+    free(sys->rooms);
+    free(sys->draining_rooms);
+    parallel_for(sys->challenge_array_size, num_threads,
+                 release_challenges, sys);
+    sys->challenge_array_size = 0; //the challenges themselves are released.
+    free_challenges_memory(sys);
+    if (sys->executor)
+        destroy_task_executor(sys->executor);
     free(sys->name);
     free(sys);
+    *most_popular_challenge_p = popular_name;
+    *challenge_best_time = best_name;
+    return OK;
+}
+
+/*  Function applies a changed init file to a running system. challenges whose
+ * id is still in the file are kept with their visits and best times, and take
+ * the name the file gives them. rooms that keep their name and the ids of
+ * their challenges are kept with their visitors. other rooms and challenges
+ * of the file are added. rooms that left the file, or changed, are retired:
+ * new visitors can't enter them, and they are released once their last
+ * visitor quits, together with the challenges that left the file.
+ * Receives: system pointer
+ *          init file - the name of the file with the new init information.
+ *          *report - return value counts what changed, may be NULL.
+ * Error Codes: NULL_PARAMETER if sys or init file is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.
+ *              ILLEGAL_PARAMETER if the file is incorrect, a kept challenge
+ *                                changed its level, or the system has a
+ *                                journal, which can't replay a reload. on
+ *                                any error the system is unchanged.*/
+Result reload_system(ChallengeRoomSystem *sys, char *init_file,
+                     ReloadReport *report){
+    if (sys == NULL || init_file == NULL)
+        return NULL_PARAMETER;
+    if (sys->journal)
+        return ILLEGAL_PARAMETER;
+    ReloadPlan plan = {NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+    Result result = create_system_parallel_untimed(init_file, &plan.fresh, 1);
+    if (result != OK)
+        return result;
+    ChallengeRoomSystem *fresh = plan.fresh;
+    result = plan_reload_challenges(sys, &plan);
+    if (result == OK){
+        plan.rooms = malloc(sizeof(ChallengeRoom*) *
+                            (fresh->room_array_size + 1));
+        plan.live_rooms = malloc(sizeof(ChallengeRoom*) *
+                                 (sys->room_array_size + 1));
+        plan.kept_rooms = calloc(sys->room_array_size + 1, sizeof(bool));
+        ChallengeRoom **draining = realloc(sys->draining_rooms,
+                sizeof(ChallengeRoom*) *
+                (sys->num_draining_rooms + sys->room_array_size + 1));
+        if (draining)
+            sys->draining_rooms = draining;
+        Challenge **retired = realloc(sys->retired_challenges,
+                sizeof(Challenge*) * (sys->num_retired_challenges +
+                                      sys->challenge_array_size + 1));
+        if (retired)
+            sys->retired_challenges = retired;
+        if (!plan.rooms || !plan.live_rooms || !plan.kept_rooms ||
+            !draining || !retired)
+            result = MEMORY_PROBLEM;
+    }
+    if (result == OK)
+        result = reserve_visitor_rooms(&sys->visitors,
+                                       fresh->room_array_size);
+    if (result != OK){
+        free_reload_plan(&plan);
+        return result;
+    }
+    plan_reload_rooms(sys, &plan);
+    //from here on nothing fails: the live system takes the new layout.
+    ReloadReport changes = {0, 0, 0, 0, 0};
+    for (int i = 0; i < fresh->challenge_array_size; ++i) {
+        int position = plan.kept_positions[i];
+        if (position == NO_CHALLENGE){
+            fresh->challenges[i] = NULL; //moved to the live system.
+            changes.added_challenges++;
+        }
+        //the fresh system allocated the new names already, they are moved.
+        else if (strcmp(sys->challenges[position]->name,
+                        fresh->challenges[i]->name) != 0)
+            move_name(sys->challenges[position], fresh->challenges[i]);
+    }
+    for (int i = 0; i < fresh->room_array_size; ++i) {
+        ChallengeRoom *room = plan.rooms[i];
+        if (room != fresh->rooms[i])
+            continue;
+        for (int j = 0; j < room->num_of_challenges; ++j)
+            room->challenges[j].challenge =
+                    reloaded_challenge(&plan, room->challenges[j].challenge);
+        remove_visitor_room(&fresh->visitors, room);
+        add_visitor_room(&sys->visitors, room);
+        fresh->rooms[i] = NULL;
+        changes.added_rooms++;
+    }
+    for (int i = 0; i < sys->room_array_size; ++i) {
+        ChallengeRoom *room = plan.live_rooms[i];
+        if (plan.kept_rooms[i])
+            continue;
+        changes.retired_rooms++;
+        if (room_is_empty(room)){
+            remove_visitor_room(&sys->visitors, room);
+            reset_room(room);
+            free(room);
+            continue;
+        }
+        room->retired = true;
+        sys->draining_rooms[sys->num_draining_rooms++] = room;
+        changes.draining_rooms++;
+    }
+    for (int i = 0; i < sys->challenge_array_size; ++i) {
+        if (plan.kept_challenges[i])
+            continue;
+        changes.retired_challenges++;
+        if (sys->num_draining_rooms > 0)
+            sys->retired_challenges[sys->num_retired_challenges++] =
+                    sys->challenges[i];
+        else {
+            reset_challenge(sys->challenges[i]);
+            free(sys->challenges[i]);
+        }
+    }
+    ChallengeNameEntry *names = fresh->challenge_names;
+    for (int i = 0; i < fresh->challenge_array_size; ++i)
+        names[i].challenge = plan.challenges[names[i].position];
+    free(sys->challenge_index);
+    free(sys->challenge_names);
+    sys->challenge_index = fresh->challenge_index;
+    sys->challenge_names = names;
+    fresh->challenge_index = NULL;
+    fresh->challenge_names = NULL;
+    free(sys->challenges);
+    sys->challenges = plan.challenges;
+    sys->challenge_array_size = fresh->challenge_array_size;
+    plan.challenges = NULL;
+    free(sys->rooms);
+    sys->rooms = plan.rooms;
+    sys->room_array_size = fresh->room_array_size;
+    plan.rooms = NULL;
+    destroy_room_load(sys->room_load); //room positions changed.
+    sys->room_load = NULL;
+    release_activity_groups(sys); //and so did their challenges.
+    char *name = sys->name;
+    sys->name = fresh->name;
+    fresh->name = name;
+    free_reload_plan(&plan);
+    if (report)
+        *report = changes;
+    note_system_change(sys);
     return OK;
 }
 
@@ -140,50 +658,165 @@ Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
  * Error Codes: NULL_PARAMETER if sys is NULL
  *              MEMORY_PROBLEM if system was unable to allocate memory.
  *              ILLEGAL_TIME the given time is lesser than current system time
- *              ILLEGAL_PARAMETER if the names are NULL or not found*/
+ *              ILLEGAL_PARAMETER if the names are NULL or not found, or too
+ *                                long for the journal of the system*/
 Result visitor_arrive(ChallengeRoomSystem* sys, char* room_name,
                       char* visitor_name, int visitor_id, Level level,
                       int start_time){
+    STATS_API_BEGIN();
+    Result result = visitor_arrive_untimed(sys, room_name, visitor_name,
+                                           visitor_id, level, start_time,
+                                           NULL);
+    STATS_API_END(sys, API_VISITOR_ARRIVE);
+    if (result == OK){
+        note_system_change(sys);
+        Event event = {EVENT_ARRIVE, level, visitor_id, start_time,
+                       room_name, visitor_name, 0, 0};
+        journal_system_change(sys, &event);
+    }
+    return result;
+}
+
+/*  Function is visitor_arrive for a visitor that would rather wait than leave
+ * when the room has no free challenge of the level. the visitor then waits in
+ * the room's queue of the level, and gets the first such challenge another
+ * visitor quits, at its quit time. a waiting visitor is in the system but in
+ * no room yet, and can quit the queue with visitor_quit.
+ * Receives: same as visitor_arrive
+ *          waiting - return value is true if the visitor waits in the queue.
+ * Error Codes: same as visitor_arrive, NULL_PARAMETER if waiting is NULL*/
+Result visitor_arrive_or_wait(ChallengeRoomSystem *sys, char *room_name,
+                              char *visitor_name, int visitor_id, Level level,
+                              int start_time, bool *waiting){
+    if (waiting == NULL)
+        return NULL_PARAMETER;
+    STATS_API_BEGIN();
+    Result result = visitor_arrive_untimed(sys, room_name, visitor_name,
+                                           visitor_id, level, start_time,
+                                           waiting);
+    STATS_API_END(sys, API_VISITOR_ARRIVE_OR_WAIT);
+    if (result == OK){
+        note_system_change(sys);
+        Event event = {EVENT_ARRIVE_OR_WAIT, level, visitor_id, start_time,
+                       room_name, visitor_name, 0, 0};
+        journal_system_change(sys, &event);
+    }
+    return result;
+}
+
+/*  Function seats the visitor in the named room. the visitor only waits when
+ * waiting is not NULL.*/
+static Result visitor_arrive_untimed(ChallengeRoomSystem* sys, char* room_name,
+                                     char* visitor_name, int visitor_id,
+                                     Level level, int start_time,
+                                     bool *waiting){
     if(sys==NULL)
         return NULL_PARAMETER;
     if( start_time< sys->time_log)
         return ILLEGAL_TIME;
-    if(room_name==NULL || visitor_name==NULL )
+    if(room_name==NULL || visitor_name==NULL ||
+       !journal_accepts_names(sys, room_name, visitor_name))
         return ILLEGAL_PARAMETER;
-    Visitor *visitor= malloc(sizeof(*visitor));
-    if(visitor==NULL)
-        return MEMORY_PROBLEM;
-    Result result= init_visitor(visitor,visitor_name,visitor_id);
-    if (result!=OK){
-        free(visitor);
-        return result;
-    }
     ChallengeRoom *room;
-    result=find_room(sys,room_name,&room);
-    if(result!=OK){
-        reset_visitor(visitor);
-        free(visitor);
+    Result result=find_room(sys,room_name,&room);
+    if(result!=OK)
         return result;
+    return arrive_in_room(sys, room, visitor_name, visitor_id, level,
+                          start_time, waiting);
+}
+
+/*  Function is visitor_arrive for a visitor that takes any room: it enters the
+ * room with the most free places of the level, without scanning the rooms.
+ * the places of the rooms are kept in heaps that are built on the first call
+ * and then follow every arrive and quit. rooms with as many free places are
+ * taken in the init file order. the arrival is journaled as a visitor_arrive
+ * to the chosen room.
+ * Receives: same as visitor_arrive, without the room name
+ *          room name - if not NULL, return value is the name of the chosen
+ *                      room, valid until the room is renamed.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.
+ *              ILLEGAL_TIME the given time is lesser than current system time
+ *              ILLEGAL_PARAMETER if the visitor name is NULL or too long
+ *                                for the journal of the system, or the
+ *                                level is illegal
+ *              NO_AVAILABLE_CHALLENGES if no room has a free place of the
+ *                                      level*/
+Result visitor_arrive_any_room(ChallengeRoomSystem *sys, char *visitor_name,
+                               int visitor_id, Level level, int start_time,
+                               const char **room_name){
+    STATS_API_BEGIN();
+    ChallengeRoom *room = NULL;
+    Result result = visitor_arrive_any_room_untimed(sys, visitor_name,
+                                                    visitor_id, level,
+                                                    start_time, &room);
+    STATS_API_END(sys, API_VISITOR_ARRIVE_ANY_ROOM);
+    if (result == OK){
+        note_system_change(sys);
+        Event event = {EVENT_ARRIVE, level, visitor_id, start_time,
+                       room->name, visitor_name, 0, 0};
+        journal_system_change(sys, &event);
+        if (room_name != NULL)
+            *room_name = room->name;
     }
-    result=add_to_list(sys, visitor);
-    if(result!= OK){
-        reset_visitor(visitor);
-        free(visitor);
-        return result;
+    return result;
+}
+
+static Result visitor_arrive_any_room_untimed(ChallengeRoomSystem *sys,
+                                              char *visitor_name,
+                                              int visitor_id, Level level,
+                                              int start_time,
+                                              ChallengeRoom **room){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (start_time < sys->time_log)
+        return ILLEGAL_TIME;
+    if (visitor_name == NULL || (unsigned)level > All_Levels ||
+        !journal_accepts_names(sys, visitor_name, NULL))
+        return ILLEGAL_PARAMETER;
+    if (sys->room_load == NULL){
+        Result result = create_room_load(sys->rooms, sys->room_array_size,
+                                         &sys->room_load);
+        if (result != OK)
+            return result;
+        STATS_ADD(sys, allocations, All_Levels + 2);
     }
+    *room = least_loaded_room(sys->room_load, level);
+    if (*room == NULL)
+        return NO_AVAILABLE_CHALLENGES;
+    return arrive_in_room(sys, *room, visitor_name, visitor_id, level,
+                          start_time, NULL);
+}
+
+/*  Function creates the arriving visitor and puts it in the room, or in the
+ * room's queue when waiting is not NULL and the room has no free place.*/
+static Result arrive_in_room(ChallengeRoomSystem *sys, ChallengeRoom *room,
+                             char *visitor_name, int visitor_id, Level level,
+                             int start_time, bool *waiting){
+    if (visitor_name == NULL)
+        return NULL_PARAMETER;
+    VisitorHandle handle;
+    Result result=add_visitor(sys, visitor_name, visitor_id, &handle);
+    if(result!= OK)
+        return result;
+    Visitor *visitor = VISITOR_RECORD(&sys->visitors, handle);
     result=visitor_enter_room(room , visitor , level , start_time);
+    if (waiting != NULL){
+        *waiting = (result == NO_AVAILABLE_CHALLENGES);
+        if (*waiting)
+            result = visitor_wait_in_room(&sys->visitors, room, handle,
+                                          level);
+    }
     if (result!=OK){
-        remove_from_list(sys, visitor);
-        reset_visitor(visitor);
-        free(visitor);
+        remove_visitor(sys, handle);
         return result;
     }
+    update_room_load(sys->room_load, room);
     sys->time_log= start_time; //update system time
     return OK;
-
 }
 
-/*  Function removes the given visitor from linked list. updates relevant system
+/*  Function removes the given visitor from the system. updates relevant system
  *          parameters.
  * Receives: system type pointer - to gain access to the relevant system list.
  *          visitor id - to identify the specific visitor
@@ -191,28 +824,48 @@ Result visitor_arrive(ChallengeRoomSystem* sys, char* room_name,
  * Error Codes: NULL_PARAMETER if sys is NULL
  *              ILLEGAL_TIME the given time is lesser than current system time*/
 Result visitor_quit(ChallengeRoomSystem *sys, int visitor_id, int quit_time){
+    STATS_API_BEGIN();
+    Result result = visitor_quit_untimed(sys, visitor_id, quit_time);
+    STATS_API_END(sys, API_VISITOR_QUIT);
+    if (result == OK){
+        note_system_change(sys);
+        Event event = {EVENT_QUIT, All_Levels, visitor_id, quit_time,
+                       NULL, NULL, 0, 0};
+        journal_system_change(sys, &event);
+    }
+    return result;
+}
+
+static Result visitor_quit_untimed(ChallengeRoomSystem *sys, int visitor_id,
+                                   int quit_time){
     if(sys==NULL)
         return NULL_PARAMETER;
     if (quit_time< sys->time_log)
         return ILLEGAL_TIME;
-    Visitor *ptr_visitor = NULL;
-    Result res=find_visitor_by_id(sys,visitor_id,&ptr_visitor);
+    VisitorHandle handle;
+    Result res=find_visitor_by_id(sys,visitor_id,&handle);
     if (res!=OK ){
         return res;
     }
-    assert(ptr_visitor!=NULL);
-    res=remove_from_list(sys,ptr_visitor);
-    if (res!=OK)
-        return res;
     sys->time_log= quit_time;
-    visitor_quit_room(ptr_visitor,quit_time);
-    reset_visitor(ptr_visitor);
-    free(ptr_visitor);
+    quit_visitor_at(sys, handle, quit_time);
     return OK;
 
 }
 
-/*  Function removes all the entities from the visitor list in a given system.
+/*  Function takes the visitor of a handle out of its room and the system.*/
+static void quit_visitor_at(ChallengeRoomSystem *sys, VisitorHandle handle,
+                            int quit_time){
+    Visitor *visitor = VISITOR_RECORD(&sys->visitors, handle);
+    ChallengeRoom *room = visitor->room == NO_ROOM ? NULL :
+                          VISITOR_ROOM(&sys->visitors, visitor);
+    visitor_quit_room(&sys->visitors, visitor, quit_time);
+    update_room_load(sys->room_load, room);
+    remove_visitor(sys, handle);
+    release_drained_room(sys, room);
+}
+
+/*  Function removes all the entities from the visitor table of a given system.
  *           logs in the action time into the system time log.
  * Receives: system type pointer - to gain access to the relevant system list.
  *          quit time - to log into the system time log.
@@ -220,6 +873,20 @@ Result visitor_quit(ChallengeRoomSystem *sys, int visitor_id, int quit_time){
  *              MEMORY_PROBLEM if system was unable to allocate memory.
  *              ILLEGAL_TIME the given time is lesser than current system time*/
 Result all_visitors_quit(ChallengeRoomSystem *sys, int quit_time){
+    STATS_API_BEGIN();
+    Result result = all_visitors_quit_untimed(sys, quit_time);
+    STATS_API_END(sys, API_ALL_VISITORS_QUIT);
+    if (result == OK){
+        note_system_change(sys);
+        Event event = {EVENT_ALL_QUIT, All_Levels, 0, quit_time,
+                       NULL, NULL, 0, 0};
+        journal_system_change(sys, &event);
+    }
+    return result;
+}
+
+static Result all_visitors_quit_untimed(ChallengeRoomSystem *sys,
+                                        int quit_time){
     if(sys == NULL){
         return NULL_PARAMETER;
     }
@@ -227,22 +894,50 @@ Result all_visitors_quit(ChallengeRoomSystem *sys, int quit_time){
         return ILLEGAL_TIME;
     }
     Result result = OK;
-    VisitorList *curr_visitor= NULL;
-    if ((*sys->first_visitor) != NULL ){
-        curr_visitor = sys->first_visitor;
-    }
-    while (curr_visitor){
-        result = visitor_quit(sys,
-                              (*curr_visitor)->visitor->visitor_id, quit_time);
-        //removes visitor entity from list
+    if (sys->executor){
+        //every challenge is recorded on one thread, then the rooms empty.
+        RoomsTask task = {sys, All_Levels, quit_time, NULL, NULL, NULL, 0};
+        result = group_activities(sys);
+        if (result == OK)
+            result = run_tasks(sys->executor,
+                               sys->activity_groups.num_groups,
+                               quit_challenge_visitors, &task);
+        if (result == OK)
+            result = run_on_rooms(sys, quit_room_visitors, &task);
         if (result != OK)
             return result;
-        if ((*sys->first_visitor) != NULL){
-            curr_visitor = sys->first_visitor;
-        }
-        else {
-            break;
+        for (int i = 0; i < sys->num_draining_rooms; ++i) {
+            room_visitors_quit(&sys->visitors, sys->draining_rooms[i],
+                               quit_time);
+            remove_visitor_room(&sys->visitors, sys->draining_rooms[i]);
+            reset_room(sys->draining_rooms[i]);
+            free(sys->draining_rooms[i]);
         }
+        sys->num_draining_rooms = 0;
+        release_retired_challenges(sys);
+        rebuild_room_load(sys->room_load);
+        clear_visitor_table(&sys->visitors);
+        sys->dummy_visitor = NO_VISITOR;
+        sys->time_log = quit_time;
+        return OK;
+    }
+    //waiting visitors leave first, so no challenge is handed to them.
+    for (int i = 0; i < sys->room_array_size; ++i){
+        result = quit_room_waiters(sys, sys->rooms[i], quit_time);
+        if (result != OK)
+            return result;
+    }
+    //a drained room leaves its place to the last one, visited already.
+    for (int i = sys->num_draining_rooms - 1; i >= 0; --i){
+        result = quit_room_waiters(sys, sys->draining_rooms[i], quit_time);
+        if (result != OK)
+            return result;
+    }
+    //the visitors only leave the table, so every record is visited once.
+    VisitorTable *table = &sys->visitors;
+    for (VisitorHandle handle = 0; handle < table->num_records; ++handle){
+        if (VISITOR_IN_USE(VISITOR_RECORD(table, handle)))
+            quit_visitor_at(sys, handle, quit_time);
     }
     sys->time_log = quit_time;
     return OK;
@@ -258,30 +953,49 @@ Result all_visitors_quit(ChallengeRoomSystem *sys, int quit_time){
  *              NOT_IN_ROOM if the visitor isn't in the system*/
 Result system_room_of_visitor(ChallengeRoomSystem *sys, char *visitor_name,
                               char **room_name) {
+    STATS_API_BEGIN();
+    Result result = system_room_of_visitor_untimed(sys, visitor_name,
+                                                   room_name);
+    STATS_API_END(sys, API_SYSTEM_ROOM_OF_VISITOR);
+    return result;
+}
+
+static Result system_room_of_visitor_untimed(ChallengeRoomSystem *sys,
+                                             char *visitor_name,
+                                             char **room_name) {
     if (sys == NULL)
         return NULL_PARAMETER;
     if (!visitor_name || !room_name)
         return ILLEGAL_PARAMETER;
-    VisitorList *visitor_ptr = NULL;
-    visitor_ptr = sys->first_visitor;
-    bool found = false;
-    Result res = OK;
-    while (visitor_ptr) {
-        if (strcmp((*visitor_ptr)->visitor->visitor_name, visitor_name) == 0) {
-            assert(sys && visitor_name);
-            res = room_of_visitor((*visitor_ptr)->visitor, room_name);
-            found = true;
-        }
-        if((*visitor_ptr)->next_visitor != NULL){
-            visitor_ptr = &((*visitor_ptr)->next_visitor);
-        }
-        else{
-            break;
-        }
-    }
-    if (found)
-        return res;
-    return NOT_IN_ROOM;
+    Visitor *visitor = find_visitor_by_name(sys, visitor_name);
+    if (visitor == NULL)
+        return NOT_IN_ROOM;
+    Result res = room_of_visitor(&sys->visitors, visitor, room_name);
+    STATS_ADD(sys, allocations, res == OK);
+    return res;
+}
+
+/*  Function finds a given visitor in the system, like system_room_of_visitor,
+ * but lends the name of the visitor's room instead of copying it.
+ * Receives: system type pointer - to gain access to the relevant system to search.
+ *          visitor name - to identify the specific visitor
+ *          room name - return value is the visitor's room. it stays valid
+ *                      until the system changes.
+ *          length - return value is the length of the room name. may be NULL.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if visitor name or room name is NULL
+ *              NOT_IN_ROOM if the visitor isn't in the system*/
+Result system_room_of_visitor_view(ChallengeRoomSystem *sys,
+                                   char *visitor_name,
+                                   const char **room_name, int *length){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (!visitor_name || !room_name)
+        return ILLEGAL_PARAMETER;
+    Visitor *visitor = find_visitor_by_name(sys, visitor_name);
+    if (visitor == NULL)
+        return NOT_IN_ROOM;
+    return room_of_visitor_view(&sys->visitors, visitor, room_name, length);
 }
 
 /*  Function changes a given system challenge's name.
@@ -290,32 +1004,142 @@ Result system_room_of_visitor(ChallengeRoomSystem *sys, char *visitor_name,
  *          new name - once the challenge is found, it's name is changed to parameter.
  * Error Codes: NULL_PARAMETER if sys or new name is NULL
  *              MEMORY_PROBLEM if system was unable to allocate memory.
- *              ILLEGAL_PARAMETER the give id isn't in the system*/
+ *              ILLEGAL_PARAMETER the give id isn't in the system, or the new
+ *                                name is too long for the journal of the
+ *                                system*/
 Result change_challenge_name(ChallengeRoomSystem *sys, int challenge_id, char *new_name){
+    STATS_API_BEGIN();
+    Result result = change_challenge_name_untimed(sys, challenge_id, new_name);
+    STATS_API_END(sys, API_CHANGE_CHALLENGE_NAME);
+    if (result == OK){
+        note_system_change(sys);
+        Event event = {EVENT_RENAME_CHALLENGE, All_Levels, challenge_id, 0,
+                       new_name, NULL, 0, 0};
+        journal_system_change(sys, &event);
+    }
+    return result;
+}
+
+static Result change_challenge_name_untimed(ChallengeRoomSystem *sys,
+                                            int challenge_id, char *new_name){
     if (!sys || !new_name)
         return NULL_PARAMETER;
-    bool found = false;
-    Result res = OK;
-    for (int i = 0; (i < sys->challenge_array_size && !found) ; ++i) {
-        if(sys->challenges[i]->id == challenge_id){
-            found = true;
-            res = change_name(sys->challenges[i], new_name);
+    if (!journal_accepts_names(sys, new_name, NULL))
+        return ILLEGAL_PARAMETER;
+    int position = first_challenge_position(sys, challenge_id);
+    if (position == NO_CHALLENGE){
+        return ILLEGAL_PARAMETER; //could not find challenge ID in system.
+    }
+    return rename_challenge_at(sys, position, new_name);
+}
+
+/*  Function renames many challenges at once, as if change_challenge_name was
+ * called for every pair in order. the ids are found through the id index,
+ * the names too long to be kept inline are allocated together in one block,
+ * and the name order is sorted once at the end. nothing is renamed unless
+ * every pair is legal. the block is released once every challenge it lent a
+ * name to is renamed again or removed.
+ * Receives: system type pointer - to gain access to the relevant system list.
+ *          renames - the (challenge id, new name) pairs.
+ *          num renames - number of pairs.
+ * Error Codes: NULL_PARAMETER if sys, renames or a new name is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.
+ *              ILLEGAL_PARAMETER if an id isn't in the system, a new name
+ *                                is too long for the journal of the
+ *                                system or num renames is negative*/
+Result change_challenge_names(ChallengeRoomSystem *sys,
+                              ChallengeRename *renames, int num_renames){
+    STATS_API_BEGIN();
+    Result result = change_challenge_names_untimed(sys, renames, num_renames);
+    STATS_API_END(sys, API_CHANGE_CHALLENGE_NAMES);
+    if (result == OK && num_renames > 0){
+        note_system_change(sys);
+        for (int i = 0; i < num_renames; ++i) {
+            Event event = {EVENT_RENAME_CHALLENGE, All_Levels,
+                           renames[i].challenge_id, 0, renames[i].new_name,
+                           NULL, 0, 0};
+            journal_system_change(sys, &event);
         }
     }
-    if (!found){
-        return ILLEGAL_PARAMETER; //could not find challenge ID in system.
+    return result;
+}
+
+static Result change_challenge_names_untimed(ChallengeRoomSystem *sys,
+                                             ChallengeRename *renames,
+                                             int num_renames){
+    if (!sys || (!renames && num_renames > 0))
+        return NULL_PARAMETER;
+    if (num_renames < 0)
+        return ILLEGAL_PARAMETER;
+    size_t block_size = 0;
+    for (int i = 0; i < num_renames; ++i) {
+        if (!renames[i].new_name)
+            return NULL_PARAMETER;
+        if (first_challenge_position(sys, renames[i].challenge_id) ==
+            NO_CHALLENGE || !journal_accepts_names(sys, renames[i].new_name,
+                                                   NULL))
+            return ILLEGAL_PARAMETER;
+        size_t length = strlen(renames[i].new_name);
+        if (length >= NAME_INLINE_SIZE)
+            block_size += length + 1;
     }
-    return res;
+    NameBlock *block = NULL;
+    char *next_name = NULL;
+    if (block_size > 0){
+        block = create_name_block(&sys->name_blocks, block_size);
+        if (!block)
+            return MEMORY_PROBLEM;
+        STATS_ADD(sys, allocations, 1);
+        next_name = block->names;
+    }
+    for (int i = 0; i < num_renames; ++i) {
+        Challenge *challenge = sys->challenges[
+                first_challenge_position(sys, renames[i].challenge_id)];
+        size_t length = strlen(renames[i].new_name);
+        if (length < NAME_INLINE_SIZE){
+            change_name(challenge, renames[i].new_name); //inline, can't fail.
+            continue;
+        }
+        memcpy(next_name, renames[i].new_name, length + 1);
+        lend_name(challenge, block, next_name);
+        next_name += length + 1;
+    }
+    //freed here if later pairs renamed every challenge the block lent to.
+    release_name_block(block);
+    if (num_renames > 0)
+        qsort(sys->challenge_names, sys->challenge_array_size,
+              sizeof(*sys->challenge_names), compare_name_entries);
+    return OK;
 }
 
 /*  Function changes a given system room's name.
  * Receives: system type pointer - to gain access to the relevant system list.
  *          current name - to identify the specific room in the system.
  *          new name - once the room is found, it's name is changed to parameter.
- * Error Codes: NULL_PARAMETER if sys, new name or current name is NULL*/
+ * Error Codes: NULL_PARAMETER if sys, new name or current name is NULL
+ *              ILLEGAL_PARAMETER if a name is too long for the journal of
+ *                                the system*/
 Result change_system_room_name(ChallengeRoomSystem *sys, char *current_name, char *new_name) {
+    STATS_API_BEGIN();
+    Result result = change_system_room_name_untimed(sys, current_name,
+                                                    new_name);
+    STATS_API_END(sys, API_CHANGE_SYSTEM_ROOM_NAME);
+    if (result == OK){
+        note_system_change(sys);
+        Event event = {EVENT_RENAME_ROOM, All_Levels, 0, 0, current_name,
+                       new_name, 0, 0};
+        journal_system_change(sys, &event);
+    }
+    return result;
+}
+
+static Result change_system_room_name_untimed(ChallengeRoomSystem *sys,
+                                              char *current_name,
+                                              char *new_name) {
     if (sys==NULL || current_name==NULL || new_name== NULL)
         return NULL_PARAMETER;
+    if (!journal_accepts_names(sys, current_name, new_name))
+        return ILLEGAL_PARAMETER;
     ChallengeRoom* room;
     Result result=find_room(sys,current_name,&room);
     if(result!=OK)
@@ -324,6 +1148,7 @@ Result change_system_room_name(ChallengeRoomSystem *sys, char *current_name, cha
     if (result!=OK){
         return result;
     }
+    STATS_ADD(sys, allocations, NAME_ON_HEAP(room->name, room->inline_name));
     return OK;
 }
 
@@ -333,6 +1158,16 @@ Result change_system_room_name(ChallengeRoomSystem *sys, char *current_name, cha
  *          time - return value is the challenge best time.
  * Error Codes: NULL_PARAMETER if sys or challenge name is NULL*/
 Result best_time_of_system_challenge(ChallengeRoomSystem *sys, char *challenge_name, int *time){
+    STATS_API_BEGIN();
+    Result result = best_time_of_system_challenge_untimed(sys, challenge_name,
+                                                          time);
+    STATS_API_END(sys, API_BEST_TIME_OF_SYSTEM_CHALLENGE);
+    return result;
+}
+
+static Result best_time_of_system_challenge_untimed(ChallengeRoomSystem *sys,
+                                                    char *challenge_name,
+                                                    int *time){
     if(sys ==NULL || challenge_name==NULL)
         return NULL_PARAMETER;
     Challenge *ptr=NULL;
@@ -351,105 +1186,716 @@ Result best_time_of_system_challenge(ChallengeRoomSystem *sys, char *challenge_n
  * Error Codes: NULL_PARAMETER if sys is NULL
  *              MEMORY_PROBLEM if system was unable to allocate memory.*/
 Result most_popular_challenge(ChallengeRoomSystem *sys, char **challenge_name){
+    STATS_API_BEGIN();
+    Result result = most_popular_challenge_untimed(sys, challenge_name);
+    STATS_API_END(sys, API_MOST_POPULAR_CHALLENGE);
+    return result;
+}
+
+static Result most_popular_challenge_untimed(ChallengeRoomSystem *sys,
+                                             char **challenge_name){
     if(!sys)
         return NULL_PARAMETER;
-    if(sys->challenge_array_size == 0){
-        *challenge_name = NULL;
-        return OK;
-    }
-    int max_visitor_for_challenge, curr_challenge_visits_num, sum_of_visits=0;
-    Result res = num_visits(sys->challenges[0], &max_visitor_for_challenge);
-    assert(res == OK);
-    char* challenge_name_ptr = sys->challenges[0]->name;
-    for (int i = 1; i <sys->challenge_array_size && res == OK; ++i) {
-        res = num_visits(sys->challenges[i], &curr_challenge_visits_num);
-        assert(res == OK);
-        sum_of_visits+=curr_challenge_visits_num;
-        if(curr_challenge_visits_num >= max_visitor_for_challenge){
-            if (curr_challenge_visits_num == max_visitor_for_challenge){
-                if (strcmp(sys->challenges[i]->name, challenge_name_ptr) < 0)
-                    challenge_name_ptr = sys->challenges[i]->name;
-            }
-            else
-                challenge_name_ptr = sys->challenges[i]->name;
-        }
-    }
-    if (!sum_of_visits){
+    Challenge *popular = find_most_popular(sys);
+    if (!popular){
         *challenge_name=NULL;
         return OK;
     }
-    char* temp = malloc((strlen(challenge_name_ptr)+1)* sizeof(char));
-    if(!temp)
-        return MEMORY_PROBLEM;
-    strcpy(temp, challenge_name_ptr);
-    *challenge_name = temp;
+    Result result = copy_challenge_name(popular, challenge_name);
+    if (result == OK)
+        STATS_ADD(sys, allocations, 1);
+    return result;
+}
+
+/*  Function retrieves the system challenge that has the most visitors, like
+ * most_popular_challenge, but lends its name instead of copying it.
+ * Receives: system type pointer - to gain access to the relevant system list.
+ *          challenge name - return value is the name of the most popular
+ *                           challenge, or NULL if no challenge was visited.
+ *                           it stays valid until the system changes.
+ *          length - return value is the length of the name. may be NULL.
+ * Error Codes: NULL_PARAMETER if sys or challenge name is NULL*/
+Result most_popular_challenge_view(ChallengeRoomSystem *sys,
+                                   const char **challenge_name, int *length){
+    if (!sys || !challenge_name)
+        return NULL_PARAMETER;
+    Challenge *popular = find_most_popular(sys);
+    *challenge_name = popular ? popular->name : NULL;
+    if (length)
+        *length = popular ? (int)strlen(popular->name) : 0;
     return OK;
 }
 
-//static functions
+/*  Function sets the period length of the recent activity windows of every
+ * challenge, and forgets the activity recorded in them so far.
+ * Receives: system type pointer - the system to configure.
+ *          bucket width - the period length in time units.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if bucket width isn't positive*/
+Result set_system_window_width(ChallengeRoomSystem *sys, int bucket_width){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (bucket_width <= 0)
+        return ILLEGAL_PARAMETER;
+    for (int i = 0; i < sys->challenge_array_size; ++i)
+        set_challenge_window_width(sys->challenges[i], bucket_width);
+    return OK;
+}
 
-/*  Function reads from initiation file the parameters for the system challenge
- * array and sets it.
- * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
-static Result challenge_read(FILE* file, char* name, int* num_of_challenges,
-                             ChallengeRoomSystem **sys){
-    int challenge_id, level;
-    fscanf(file, "%d ", num_of_challenges);
-    Result result;
-    Challenge** challenge_array = malloc((*num_of_challenges)*
-                                         sizeof(Challenge*));
-    if (challenge_array == NULL)
-        return MEMORY_PROBLEM; //unable to allocate array size.
-    for (int i=0; i<(*num_of_challenges); i++){
-        fscanf(file, "%s %d %d ", name, &challenge_id, &level);
-        Level resolved = Easy;
-        switch (level){
-            case 1: resolved = Easy;
-                break;
-            case 2: resolved = Medium;
-                break;
-            case 3: resolved = Hard;
-                break;
-            default: resolved = All_Levels;
-                break;
-        }
-        Challenge *curr_challenge = malloc(sizeof(Challenge));
-        if (curr_challenge == NULL) {
-            free_allocated((void**)challenge_array, i);
-            return MEMORY_PROBLEM;
-        }
-        challenge_array[i] = curr_challenge;
-        result = init_challenge(curr_challenge, challenge_id, name, resolved);
-        if (result != OK) {
-            free_allocated((void **) challenge_array, i);
-            free(curr_challenge);
-            return result;
+/*  Function retrieves the challenge with the most visits that started in the
+ * last window time units, the smallest name breaking ties.
+ * Receives: system type pointer - to gain access to the relevant system list.
+ *          window - the window length in time units, counted in whole
+ *                   periods back from the system time.
+ *          challenge name - return value is the most popular challenge of the
+ *                           window, or NULL if it had no visits.
+ * Error Codes: NULL_PARAMETER if sys or challenge name is NULL
+ *              ILLEGAL_PARAMETER if window isn't positive
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result most_popular_challenge_in_window(ChallengeRoomSystem *sys, int window,
+                                        char **challenge_name){
+    if (!sys || !challenge_name)
+        return NULL_PARAMETER;
+    if (window <= 0)
+        return ILLEGAL_PARAMETER;
+    Challenge *popular = NULL;
+    int most_visits = 0;
+    for (int i = 0; i < sys->challenge_array_size; ++i) {
+        int visits, best_time;
+        challenge_window_stats(sys->challenges[i], sys->time_log, window,
+                               &visits, &best_time);
+        if (visits == 0 || visits < most_visits)
+            continue;
+        if (visits > most_visits ||
+            strcmp(sys->challenges[i]->name, popular->name) < 0){
+            popular = sys->challenges[i];
+            most_visits = visits;
         }
     }
-    (*sys)->challenges = challenge_array;
-    return OK;
+    *challenge_name = NULL;
+    if (!popular)
+        return OK;
+    return copy_challenge_name(popular, challenge_name);
 }
 
-/*  Function reads from initiation file the parameters for the system room array
- * and sets it.
- * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
-static Result room_read(FILE* file, char* name, ChallengeRoomSystem **sys,
-                        int challenges_arr_size, int* room_arr_size){
-    int num_of_rooms, num_of_challenges;
-    fscanf(file, "%d", &num_of_rooms);
-    *room_arr_size = num_of_rooms;
-    Result result;
-    ChallengeRoom** room_array = malloc(sizeof(*room_array)*num_of_rooms);
-    if (room_array == NULL)
-        return MEMORY_PROBLEM;
-    ChallengeRoom *curr_room = NULL;
-    for (int i=0; i<num_of_rooms; i++){
-        curr_room = malloc(sizeof(ChallengeRoom));
-        if (curr_room == NULL) {
-            free_allocated((void**)room_array, i);
-            free_challenges_memory((*sys));
-            return MEMORY_PROBLEM;
-        }
+/*  Function retrieves the best time of a challenge among the visitors that
+ * quit it in the last window time units.
+ * Receives: system type pointer - to gain access to the relevant system list.
+ *          challenge name - to identify the specific challenge.
+ *          window - the window length in time units, counted in whole
+ *                   periods back from the system time.
+ *          time - return value is the best time of the window, 0 if none.
+ * Error Codes: NULL_PARAMETER if sys, challenge name or time is NULL
+ *              ILLEGAL_PARAMETER if the challenge isn't in the system or
+ *                                window isn't positive*/
+Result best_time_of_system_challenge_in_window(ChallengeRoomSystem *sys,
+                                               char *challenge_name,
+                                               int window, int *time){
+    if (!sys || !challenge_name || !time)
+        return NULL_PARAMETER;
+    Challenge *challenge = NULL;
+    Result result = find_challenge(sys, challenge_name, &challenge);
+    if (result != OK)
+        return result;
+    int visits;
+    return challenge_window_stats(challenge, sys->time_log, window, &visits,
+                                  time);
+}
+
+/*  Function estimates a percentile of the times visitors spent in a
+ * challenge, e.g. 50 for the median or 90 for p90.
+ * Receives: system type pointer - to gain access to the relevant system list.
+ *          challenge name - to identify the specific challenge.
+ *          percentile - the percentile wanted, between 0 and 100.
+ *          time - return value is the estimate, 0 if no visitor completed
+ *                 the challenge yet.
+ * Error Codes: NULL_PARAMETER if sys, challenge name or time is NULL
+ *              ILLEGAL_PARAMETER if the challenge isn't in the system or
+ *                                percentile is out of range*/
+Result completion_time_percentile(ChallengeRoomSystem *sys,
+                                  char *challenge_name, double percentile,
+                                  int *time){
+    if (!sys || !challenge_name || !time)
+        return NULL_PARAMETER;
+    Challenge *challenge = NULL;
+    Result result = find_challenge(sys, challenge_name, &challenge);
+    if (result != OK)
+        return result;
+    return challenge_completion_percentile(challenge, percentile, time);
+}
+
+/*  Function predicts the arrivals to a room and how soon a place of a level
+ * frees up in it, as room_forecast does. the averages behind it follow every
+ * arrive and quit at O(1), so they are always on.
+ * Receives: system type pointer - to gain access to the relevant system list.
+ *          room name - to identify the specific room.
+ *          level - the level a new visitor would ask for.
+ *          forecast - return value is the prediction.
+ * Error Codes: NULL_PARAMETER if sys, room name or forecast is NULL
+ *              ILLEGAL_PARAMETER if the room isn't in the system or the
+ *                                level is unknown*/
+Result system_room_forecast(ChallengeRoomSystem *sys, char *room_name,
+                            Level level, RoomForecast *forecast){
+    if (!sys || !room_name || !forecast)
+        return NULL_PARAMETER;
+    ChallengeRoom *room = NULL;
+    Result result = find_room(sys, room_name, &room);
+    if (result != OK)
+        return result;
+    return room_forecast(room, level, forecast);
+}
+
+/*  Function gives the system a work stealing executor of num workers workers.
+ * bulk operations over the rooms (all_visitors_quit, system_free_places) run
+ * on it from then on, and destroying the system stops it. an executor the
+ * system already had is replaced.
+ * Receives: system type pointer - the system to run on the executor.
+ *          num workers - number of workers, counting the calling thread.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if num workers < 1
+ *              MEMORY_PROBLEM if system was unable to allocate memory or
+ *                             start a thread.*/
+Result start_system_executor(ChallengeRoomSystem *sys, int num_workers){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    TaskExecutor *executor = NULL;
+    Result result = create_task_executor(num_workers, &executor);
+    if (result != OK)
+        return result;
+    if (sys->executor)
+        destroy_task_executor(sys->executor);
+    sys->executor = executor;
+    return OK;
+}
+
+/*  Function counts the free places of a level in every room of the system.
+ * Receives: system type pointer - the system to report on.
+ *          level - the level to count, All_Levels counts every free place.
+ *          places - return value is the free places of every room, in the
+ *                   order of the init file. may be NULL.
+ *          total - return value is the free places of the whole system.
+ * Error Codes: NULL_PARAMETER if sys or total is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result system_free_places(ChallengeRoomSystem *sys, Level level, int *places,
+                          int *total){
+    if (sys == NULL || total == NULL)
+        return NULL_PARAMETER;
+    int num_workers = sys->executor ? sys->executor->num_workers : 1;
+    RoomsTask task = {sys, level, 0, places, NULL, NULL, 0};
+    task.totals = calloc(num_workers, sizeof(int));
+    if (!task.totals)
+        return MEMORY_PROBLEM;
+    Result result = run_on_rooms(sys, count_free_places, &task);
+    *total = 0;
+    for (int i = 0; i < num_workers; ++i)
+        *total += task.totals[i];
+    free(task.totals);
+    return result;
+}
+
+/*  Function lists every occupied slot of the system, room by room in the
+ * order of the init file, without allocating. on a system with an executor
+ * the rooms are counted and then listed in parallel.
+ * Receives: system type pointer - the system to report on.
+ *          entries - buffer to fill, may be NULL if capacity is 0.
+ *          capacity - number of entries the buffer holds.
+ *          count - return value is the number of occupied slots. only the
+ *                  first capacity of them are written to the buffer.
+ * Error Codes: NULL_PARAMETER if sys or count is NULL, or entries is NULL
+ *                             and capacity isn't 0
+ *              ILLEGAL_PARAMETER if capacity is negative
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result system_occupancy(ChallengeRoomSystem *sys, OccupancyEntry *entries,
+                        int capacity, int *count){
+    if (sys == NULL || count == NULL || (entries == NULL && capacity != 0))
+        return NULL_PARAMETER;
+    if (capacity < 0)
+        return ILLEGAL_PARAMETER;
+    if (sys->executor == NULL){
+        int total = 0;
+        for (int i = 0; i < sys->room_array_size; ++i)
+            total += write_room_occupancy(sys->rooms[i], i, entries, total,
+                                          capacity);
+        *count = total;
+        return OK;
+    }
+    RoomsTask task = {sys, All_Levels, 0, NULL, NULL, entries, capacity};
+    task.places = malloc(sizeof(int) * (sys->room_array_size + 1));
+    if (!task.places)
+        return MEMORY_PROBLEM;
+    Result result = run_on_rooms(sys, count_occupied, &task);
+    int total = 0;
+    for (int i = 0; i < sys->room_array_size; ++i) {
+        int occupied = task.places[i];
+        task.places[i] = total; //the first entry of the room.
+        total += occupied;
+    }
+    if (result == OK)
+        result = run_on_rooms(sys, fill_occupancy, &task);
+    free(task.places);
+    *count = total;
+    return result;
+}
+
+/*  Function starts publishing read optimized snapshots of the system
+ * statistics, and publishes the first one. readers on other threads reach
+ * them through open_snapshot_reader and begin_snapshot_read. snapshots that
+ * were enabled already just get the new interval.
+ * Receives: system type pointer - the system to take snapshots of.
+ *          interval - number of changes to the system between automatic
+ *                     publishes, 0 to publish only on publish_system_snapshot.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if interval is negative
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result enable_system_snapshots(ChallengeRoomSystem *sys, int interval){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (interval < 0)
+        return ILLEGAL_PARAMETER;
+    if (sys->snapshots){
+        sys->snapshots->interval = interval;
+        return OK;
+    }
+    SnapshotDomain *domain = malloc(sizeof(*domain));
+    if (!domain)
+        return MEMORY_PROBLEM;
+    init_snapshot_domain(domain, interval);
+    sys->snapshots = domain;
+    Result result = publish_system_snapshot(sys);
+    if (result != OK){
+        free(domain);
+        sys->snapshots = NULL;
+    }
+    return result;
+}
+
+/*  Function publishes a snapshot of the current state of the system. only the
+ * thread that changes the system may call it.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if snapshots are not enabled
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result publish_system_snapshot(ChallengeRoomSystem *sys){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (sys->snapshots == NULL)
+        return ILLEGAL_PARAMETER;
+    SystemSnapshot *snapshot = NULL;
+    Result result = build_snapshot(sys, &snapshot);
+    if (result != OK)
+        return result;
+    publish_snapshot(sys->snapshots, snapshot);
+    return OK;
+}
+
+/*  Function registers the calling thread as a snapshot reader.
+ * Receives: system type pointer - the system to read snapshots of.
+ *          reader - return value is the reader slot to read with.
+ * Error Codes: NULL_PARAMETER if sys or reader is NULL
+ *              ILLEGAL_PARAMETER if snapshots are not enabled
+ *              MEMORY_PROBLEM if SNAPSHOT_READERS readers are open already*/
+Result open_snapshot_reader(ChallengeRoomSystem *sys, int *reader){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (sys->snapshots == NULL)
+        return ILLEGAL_PARAMETER;
+    return snapshot_reader_open(sys->snapshots, reader);
+}
+
+/*  Function releases a reader slot taken by open_snapshot_reader.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if snapshots are not enabled or the reader
+ *                                isn't open*/
+Result close_snapshot_reader(ChallengeRoomSystem *sys, int reader){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (sys->snapshots == NULL)
+        return ILLEGAL_PARAMETER;
+    return snapshot_reader_close(sys->snapshots, reader);
+}
+
+/*  Function gives a reader the latest published snapshot. it never blocks,
+ * and the snapshot stays valid and unchanged until end_snapshot_read.
+ * Receives: system type pointer - the system to read a snapshot of.
+ *          reader - a slot from open_snapshot_reader.
+ *          snapshot - return value is the latest snapshot.
+ * Error Codes: NULL_PARAMETER if sys or snapshot is NULL
+ *              ILLEGAL_PARAMETER if snapshots are not enabled or the reader
+ *                                isn't open*/
+Result begin_snapshot_read(ChallengeRoomSystem *sys, int reader,
+                           const SystemSnapshot **snapshot){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (sys->snapshots == NULL)
+        return ILLEGAL_PARAMETER;
+    return snapshot_read_begin(sys->snapshots, reader, snapshot);
+}
+
+/*  Function ends the read begun by begin_snapshot_read.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if snapshots are not enabled or the reader
+ *                                isn't open*/
+Result end_snapshot_read(ChallengeRoomSystem *sys, int reader){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (sys->snapshots == NULL)
+        return ILLEGAL_PARAMETER;
+    return snapshot_read_end(sys->snapshots, reader);
+}
+
+/*  Function sets the system time, as saved in a compacted journal.
+ * Receives: system pointer
+ *          time - the saved system time.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_TIME the given time is lesser than current system time*/
+Result restore_system_time(ChallengeRoomSystem *sys, int time){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (time < sys->time_log)
+        return ILLEGAL_TIME;
+    sys->time_log = time;
+    return OK;
+}
+
+/*  Function sets the saved name, visits and best time of a challenge.
+ * Receives: system pointer
+ *          position - position of the challenge in the init file.
+ *          name - the saved challenge name.
+ *          num visits, best time - the saved statistics.
+ * Error Codes: NULL_PARAMETER if sys or name is NULL
+ *              ILLEGAL_PARAMETER if the position or a statistic is illegal
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result restore_challenge(ChallengeRoomSystem *sys, int position, char *name,
+                         int num_visits, int best_time){
+    if (sys == NULL || name == NULL)
+        return NULL_PARAMETER;
+    if (position < 0 || position >= sys->challenge_array_size ||
+        num_visits < 0 || best_time < 0)
+        return ILLEGAL_PARAMETER;
+    Challenge *challenge = sys->challenges[position];
+    if (strcmp(challenge->name, name) != 0){
+        Result result = rename_challenge_at(sys, position, name);
+        if (result != OK)
+            return result;
+    }
+    challenge->num_visits = num_visits;
+    challenge->best_time = best_time;
+    return OK;
+}
+
+/*  Function sets the saved name of a room.
+ * Receives: system pointer
+ *          position - position of the room in the init file.
+ *          name - the saved room name.
+ * Error Codes: NULL_PARAMETER if sys or name is NULL
+ *              ILLEGAL_PARAMETER if the position is illegal
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result restore_room(ChallengeRoomSystem *sys, int position, char *name){
+    if (sys == NULL || name == NULL)
+        return NULL_PARAMETER;
+    if (position < 0 || position >= sys->room_array_size)
+        return ILLEGAL_PARAMETER;
+    ChallengeRoom *room = sys->rooms[position];
+    if (strcmp(room->name, name) == 0)
+        return OK;
+    Result result = change_room_name(room, name);
+    if (result == OK)
+        STATS_ADD(sys, allocations, NAME_ON_HEAP(room->name,
+                                                 room->inline_name));
+    return result;
+}
+
+/*  Function puts a saved visitor back in its challenge. the visit was counted
+ * when the visitor arrived, so it is not counted again. a visitor that was
+ * waiting is put back at the end of the room's queue of its level.
+ * Receives: system pointer
+ *          room - position of the room in the init file.
+ *          slot - position of the challenge in the room, or RESTORE_WAITING.
+ *          level - the level a waiting visitor waits for.
+ *          visitor name, visitor id - the saved visitor.
+ *          start time - the time the visitor started the challenge.
+ * Error Codes: NULL_PARAMETER if sys or visitor name is NULL
+ *              ILLEGAL_PARAMETER if the room or the slot is illegal or taken
+ *              ALREADY_IN_ROOM if the visitor is already in the system
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result restore_visitor(ChallengeRoomSystem *sys, int room, int slot,
+                       Level level, char *visitor_name, int visitor_id,
+                       int start_time){
+    if (sys == NULL || visitor_name == NULL)
+        return NULL_PARAMETER;
+    if (room < 0 || room >= sys->room_array_size)
+        return ILLEGAL_PARAMETER;
+    VisitorHandle handle;
+    Result result = add_visitor(sys, visitor_name, visitor_id, &handle);
+    if (result != OK)
+        return result;
+    if (slot == RESTORE_WAITING)
+        result = visitor_wait_in_room(&sys->visitors, sys->rooms[room],
+                                      handle, level);
+    else
+        result = visitor_resume_challenge(sys->rooms[room], slot,
+                                          VISITOR_RECORD(&sys->visitors,
+                                                         handle),
+                                          start_time);
+    if (result == OK)
+        update_room_load(sys->room_load, sys->rooms[room]);
+    else
+        remove_visitor(sys, handle);
+    return result;
+}
+
+
+/*  Function copies the hot path counters of the system. the counters are only
+ * collected when compiled with CHALLENGE_SYSTEM_STATS, otherwise they are
+ * all reported as zero.
+ * Receives: system type pointer - the system to report on.
+ *          stats - return value is the copy of the counters.
+ * Error Codes: NULL_PARAMETER if sys or stats is NULL*/
+Result system_stats(ChallengeRoomSystem *sys, SystemStats *stats){
+    if (sys == NULL || stats == NULL)
+        return NULL_PARAMETER;
+#ifdef CHALLENGE_SYSTEM_STATS
+    *stats = sys->stats;
+#else
+    memset(stats, 0, sizeof(*stats));
+#endif
+    return OK;
+}
+
+/*  Function copies the latency histogram of one public API.
+ * Receives: system type pointer - the system to report on.
+ *          api - the function whose latencies are wanted.
+ *          histogram - return value is the copy of the histogram, empty when
+ *                      compiled without CHALLENGE_SYSTEM_STATS.
+ * Error Codes: NULL_PARAMETER if sys or histogram is NULL
+ *              ILLEGAL_PARAMETER if api is out of range*/
+Result system_latency(ChallengeRoomSystem *sys, SystemApi api,
+                      LatencyHistogram *histogram){
+    if (sys == NULL || histogram == NULL)
+        return NULL_PARAMETER;
+    if (api < 0 || api >= API_COUNT)
+        return ILLEGAL_PARAMETER;
+#ifdef CHALLENGE_SYSTEM_STATS
+    *histogram = sys->latency[api];
+#else
+    reset_histogram(histogram);
+#endif
+    return OK;
+}
+
+/*  Function prints the p50/p90/p99/p999 latencies of every API that was
+ * called since the last reset.
+ * Receives: system type pointer - the system to report on.
+ *          output - the file to print to.
+ * Error Codes: NULL_PARAMETER if sys or output is NULL*/
+Result dump_system_latency(ChallengeRoomSystem *sys, FILE *output){
+    if (sys == NULL || output == NULL)
+        return NULL_PARAMETER;
+#ifdef CHALLENGE_SYSTEM_STATS
+    for (int api = 0; api < API_COUNT; ++api) {
+        if (sys->latency[api].total_count)
+            print_histogram(output, (char*)system_api_name((SystemApi)api),
+                            &sys->latency[api]);
+    }
+#endif
+    return OK;
+}
+
+/*  Function clears the counters and latency histograms of the system.
+ * Error Codes: NULL_PARAMETER if sys is NULL*/
+Result reset_system_stats(ChallengeRoomSystem *sys){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+#ifdef CHALLENGE_SYSTEM_STATS
+    memset(&sys->stats, 0, sizeof(sys->stats));
+    for (int api = 0; api < API_COUNT; ++api) {
+        reset_histogram(&sys->latency[api]);
+    }
+#endif
+    return OK;
+}
+
+/*  Function returns the name of a public API, for reports.*/
+const char *system_api_name(SystemApi api){
+    static const char *names[API_COUNT] = {
+            "create_system", "visitor_arrive", "visitor_quit",
+            "all_visitors_quit", "system_room_of_visitor",
+            "change_challenge_name", "change_system_room_name",
+            "best_time_of_system_challenge", "most_popular_challenge",
+            "create_system_parallel", "visitor_arrive_or_wait",
+            "visitor_arrive_any_room", "change_challenge_names"};
+    if (api < 0 || api >= API_COUNT)
+        return "unknown";
+    return names[api];
+}
+
+/*  Function counts the bytes the system allocated, by what they are used for.
+ * the sizes are those the system asked for, without the overhead of the
+ * allocator. rooms and challenges retired by a reload count until they are
+ * released, and so do snapshots until no reader can still see them. the
+ * threads of the executor count with the stack size they were started with,
+ * the journal file without the buffers of the C library.
+ * Receives: system type pointer - the system to report on.
+ *          usage - return value is the bytes by category.
+ * Error Codes: NULL_PARAMETER if sys or usage is NULL*/
+Result system_memory(ChallengeRoomSystem *sys, MemoryUsage *usage){
+    if (sys == NULL || usage == NULL)
+        return NULL_PARAMETER;
+    memset(usage, 0, sizeof(*usage));
+    size_t *bytes = usage->bytes;
+    bytes[MEMORY_SYSTEM] += sizeof(*sys) +
+            sizeof(Challenge*) * (sys->challenge_array_size + 1) +
+            sizeof(ChallengeRoom*) * (sys->room_array_size + 1) +
+            sizeof(ChallengeRoom*) * sys->num_draining_rooms +
+            sizeof(Challenge*) * sys->num_retired_challenges;
+    bytes[MEMORY_NAMES] += strlen(sys->name) + 1;
+    for (int i = 0; i < sys->challenge_array_size; ++i)
+        count_challenge_memory(sys->challenges[i], usage);
+    for (int i = 0; i < sys->num_retired_challenges; ++i)
+        count_challenge_memory(sys->retired_challenges[i], usage);
+    for (NameBlock *block = sys->name_blocks; block; block = block->next)
+        bytes[MEMORY_NAMES] += sizeof(*block); //the names count by challenge.
+    for (int i = 0; i < sys->room_array_size; ++i)
+        count_room_memory(sys->rooms[i], usage);
+    for (int i = 0; i < sys->num_draining_rooms; ++i)
+        count_room_memory(sys->draining_rooms[i], usage);
+    VisitorTable *table = &sys->visitors;
+    bytes[MEMORY_VISITOR_TABLE] += (sizeof(Visitor*) +
+            sizeof(VisitorHandle) * VISITOR_CHUNK_SIZE) * table->chunk_capacity +
+            2 * sizeof(VisitorHandle) * table->index_capacity +
+            sizeof(ChallengeRoom*) * table->room_capacity;
+    bytes[MEMORY_VISITORS] += sizeof(Visitor) * VISITOR_CHUNK_SIZE *
+                              table->num_chunks;
+    for (VisitorHandle handle = 0; handle < table->num_records; ++handle) {
+        Visitor *visitor = VISITOR_RECORD(table, handle);
+        if (!VISITOR_IN_USE(visitor))
+            continue;
+        bytes[MEMORY_NAMES] += heap_name_size(visitor->visitor_name,
+                                              visitor->inline_name);
+        if (handle != sys->dummy_visitor)
+            usage->num_visitors++;
+    }
+    bytes[MEMORY_INDEXES] += (sizeof(ChallengeIndexEntry) +
+                              sizeof(ChallengeNameEntry)) *
+                             (sys->challenge_array_size + 1);
+    if (sys->room_load){
+        int num_rooms = sys->room_load->num_rooms;
+        bytes[MEMORY_INDEXES] += sizeof(RoomLoad) + sizeof(RoomLoadEntry) *
+                (All_Levels + 1) * (num_rooms > 0 ? num_rooms : 1);
+    }
+    ActivityGroups *groups = &sys->activity_groups;
+    if (groups->activities)
+        bytes[MEMORY_INDEXES] += (sizeof(ChallengeActivity*) + sizeof(int)) *
+                                 (groups->starts[groups->num_groups] + 1);
+    SnapshotDomain *domain = sys->snapshots;
+    if (domain){
+        bytes[MEMORY_SNAPSHOTS] += sizeof(*domain) +
+                                   snapshot_size(domain->current);
+        for (SystemSnapshot *retired = domain->retired; retired;
+             retired = retired->next_retired)
+            bytes[MEMORY_SNAPSHOTS] += snapshot_size(retired);
+    }
+    if (sys->journal)
+        bytes[MEMORY_JOURNAL] += sizeof(SystemJournal) + JOURNAL_BUFFER_SIZE +
+                                 strlen(sys->journal->path) + 1;
+    bytes[MEMORY_EXECUTOR] += executor_size(sys->executor);
+    for (int category = 0; category < MEMORY_CATEGORIES; ++category)
+        usage->total += bytes[category];
+    return OK;
+}
+
+/*  Function prints the bytes of every category of system_memory, their total,
+ * and the total divided by the challenges, rooms and visitors.
+ * Receives: system type pointer - the system to report on.
+ *          output - the file to print to.
+ * Error Codes: NULL_PARAMETER if sys or output is NULL*/
+Result dump_system_memory(ChallengeRoomSystem *sys, FILE *output){
+    if (output == NULL)
+        return NULL_PARAMETER;
+    MemoryUsage usage;
+    Result result = system_memory(sys, &usage);
+    if (result != OK)
+        return result;
+    for (int category = 0; category < MEMORY_CATEGORIES; ++category)
+        fprintf(output, "%-12s %12zu\n",
+                memory_category_name((MemoryCategory)category),
+                usage.bytes[category]);
+    fprintf(output, "%-12s %12zu\n", "total", usage.total);
+    fprintf(output, "per challenge %zu, per room %zu, per visitor %zu\n",
+            usage.num_challenges ? usage.total / usage.num_challenges : 0,
+            usage.num_rooms ? usage.total / usage.num_rooms : 0,
+            usage.num_visitors ? usage.total / usage.num_visitors : 0);
+    return OK;
+}
+
+/*  Function returns the name of a memory category, for reports.*/
+const char *memory_category_name(MemoryCategory category){
+    static const char *names[MEMORY_CATEGORIES] = {
+            "system", "challenges", "rooms", "visitors", "names",
+            "activities", "visitor_table", "indexes", "snapshots", "journal",
+            "executor"};
+    if (category < 0 || category >= MEMORY_CATEGORIES)
+        return "unknown";
+    return names[category];
+}
+
+//static functions
+
+/*  Function reads from initiation file the parameters for the system challenge
+ * array and sets it.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result challenge_read(FILE* file, char* name, int* num_of_challenges,
+                             ChallengeRoomSystem **sys){
+    int challenge_id, level;
+    fscanf(file, "%d ", num_of_challenges);
+    Result result;
+    Challenge** challenge_array = malloc((*num_of_challenges)*
+                                         sizeof(Challenge*));
+    if (challenge_array == NULL)
+        return MEMORY_PROBLEM; //unable to allocate array size.
+    STATS_ADD(*sys, allocations, 1);
+    for (int i=0; i<(*num_of_challenges); i++){
+        fscanf(file, "%s %d %d ", name, &challenge_id, &level);
+        Level resolved = resolve_level(level);
+        Challenge *curr_challenge = malloc(sizeof(Challenge));
+        if (curr_challenge == NULL) {
+            free_allocated((void**)challenge_array, i);
+            return MEMORY_PROBLEM;
+        }
+        challenge_array[i] = curr_challenge;
+        result = init_challenge(curr_challenge, challenge_id, name, resolved);
+        if (result != OK) {
+            free_allocated((void **) challenge_array, i);
+            free(curr_challenge);
+            return result;
+        }
+        STATS_ADD(*sys, allocations, 1 + NAME_ON_HEAP(curr_challenge->name,
+                                              curr_challenge->inline_name));
+    }
+    (*sys)->challenges = challenge_array;
+    return OK;
+}
+
+/*  Function reads from initiation file the parameters for the system room array
+ * and sets it.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result room_read(FILE* file, char* name, ChallengeRoomSystem **sys,
+                        int* room_arr_size){
+    int num_of_rooms, num_of_challenges;
+    fscanf(file, "%d", &num_of_rooms);
+    *room_arr_size = num_of_rooms;
+    Result result;
+    ChallengeRoom** room_array = malloc(sizeof(*room_array)*num_of_rooms);
+    if (room_array == NULL)
+        return MEMORY_PROBLEM;
+    STATS_ADD(*sys, allocations, 1);
+    ChallengeRoom *curr_room = NULL;
+    for (int i=0; i<num_of_rooms; i++){
+        curr_room = malloc(sizeof(ChallengeRoom));
+        if (curr_room == NULL) {
+            free_allocated((void**)room_array, i);
+            free_challenges_memory((*sys));
+            return MEMORY_PROBLEM;
+        }
         fscanf(file, "%s %d ", name, &num_of_challenges);
         room_array[i] = curr_room;
         result = init_room(room_array[i], name, num_of_challenges);
@@ -459,8 +1905,10 @@ static Result room_read(FILE* file, char* name, ChallengeRoomSystem **sys,
             free_challenges_memory((*sys));
             return result;
         }
+        STATS_ADD(*sys, allocations, 2 + NAME_ON_HEAP(curr_room->name,
+                                              curr_room->inline_name));
         result = set_challenges_in_array(file, num_of_challenges, sys,
-                                         room_array[i],challenges_arr_size);
+                                         room_array[i]);
         if (result != OK) {
             free_allocated((void**)room_array, i);
             free(curr_room);
@@ -477,25 +1925,19 @@ static Result room_read(FILE* file, char* name, ChallengeRoomSystem **sys,
  * Error Codes: ILLEGAL_PARAMETER if challenge ID is not int the system.*/
 static Result set_challenges_in_array (FILE* file, int num_of_challenges,
                                        ChallengeRoomSystem **sys,
-                                       ChallengeRoom* room,
-                                       int challenge_arr_size) {
+                                       ChallengeRoom* room) {
     int curr_id;
-    bool found_challenge = false;
     for (int i = 0; i < num_of_challenges; ++i) {
         fscanf(file, "%d ", &curr_id);
-        for (int j = 0; j < challenge_arr_size; ++j) {
-            if ((*sys)->challenges[j]->id == curr_id){
-                Result result = init_challenge_activity(&(room->challenges[i]),
-                                                        (*sys)->challenges[j]);
-                if (result != OK)
-                    return result;
-                found_challenge = true;
-            }
-        }
-        if (!found_challenge){
+        STATS_ADD(*sys, nodes_traversed, 1);
+        Challenge *challenge = find_challenge_by_id(*sys, curr_id);
+        if (!challenge){
             return ILLEGAL_PARAMETER; //challenge not in system.
         }
-        found_challenge = false;
+        Result result = init_challenge_activity(&(room->challenges[i]),
+                                                challenge);
+        if (result != OK)
+            return result;
     }
     return OK;
 }
@@ -515,6 +1957,7 @@ static Result find_room(ChallengeRoomSystem* sys,char* room_name,
     if (sys == NULL)
         return NULL_PARAMETER;
     for (int i = 0; i < sys->room_array_size; i++) {
+        STATS_ADD(sys, string_compares, 1);
         if (!strcmp(sys->rooms[i]->name, room_name)) {
             *room = sys->rooms[i];
             return OK;
@@ -523,141 +1966,114 @@ static Result find_room(ChallengeRoomSystem* sys,char* room_name,
     return ILLEGAL_PARAMETER;
 }
 
-/*  Function adds the visitor to the dinamic list (at the beginning of the list)
- * Error Codes: MEMORY_PROBLEM if allocation fails
- *              NULL_PARAMETER if visitor is NULL*/
-static Result add_to_list(ChallengeRoomSystem *sys,Visitor *visitor){
-    if(visitor==NULL)
-        return NULL_PARAMETER;
-    VisitorList new_visitor = malloc(sizeof(*new_visitor));
-    if(new_visitor==NULL)
-        return MEMORY_PROBLEM;
-    new_visitor->visitor = visitor;
-    VisitorList *list_ptr = NULL;
-    list_ptr= &new_visitor;
-    if(find_visitor_in_list(sys, visitor, &list_ptr) == OK ){
-        free(new_visitor);
+/*  Function adds a visitor to the visitor table of the system.
+ * Error Codes: ALREADY_IN_ROOM if a visitor with the name or the id is in the
+ *                              system
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result add_visitor(ChallengeRoomSystem *sys, char *visitor_name,
+                          int visitor_id, VisitorHandle *handle){
+    if (visitor_taken(sys, visitor_name, visitor_id))
         return ALREADY_IN_ROOM;
+    //records come in chunks, so most visitors allocate nothing.
+    Result result = take_visitor_record(&sys->visitors, handle);
+    if (result != OK)
+        return result;
+    Visitor *visitor = VISITOR_RECORD(&sys->visitors, *handle);
+    result = init_visitor(visitor, visitor_name, visitor_id);
+    if (result == OK){
+        result = index_visitor(&sys->visitors, *handle);
+        if (result != OK)
+            reset_visitor(&sys->visitors, visitor);
     }
-    new_visitor->next_visitor = *sys->first_visitor;
-    if(*sys->first_visitor != NULL)
-        (*sys->first_visitor)->previous_visitor = new_visitor;
-    new_visitor->previous_visitor = NULL;
-    *sys->first_visitor = new_visitor;
-    return OK;
-}
-
-/*  Function removes the visitor to the dinamic list
- * Error Codes: ILLEGAL_PARAMETER if the visitor is not in the list
- *              NULL_PARAMETER if visitor is NULL*/
-static  Result remove_from_list(ChallengeRoomSystem *sys, Visitor *visitor){
-    if (visitor == NULL)
-        return NULL_PARAMETER;
-    VisitorList **ptr = malloc(sizeof(VisitorList*));
-    if(!ptr)
-        return MEMORY_PROBLEM;
-    VisitorList current = NULL;
-    Result res=find_visitor_in_list(sys,visitor,ptr);
-    if(res!= OK){
-        return res;
-    }
-    VisitorList pointer = NULL;
-    pointer = *(*ptr);
-    *ptr = NULL;
-    if(pointer->previous_visitor != NULL){
-        current= pointer->previous_visitor;
-        current->next_visitor = pointer->next_visitor;
-    }
-    else{
-        (*sys->first_visitor) = pointer->next_visitor;
-    }
-    if (pointer->next_visitor != NULL){
-        current = pointer->next_visitor;
-        if (pointer->previous_visitor != NULL){
-            current->previous_visitor = pointer->previous_visitor;
-        }
-        else{
-            current->previous_visitor = NULL;
-        }
+    if (result != OK){
+        return_visitor_record(&sys->visitors, *handle);
+        return result;
     }
-    //  *(*ptr)=pointer;
-    pointer->next_visitor=NULL;
-    pointer->previous_visitor=NULL;
-    free(pointer);
-    free(ptr);
+    STATS_ADD(sys, allocations, NAME_ON_HEAP(visitor->visitor_name,
+                                             visitor->inline_name));
     return OK;
-
 }
 
-/*function finds the pointer to the visitorList of visitor
-* returns the pointer in pointer that received
-* if visitor is not in list than function returns Illegal_parameter*/
-static Result find_visitor_in_list(ChallengeRoomSystem *sys, Visitor *visitor,
-                                   VisitorList** pointer){
-    if(visitor==NULL)
-        return NULL_PARAMETER;
-    for (VisitorList *ptr= sys->first_visitor; (*ptr)!=NULL ;
-         ptr=&((*ptr)->next_visitor)){
-        if (( !strcmp((*ptr)->visitor->visitor_name,visitor->visitor_name)) ||
-            (*ptr)->visitor->visitor_id == visitor->visitor_id){
-            *pointer=ptr;
-            return OK;
-        }
-    }
-    return NOT_IN_ROOM;
+/*  Function resets a visitor that left its room and hands its record back.*/
+static void remove_visitor(ChallengeRoomSystem *sys, VisitorHandle handle){
+    if (handle == sys->dummy_visitor)
+        sys->dummy_visitor = NO_VISITOR;
+    unindex_visitor(&sys->visitors, handle);
+    reset_visitor(&sys->visitors, VISITOR_RECORD(&sys->visitors, handle));
+    return_visitor_record(&sys->visitors, handle);
 }
 
+/*  Function tells if a visitor with the name or the id is in the system.*/
+static bool visitor_taken(ChallengeRoomSystem *sys, char *visitor_name,
+                          int visitor_id){
+    STATS_ADD(sys, nodes_traversed, 2);
+    return find_visitor_id(&sys->visitors, visitor_id) != NO_VISITOR ||
+           find_visitor_name(&sys->visitors, visitor_name) != NO_VISITOR;
+}
 
-/* * Function finds visitor in system by ID parameter
- * @param sys pointer to a system in which to search
- * @param visitor_id identify the visitor with
- * @param visitor returm pointer to requested visitor. NULL iss not in the sys.
- * @return OK if visitor is found.
- * ILLEGAL_PARAMETER if visitor ID is not in the sys.
- */
+/*  Function finds a visitor in the system by id.
+ * Error Codes: NOT_IN_ROOM if the id is not in the system.*/
 static Result find_visitor_by_id(ChallengeRoomSystem *sys, int visitor_id,
-                                 Visitor** visitor){
-    VisitorList *ptr = NULL;
-    for (ptr = sys->first_visitor ; (*ptr) != NULL ;
-         ptr=&((*ptr)->next_visitor)){
-        if ((*ptr)->visitor->visitor_id==visitor_id){
-            *visitor=(*ptr)->visitor;
-            return OK;
-        }
-    }
-    *visitor=NULL;
-    return NOT_IN_ROOM;
+                                 VisitorHandle *handle){
+    STATS_ADD(sys, nodes_traversed, 1);
+    *handle = find_visitor_id(&sys->visitors, visitor_id);
+    return *handle == NO_VISITOR ? NOT_IN_ROOM : OK;
 }
+
+/*  Function finds a visitor in the system by name.
+ * Returns NULL if the name is not in the system.*/
+static Visitor *find_visitor_by_name(ChallengeRoomSystem *sys,
+                                     char *visitor_name){
+    STATS_ADD(sys, nodes_traversed, 1);
+    VisitorHandle handle = find_visitor_name(&sys->visitors, visitor_name);
+    return handle == NO_VISITOR ? NULL : VISITOR_RECORD(&sys->visitors,
+                                                        handle);
+}
+
 /** Function finds a challenge in the system by name
  * @param ptr  - return value points to the wanted challenge entity.
  * @return ILLENGEAL PARAMETER is the challenge is not in the system
  */
 static Result find_challenge(ChallengeRoomSystem *sys, char* challenge_name, Challenge** ptr){
-    for (int i = 0; i < sys->challenge_array_size ; ++i) {
-        if (!strcmp(challenge_name,sys->challenges[i]->name)){
-            *ptr=sys->challenges[i];
-            return OK;
-        }
-
+    //the first challenge with the name in the name order is the first one
+    //in the challenge array.
+    int low = 0, high = sys->challenge_array_size;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        STATS_ADD(sys, string_compares, 1);
+        if (strcmp(sys->challenge_names[middle].challenge->name,
+                   challenge_name) < 0)
+            low = middle + 1;
+        else
+            high = middle;
     }
-    return ILLEGAL_PARAMETER;
+    if (low == sys->challenge_array_size)
+        return ILLEGAL_PARAMETER;
+    STATS_ADD(sys, string_compares, 1);
+    if (strcmp(sys->challenge_names[low].challenge->name, challenge_name))
+        return ILLEGAL_PARAMETER;
+    *ptr = sys->challenge_names[low].challenge;
+    return OK;
 }
 
-/* Function initiates the linked list in a new system.
- * @param visitor the dummy first visitor
- * @param sys points to a given system
- * @return MEMORY PROBLEM if malloc fails
- */
-static Result create_list(Visitor *visitor, ChallengeRoomSystem *sys){
-    VisitorList new_node = malloc(sizeof(*new_node));
-    if(!new_node){
-        return MEMORY_PROBLEM;
+/*  Function readies the visitor table of a new system: it adds the rooms,
+ * so their visitors can keep their indexes, and puts the dummy visitor in
+ * it. the dummy keeps its name and id from visitors until the first quit of
+ * all.
+ * Error Codes: MEMORY_PROBLEM if malloc fails*/
+static Result open_visitor_table(ChallengeRoomSystem *sys){
+    Result result = reserve_visitor_rooms(&sys->visitors,
+                                          sys->room_array_size);
+    for (int i = 0; i < sys->room_array_size && result == OK; ++i)
+        add_visitor_room(&sys->visitors, sys->rooms[i]);
+    sys->dummy_visitor = NO_VISITOR;
+    if (result == OK)
+        result = add_visitor(sys, DUMMY, DUMMY_ID, &sys->dummy_visitor);
+    if (result != OK){
+        sys->dummy_visitor = NO_VISITOR;
+        destroy_visitor_table(&sys->visitors);
     }
-    new_node->visitor = visitor;
-    new_node->next_visitor = NULL;
-    new_node->previous_visitor = NULL;
-    (*sys->first_visitor) = new_node;
-    return OK;
+    return result;
 }
 
 /*Function retrices the best timed challenge in the system the frees challenge
@@ -680,6 +2096,7 @@ static Result free_challenges(ChallengeRoomSystem *sys, char **best_time){
         if ((current_best_time == 0 || challenge_time <= current_best_time) &&
             challenge_time != 0) {
             if( challenge_time == current_best_time){
+                STATS_ADD(sys, string_compares, 1);
                 if(strcmp(best_timed_challenge,sys->challenges[k]->name) > 0 ) {
                     current_best_time = challenge_time;
                     best_timed_challenge = sys->challenges[k]->name;
@@ -717,4 +2134,917 @@ static void free_challenges_memory(ChallengeRoomSystem *sys){
         free(sys->challenges[j]);
     }
     free(sys->challenges);
-}
\ No newline at end of file
+    free(sys->challenge_index);
+    sys->challenge_index = NULL;
+    free(sys->challenge_names);
+    sys->challenge_names = NULL;
+    release_retired_challenges(sys);
+    free(sys->retired_challenges);
+    sys->retired_challenges = NULL;
+}
+
+/*  Function translates a level code of the init file to a Level. codes other
+ * than 1, 2 and 3 mean All_Levels.*/
+static Level resolve_level(int level){
+    switch (level){
+        case 1: return Easy;
+        case 2: return Medium;
+        case 3: return Hard;
+        default: return All_Levels;
+    }
+}
+
+/*  Function builds the challenge id index of the system: the challenges sorted
+ * by id, and by their place in the challenge array for equal ids, and the
+ * name order the same way by name.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result build_challenge_index(ChallengeRoomSystem *sys){
+    ChallengeIndexEntry *index = malloc(sizeof(*index) *
+                                        (sys->challenge_array_size + 1));
+    if (!index)
+        return MEMORY_PROBLEM;
+    ChallengeNameEntry *names = malloc(sizeof(*names) *
+                                       (sys->challenge_array_size + 1));
+    if (!names){
+        free(index);
+        return MEMORY_PROBLEM;
+    }
+    STATS_ADD(sys, allocations, 2);
+    for (int i = 0; i < sys->challenge_array_size; ++i) {
+        index[i].id = sys->challenges[i]->id;
+        index[i].position = i;
+        names[i].challenge = sys->challenges[i];
+        names[i].position = i;
+    }
+    qsort(index, sys->challenge_array_size, sizeof(*index),
+          compare_index_entries);
+    qsort(names, sys->challenge_array_size, sizeof(*names),
+          compare_name_entries);
+    sys->challenge_index = index;
+    sys->challenge_names = names;
+    return OK;
+}
+
+/*  Function orders challenge index entries by id and then by position.*/
+static int compare_index_entries(const void *first, const void *second){
+    const ChallengeIndexEntry *a = first, *b = second;
+    if (a->id != b->id)
+        return a->id < b->id ? -1 : 1;
+    return (a->position > b->position) - (a->position < b->position);
+}
+
+/*  Function finds a challenge in the system by id, using the id index. when
+ * several challenges share the id the last of them in the challenge array is
+ * returned, as the init file reading always did.
+ * Returns NULL if the id is not in the system.*/
+static Challenge *find_challenge_by_id(ChallengeRoomSystem *sys, int id){
+    int position = last_challenge_position(sys, id);
+    if (position == NO_CHALLENGE)
+        return NULL;
+    return sys->challenges[position];
+}
+
+/*  Function finds the position of the last challenge with the id in the
+ * challenge array, using the id index.
+ * Returns NO_CHALLENGE if the id is not in the system.*/
+static int last_challenge_position(ChallengeRoomSystem *sys, int id){
+    int low = 0, high = sys->challenge_array_size;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (sys->challenge_index[middle].id <= id)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low == 0 || sys->challenge_index[low - 1].id != id)
+        return NO_CHALLENGE;
+    return sys->challenge_index[low - 1].position;
+}
+
+/*  Function finds the position of the first challenge with the id in the
+ * challenge array, as a scan of the array would, using the id index.
+ * Returns NO_CHALLENGE if the id is not in the system.*/
+static int first_challenge_position(ChallengeRoomSystem *sys, int id){
+    int entry = first_index_entry(sys, id);
+    if (entry == sys->challenge_array_size ||
+        sys->challenge_index[entry].id != id)
+        return NO_CHALLENGE;
+    return sys->challenge_index[entry].position;
+}
+
+/*  Function finds the first entry of the id index whose id is not smaller
+ * than id.*/
+static int first_index_entry(ChallengeRoomSystem *sys, int id){
+    int low = 0, high = sys->challenge_array_size;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        if (sys->challenge_index[middle].id < id)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+/*  Function orders challenge name entries by name and then by position.*/
+static int compare_name_entries(const void *first, const void *second){
+    const ChallengeNameEntry *a = first, *b = second;
+    int order = strcmp(a->challenge->name, b->challenge->name);
+    if (order != 0)
+        return order;
+    return (a->position > b->position) - (a->position < b->position);
+}
+
+/*  Function finds the entry of the challenge at a position, whose name is
+ * name, in the name order.*/
+static int find_name_entry(ChallengeRoomSystem *sys, char *name, int position){
+    ChallengeNameEntry *names = sys->challenge_names;
+    int low = 0, high = sys->challenge_array_size;
+    while (low < high) {
+        int middle = low + (high - low) / 2;
+        int order = strcmp(names[middle].challenge->name, name);
+        if (order < 0 || (order == 0 && names[middle].position < position))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    assert(low < sys->challenge_array_size &&
+           names[low].position == position);
+    return low;
+}
+
+/*  Function moves an entry whose challenge was renamed to its place in the
+ * name order. the other entries are still in order, so the place is found
+ * by a binary search on the side the entry moves to.*/
+static void reposition_name_entry(ChallengeRoomSystem *sys, int entry){
+    ChallengeNameEntry *names = sys->challenge_names;
+    ChallengeNameEntry moved = names[entry];
+    int low, high;
+    if (entry > 0 && compare_name_entries(&names[entry - 1], &moved) > 0){
+        low = 0;
+        high = entry;
+        while (low < high) {
+            int middle = low + (high - low) / 2;
+            if (compare_name_entries(&names[middle], &moved) < 0)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        memmove(&names[low + 1], &names[low],
+                sizeof(*names) * (size_t)(entry - low));
+    }
+    else {
+        low = entry + 1;
+        high = sys->challenge_array_size;
+        while (low < high) {
+            int middle = low + (high - low) / 2;
+            if (compare_name_entries(&names[middle], &moved) < 0)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        low--;
+        memmove(&names[entry], &names[entry + 1],
+                sizeof(*names) * (size_t)(low - entry));
+    }
+    names[low] = moved;
+}
+
+/*  Function renames the challenge at a position and keeps the name order.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result rename_challenge_at(ChallengeRoomSystem *sys, int position,
+                                  char *new_name){
+    Challenge *challenge = sys->challenges[position];
+    int entry = find_name_entry(sys, challenge->name, position);
+    Result result = change_name(challenge, new_name);
+    if (result != OK)
+        return result;
+    STATS_ADD(sys, allocations, NAME_ON_HEAP(challenge->name,
+                                             challenge->inline_name));
+    reposition_name_entry(sys, entry);
+    return OK;
+}
+
+/*  Function reads a whole init file and splits it on whitespace.
+ * Error Codes: ILLEGAL_PARAMETER if the file can't be opened or read
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result read_init_tokens(char *init_file, InitTokens *init){
+    FILE *file = init_file ? fopen(init_file, "rb") : NULL;
+    if (!file){
+        printf("Error: cannot open system initiation file.\n");
+        return ILLEGAL_PARAMETER;
+    }
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0)
+        size = ftell(file);
+    if (size < 0 || size >= INT_MAX || fseek(file, 0, SEEK_SET) != 0){
+        fclose(file);
+        return ILLEGAL_PARAMETER;
+    }
+    init->buffer = malloc(size + 1);
+    init->tokens = malloc(sizeof(char*) * (size / 2 + 1));
+    if (!init->buffer || !init->tokens ||
+        fread(init->buffer, 1, size, file) != (size_t)size){
+        Result result = init->buffer && init->tokens ?
+                        ILLEGAL_PARAMETER : MEMORY_PROBLEM;
+        free(init->buffer);
+        free(init->tokens);
+        fclose(file);
+        return result;
+    }
+    fclose(file);
+    init->buffer[size] = '\0';
+    init->num_tokens = 0;
+    bool in_token = false;
+    for (long i = 0; i < size; ++i) {
+        if (isspace((unsigned char)init->buffer[i])){
+            init->buffer[i] = '\0';
+            in_token = false;
+        }
+        else if (!in_token){
+            init->tokens[init->num_tokens++] = &init->buffer[i];
+            in_token = true;
+        }
+    }
+    return OK;
+}
+
+/*  Function reads a decimal int at the start of a token, like "%d" does.
+ * Returns false if the token doesn't start with a number.*/
+static bool parse_int(char *token, int *value){
+    char *end = NULL;
+    long parsed = strtol(token, &end, 10);
+    if (end == token || parsed < INT_MIN || parsed > INT_MAX)
+        return false;
+    *value = (int)parsed;
+    return true;
+}
+
+/*  Function keeps the failure of the earliest record a loader chunk saw.*/
+static void record_load_error(LoadError *error, int position, Result result){
+    if (position < error->position){
+        error->position = position;
+        error->result = result;
+    }
+}
+
+/*  Function returns the error of the earliest failed record over all the
+ * chunks, and clears the errors for the next loader. OK if none failed.*/
+static Result first_load_error(LoadError *errors, int num_workers){
+    int first = INT_MAX;
+    Result result = OK;
+    for (int i = 0; i < num_workers; ++i) {
+        if (errors[i].position < first){
+            first = errors[i].position;
+            result = errors[i].result;
+        }
+        errors[i].position = INT_MAX;
+    }
+    return result;
+}
+
+/*  Loader chunk: creates challenges [begin, end) from their records. stops at
+ * the first bad record of the chunk.*/
+static void load_challenges(void *context, int begin, int end, int worker){
+    SystemLoad *load = context;
+    for (int i = begin; i < end; ++i) {
+        char **record = &load->tokens[load->first_challenge_token + 3 * i];
+        int challenge_id, level;
+        if (!parse_int(record[1], &challenge_id) ||
+            !parse_int(record[2], &level)){
+            record_load_error(&load->errors[worker], i, ILLEGAL_PARAMETER);
+            return;
+        }
+        Challenge *challenge = malloc(sizeof(Challenge));
+        if (!challenge){
+            record_load_error(&load->errors[worker], i, MEMORY_PROBLEM);
+            return;
+        }
+        Result result = init_challenge(challenge, challenge_id, record[0],
+                                       resolve_level(level));
+        if (result != OK){
+            free(challenge);
+            record_load_error(&load->errors[worker], i, result);
+            return;
+        }
+        load->errors[worker].heap_names += NAME_ON_HEAP(challenge->name,
+                                                        challenge->inline_name);
+        load->sys->challenges[i] = challenge;
+    }
+}
+
+/*  Loader chunk: creates rooms [begin, end) from their records, linking them
+ * to the challenges through the id index. stops at the first bad record of
+ * the chunk.*/
+static void load_rooms(void *context, int begin, int end, int worker){
+    SystemLoad *load = context;
+    for (int i = begin; i < end; ++i) {
+        char **record = &load->tokens[load->room_tokens[i]];
+        int num_of_challenges = 0;
+        parse_int(record[1], &num_of_challenges); //checked by the record scan.
+        ChallengeRoom *room = malloc(sizeof(ChallengeRoom));
+        if (!room){
+            record_load_error(&load->errors[worker], i, MEMORY_PROBLEM);
+            return;
+        }
+        Result result = init_room(room, record[0], num_of_challenges);
+        bool initialized = result == OK;
+        for (int j = 0; j < num_of_challenges && result == OK; ++j) {
+            int challenge_id;
+            Challenge *challenge = NULL;
+            if (parse_int(record[2 + j], &challenge_id))
+                challenge = find_challenge_by_id(load->sys, challenge_id);
+            if (!challenge)
+                result = ILLEGAL_PARAMETER; //challenge not in system.
+            else
+                result = init_challenge_activity(&room->challenges[j],
+                                                 challenge);
+        }
+        if (result != OK){
+            if (initialized)
+                reset_room(room);
+            free(room);
+            record_load_error(&load->errors[worker], i, result);
+            return;
+        }
+        load->errors[worker].heap_names += NAME_ON_HEAP(room->name,
+                                                        room->inline_name);
+        load->sys->rooms[i] = room;
+    }
+}
+
+/*  Function finds the first token of every room record. a record is the room
+ * name, the number of its challenges and their ids.
+ * Error Codes: ILLEGAL_PARAMETER if a record is cut short or its number of
+ *              challenges is not a positive number.*/
+static Result find_room_records(InitTokens *init, int first_token,
+                                int num_of_rooms, int *room_tokens){
+    int token = first_token;
+    for (int i = 0; i < num_of_rooms; ++i) {
+        int num_of_challenges = 0;
+        if (token + 1 >= init->num_tokens ||
+            !parse_int(init->tokens[token + 1], &num_of_challenges) ||
+            num_of_challenges < 1 ||
+            num_of_challenges > init->num_tokens - token - 2)
+            return ILLEGAL_PARAMETER;
+        room_tokens[i] = token;
+        token += 2 + num_of_challenges;
+    }
+    return OK;
+}
+
+/*  Function releases the rooms a loader created so far.*/
+static void free_loaded_rooms(ChallengeRoomSystem *sys){
+    if (!sys->rooms)
+        return;
+    for (int i = 0; i < sys->room_array_size; ++i) {
+        if (sys->rooms[i]){
+            reset_room(sys->rooms[i]);
+            free(sys->rooms[i]);
+        }
+    }
+    free(sys->rooms);
+    sys->rooms = NULL;
+}
+
+/*  Function matches the challenges of a freshly loaded system to the live
+ * ones by id, and lists the challenges the system will have after the
+ * reload. a live challenge is kept by one fresh challenge at most.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.
+ *              ILLEGAL_PARAMETER if a kept challenge changed its level.*/
+static Result plan_reload_challenges(ChallengeRoomSystem *sys,
+                                     ReloadPlan *plan){
+    ChallengeRoomSystem *fresh = plan->fresh;
+    plan->challenges = malloc(sizeof(Challenge*) *
+                              (fresh->challenge_array_size + 1));
+    plan->kept_positions = malloc(sizeof(int) *
+                                  (fresh->challenge_array_size + 1));
+    plan->kept_challenges = calloc(sys->challenge_array_size + 1,
+                                   sizeof(bool));
+    if (!plan->challenges || !plan->kept_positions || !plan->kept_challenges)
+        return MEMORY_PROBLEM;
+    for (int i = 0; i < fresh->challenge_array_size; ++i) {
+        Challenge *challenge = fresh->challenges[i];
+        int position = NO_CHALLENGE;
+        for (int entry = first_index_entry(sys, challenge->id);
+             entry < sys->challenge_array_size &&
+             sys->challenge_index[entry].id == challenge->id; ++entry) {
+            if (!plan->kept_challenges[sys->challenge_index[entry].position]){
+                position = sys->challenge_index[entry].position;
+                break;
+            }
+        }
+        plan->kept_positions[i] = position;
+        if (position == NO_CHALLENGE){
+            plan->challenges[i] = challenge;
+            continue;
+        }
+        if (sys->challenges[position]->level != challenge->level)
+            return ILLEGAL_PARAMETER;
+        plan->kept_challenges[position] = true;
+        plan->challenges[i] = sys->challenges[position];
+    }
+    return OK;
+}
+
+/*  Function matches the rooms of a freshly loaded system to the live ones. a
+ * live room is kept if a fresh room has its name and, in the same order, the
+ * challenges it has after the reload. the other fresh rooms are added.*/
+static void plan_reload_rooms(ChallengeRoomSystem *sys, ReloadPlan *plan){
+    ChallengeRoomSystem *fresh = plan->fresh;
+    int num_live = sys->room_array_size;
+    memcpy(plan->live_rooms, sys->rooms, sizeof(ChallengeRoom*) * num_live);
+    qsort(plan->live_rooms, num_live, sizeof(ChallengeRoom*),
+          compare_room_names);
+    for (int i = 0; i < fresh->room_array_size; ++i) {
+        ChallengeRoom *room = fresh->rooms[i];
+        plan->rooms[i] = room;
+        int low = 0, high = num_live;
+        while (low < high) {
+            int middle = low + (high - low) / 2;
+            STATS_ADD(sys, string_compares, 1);
+            if (strcmp(plan->live_rooms[middle]->name, room->name) < 0)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        for (; low < num_live &&
+               !strcmp(plan->live_rooms[low]->name, room->name); ++low) {
+            if (!plan->kept_rooms[low] &&
+                same_activities(plan, plan->live_rooms[low], room)){
+                plan->kept_rooms[low] = true;
+                plan->rooms[i] = plan->live_rooms[low];
+                break;
+            }
+        }
+    }
+}
+
+/*  Function orders room pointers by the names of their rooms.*/
+static int compare_room_names(const void *first, const void *second){
+    ChallengeRoom *const *a = first, *const *b = second;
+    return strcmp((*a)->name, (*b)->name);
+}
+
+/*  Function finds the challenge a challenge of the freshly loaded system
+ * becomes after the reload. fresh rooms point to the last challenge with
+ * their id, as the loader resolves them.*/
+static Challenge *reloaded_challenge(ReloadPlan *plan, Challenge *challenge){
+    int position = last_challenge_position(plan->fresh, challenge->id);
+    assert(position != NO_CHALLENGE);
+    return plan->challenges[position];
+}
+
+/*  Function tells if a live room has the challenges a fresh room will have
+ * after the reload, in the same order.*/
+static bool same_activities(ReloadPlan *plan, ChallengeRoom *live,
+                            ChallengeRoom *fresh){
+    if (live->num_of_challenges != fresh->num_of_challenges)
+        return false;
+    for (int i = 0; i < live->num_of_challenges; ++i) {
+        if (live->challenges[i].challenge !=
+            reloaded_challenge(plan, fresh->challenges[i].challenge))
+            return false;
+    }
+    return true;
+}
+
+/*  Function releases a reload plan and what is left of its fresh system.*/
+static void free_reload_plan(ReloadPlan *plan){
+    free(plan->challenges);
+    free(plan->kept_positions);
+    free(plan->kept_challenges);
+    free(plan->rooms);
+    free(plan->live_rooms);
+    free(plan->kept_rooms);
+    release_system_shell(plan->fresh);
+}
+
+/*  Function releases a system that has no visitors, skipping the rooms and
+ * challenges that were taken from it.*/
+static void release_system_shell(ChallengeRoomSystem *sys){
+    destroy_visitor_table(&sys->visitors);
+    free_loaded_rooms(sys);
+    free_challenges_memory(sys);
+    free(sys->name);
+    free(sys);
+}
+
+/*  Function tells if no visitor is in a room or waits in it.*/
+static bool room_is_empty(ChallengeRoom *room){
+    if (room->occupied[All_Levels] > 0)
+        return false;
+    for (int level = 0; level <= All_Levels; ++level) {
+        if (room->queues[level].first != NO_VISITOR)
+            return false;
+    }
+    return true;
+}
+
+/*  Function releases a room retired by a reload once its last visitor left,
+ * and the retired challenges with the last such room.*/
+static void release_drained_room(ChallengeRoomSystem *sys,
+                                 ChallengeRoom *room){
+    if (room == NULL || !room->retired || !room_is_empty(room))
+        return;
+    for (int i = 0; i < sys->num_draining_rooms; ++i) {
+        if (sys->draining_rooms[i] == room){
+            sys->draining_rooms[i] =
+                    sys->draining_rooms[--sys->num_draining_rooms];
+            break;
+        }
+    }
+    remove_visitor_room(&sys->visitors, room);
+    reset_room(room);
+    free(room);
+    if (sys->num_draining_rooms == 0)
+        release_retired_challenges(sys);
+}
+
+/*  Function releases the challenges retired by reloads.*/
+static void release_retired_challenges(ChallengeRoomSystem *sys){
+    for (int i = 0; i < sys->num_retired_challenges; ++i) {
+        reset_challenge(sys->retired_challenges[i]);
+        free(sys->retired_challenges[i]);
+    }
+    sys->num_retired_challenges = 0;
+}
+
+/*  Function quits every visitor waiting in a room. the room may be a retired
+ * one that is released with its last waiter, so it isn't read after that.
+ * Error Codes: as visitor_quit.*/
+static Result quit_room_waiters(ChallengeRoomSystem *sys, ChallengeRoom *room,
+                                int quit_time){
+    int remaining = 0;
+    for (int level = 0; level <= All_Levels; ++level)
+        remaining += room->queues[level].length;
+    for (int level = 0; level <= All_Levels && remaining > 0; ++level) {
+        while (remaining > 0 && room->queues[level].first != NO_VISITOR) {
+            remaining--;
+            Visitor *first = VISITOR_RECORD(&sys->visitors,
+                                            room->queues[level].first);
+            Result result = visitor_quit_untimed(sys, first->visitor_id,
+                                                 quit_time);
+            if (result != OK)
+                return result;
+        }
+    }
+    return OK;
+}
+
+/*  Function returns the bytes a name took on the heap, 0 if it is inline.*/
+static size_t heap_name_size(char *name, char *inline_name){
+    return NAME_ON_HEAP(name, inline_name) ? strlen(name) + 1 : 0;
+}
+
+/*  Function adds a challenge to the memory of a system.*/
+static void count_challenge_memory(Challenge *challenge, MemoryUsage *usage){
+    usage->bytes[MEMORY_CHALLENGES] += sizeof(*challenge);
+    usage->bytes[MEMORY_NAMES] += heap_name_size(challenge->name,
+                                                 challenge->inline_name);
+    usage->num_challenges++;
+}
+
+/*  Function adds a room and its activities to the memory of a system.*/
+static void count_room_memory(ChallengeRoom *room, MemoryUsage *usage){
+    usage->bytes[MEMORY_ROOMS] += sizeof(*room);
+    usage->bytes[MEMORY_NAMES] += heap_name_size(room->name,
+                                                 room->inline_name);
+    usage->bytes[MEMORY_ACTIVITIES] += sizeof(ChallengeActivity) *
+                                       room->num_of_challenges;
+    usage->num_rooms++;
+}
+
+/*  Function returns the bytes of a snapshot block, as build_snapshot
+ * allocated it, or 0 if there is no snapshot.*/
+static size_t snapshot_size(SystemSnapshot *snapshot){
+    if (snapshot == NULL)
+        return 0;
+    size_t size = sizeof(*snapshot) +
+            sizeof(SnapshotChallenge) * snapshot->num_challenges +
+            sizeof(SnapshotRoom) * snapshot->num_rooms;
+    for (int i = 0; i < snapshot->num_challenges; ++i)
+        size += strlen(snapshot->challenges[i].name) + 1;
+    for (int i = 0; i < snapshot->num_rooms; ++i)
+        size += strlen(snapshot->rooms[i].name) + 1;
+    return size;
+}
+
+/*  Function returns the bytes of an executor: its deques and thread handles,
+ * and a default sized stack for every thread it started. the calling thread
+ * is worker 0 and has no thread of its own. 0 if there is no executor.*/
+static size_t executor_size(TaskExecutor *executor){
+    if (executor == NULL)
+        return 0;
+    size_t stack_size = 0;
+    pthread_attr_t attributes;
+    if (pthread_attr_init(&attributes) == 0){
+        pthread_attr_getstacksize(&attributes, &stack_size);
+        pthread_attr_destroy(&attributes);
+    }
+    return sizeof(*executor) + (sizeof(pthread_t) + sizeof(TaskDeque)) *
+           executor->num_workers + stack_size * (executor->num_workers - 1);
+}
+
+/*  Function tells if a challenge beats the current most popular one: it has
+ * more visits, or as many visits and a smaller name.*/
+static bool more_popular(Challenge *candidate, Challenge *current){
+    if (candidate->num_visits != current->num_visits)
+        return candidate->num_visits > current->num_visits;
+    return strcmp(candidate->name, current->name) < 0;
+}
+
+/*  Function tells if a challenge beats the current best timed one: it has a
+ * best time and the current one doesn't, or a lower best time, or the same
+ * best time and a smaller name.*/
+static bool better_time(Challenge *candidate, Challenge *current){
+    if (candidate->best_time == 0)
+        return false;
+    if (current->best_time == 0 || candidate->best_time != current->best_time)
+        return current->best_time == 0 ||
+               candidate->best_time < current->best_time;
+    return strcmp(candidate->name, current->name) < 0;
+}
+
+/*  Teardown chunk: finds the most popular and best timed challenges among
+ * challenges [begin, end) and sums their visits.*/
+static void reduce_challenges(void *context, int begin, int end, int worker){
+    SystemTeardown *teardown = context;
+    Challenge **challenges = teardown->sys->challenges;
+    TeardownPartial *partial = &teardown->partials[worker];
+    for (int i = begin; i < end; ++i) {
+        partial->visits += challenges[i]->num_visits;
+        if (partial->most_popular == NO_CHALLENGE ||
+            more_popular(challenges[i], challenges[partial->most_popular]))
+            partial->most_popular = i;
+        if (partial->best_time == NO_CHALLENGE ||
+            better_time(challenges[i], challenges[partial->best_time]))
+            partial->best_time = i;
+    }
+}
+
+/*  Teardown chunk: releases rooms [begin, end).*/
+static void release_rooms(void *context, int begin, int end, int worker){
+    ChallengeRoomSystem *sys = context;
+    for (int i = begin; i < end; ++i) {
+        Result result = reset_room(sys->rooms[i]);
+        assert(result == OK); //rooms are never NULL.
+        (void)result;
+        free(sys->rooms[i]);
+    }
+}
+
+/*  Teardown chunk: releases challenges [begin, end).*/
+static void release_challenges(void *context, int begin, int end, int worker){
+    ChallengeRoomSystem *sys = context;
+    for (int i = begin; i < end; ++i) {
+        reset_challenge(sys->challenges[i]);
+        free(sys->challenges[i]);
+    }
+}
+
+/*  Function returns a copy of the name of a challenge.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result copy_challenge_name(Challenge *challenge, char **name){
+    *name = malloc(strlen(challenge->name) + 1);
+    if (!*name)
+        return MEMORY_PROBLEM;
+    strcpy(*name, challenge->name);
+    return OK;
+}
+
+/*  Function runs a body on every room of the system, on the executor when
+ * the system has one and in place otherwise.*/
+static Result run_on_rooms(ChallengeRoomSystem *sys, TaskBody body,
+                           void *context){
+    if (sys->executor)
+        return run_tasks(sys->executor, sys->room_array_size, body, context);
+    for (int i = 0; i < sys->room_array_size; ++i)
+        body(context, i, 0);
+    return OK;
+}
+
+/*  Room task: counts the free places of the task level in one room.*/
+static void count_free_places(void *context, int item, int worker){
+    RoomsTask *task = context;
+    int places = 0;
+    num_of_free_places_for_level(task->sys->rooms[item], task->level, &places);
+    if (task->places)
+        task->places[item] = places;
+    task->totals[worker] += places;
+}
+
+/*  Room task: empties one room at the task time. its challenges were
+ * recorded by quit_challenge_visitors.*/
+static void quit_room_visitors(void *context, int item, int worker){
+    RoomsTask *task = context;
+    room_visitors_leave(&task->sys->visitors, task->sys->rooms[item],
+                        task->time);
+}
+
+/*  Challenge task: records the quits of the visitors of one challenge, in all
+ * the rooms that have it.*/
+static void quit_challenge_visitors(void *context, int item, int worker){
+    RoomsTask *task = context;
+    ActivityGroups *groups = &task->sys->activity_groups;
+    for (int i = groups->starts[item]; i < groups->starts[item + 1]; ++i)
+        record_activity_quit(groups->activities[i], task->time);
+}
+
+/*  Function groups the activities of the rooms by challenge, unless they
+ * are grouped already. the rooms only change their challenges on a reload,
+ * which releases the groups.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result group_activities(ChallengeRoomSystem *sys){
+    ActivityGroups *groups = &sys->activity_groups;
+    if (groups->activities)
+        return OK;
+    int num_activities = 0;
+    for (int i = 0; i < sys->room_array_size; ++i)
+        num_activities += sys->rooms[i]->num_of_challenges;
+    groups->activities = malloc(sizeof(ChallengeActivity*) *
+                                (num_activities + 1));
+    groups->starts = malloc(sizeof(int) * (num_activities + 1));
+    if (!groups->activities || !groups->starts){
+        release_activity_groups(sys);
+        return MEMORY_PROBLEM;
+    }
+    STATS_ADD(sys, allocations, 2);
+    int activity = 0;
+    for (int i = 0; i < sys->room_array_size; ++i) {
+        for (int j = 0; j < sys->rooms[i]->num_of_challenges; ++j)
+            groups->activities[activity++] = &sys->rooms[i]->challenges[j];
+    }
+    qsort(groups->activities, (size_t)num_activities,
+          sizeof(ChallengeActivity*), compare_activity_challenges);
+    groups->num_groups = 0;
+    for (int i = 0; i < num_activities; ++i) {
+        if (i == 0 || groups->activities[i]->challenge !=
+                      groups->activities[i - 1]->challenge)
+            groups->starts[groups->num_groups++] = i;
+    }
+    groups->starts[groups->num_groups] = num_activities;
+    return OK;
+}
+
+/*  Function orders activities by the address of their challenge, which is
+ * all the grouping needs.*/
+static int compare_activity_challenges(const void *first, const void *second){
+    uintptr_t a = (uintptr_t)(*(ChallengeActivity *const *)first)->challenge;
+    uintptr_t b = (uintptr_t)(*(ChallengeActivity *const *)second)->challenge;
+    return (a > b) - (a < b);
+}
+
+/*  Function releases the activity groups, to be built again when needed.*/
+static void release_activity_groups(ChallengeRoomSystem *sys){
+    free(sys->activity_groups.activities);
+    free(sys->activity_groups.starts);
+    sys->activity_groups.activities = NULL;
+    sys->activity_groups.starts = NULL;
+    sys->activity_groups.num_groups = 0;
+}
+
+/*  Function counts a change to the system, and publishes a snapshot once the
+ * snapshot interval is reached. a failed publish is retried on the next
+ * change.*/
+static void note_system_change(ChallengeRoomSystem *sys){
+    SnapshotDomain *domain = sys->snapshots;
+    if (domain == NULL || domain->interval == 0)
+        return;
+    if (++domain->changes >= domain->interval)
+        publish_system_snapshot(sys);
+}
+
+/*  Function builds a snapshot of the system in a single block: the snapshot,
+ * its challenge and room tables, and then every name.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result build_snapshot(ChallengeRoomSystem *sys,
+                             SystemSnapshot **snapshot){
+    size_t names_size = 0;
+    for (int i = 0; i < sys->challenge_array_size; ++i)
+        names_size += strlen(sys->challenges[i]->name) + 1;
+    for (int i = 0; i < sys->room_array_size; ++i)
+        names_size += strlen(sys->rooms[i]->name) + 1;
+    SystemSnapshot *new_snapshot = malloc(sizeof(SystemSnapshot) +
+            sizeof(SnapshotChallenge) * sys->challenge_array_size +
+            sizeof(SnapshotRoom) * sys->room_array_size + names_size);
+    if (!new_snapshot)
+        return MEMORY_PROBLEM;
+    STATS_ADD(sys, allocations, 1);
+    memset(new_snapshot, 0, sizeof(*new_snapshot));
+    new_snapshot->time = sys->time_log;
+    new_snapshot->num_challenges = sys->challenge_array_size;
+    new_snapshot->challenges = (SnapshotChallenge*)(new_snapshot + 1);
+    new_snapshot->num_rooms = sys->room_array_size;
+    new_snapshot->rooms = (SnapshotRoom*)(new_snapshot->challenges +
+                                          sys->challenge_array_size);
+    char *names = (char*)(new_snapshot->rooms + sys->room_array_size);
+    Challenge *popular = NULL, *best = NULL;
+    int sum_of_visits = 0;
+    for (int i = 0; i < sys->challenge_array_size; ++i) {
+        Challenge *challenge = sys->challenges[i];
+        SnapshotChallenge *entry = &new_snapshot->challenges[i];
+        entry->name = strcpy(names, challenge->name);
+        names += strlen(names) + 1;
+        entry->id = challenge->id;
+        entry->level = challenge->level;
+        entry->best_time = challenge->best_time;
+        entry->num_visits = challenge->num_visits;
+        sum_of_visits += challenge->num_visits;
+        if (!popular || more_popular(challenge, popular)){
+            popular = challenge;
+            new_snapshot->most_popular = entry->name;
+        }
+        if (!best || better_time(challenge, best)){
+            best = challenge;
+            new_snapshot->best_timed = entry->name;
+        }
+    }
+    if (!sum_of_visits)
+        new_snapshot->most_popular = NULL;
+    if (!best || best->best_time == 0)
+        new_snapshot->best_timed = NULL;
+    for (int i = 0; i < sys->room_array_size; ++i) {
+        ChallengeRoom *room = sys->rooms[i];
+        SnapshotRoom *entry = &new_snapshot->rooms[i];
+        entry->name = strcpy(names, room->name);
+        names += strlen(names) + 1;
+        memset(entry->free_places, 0, sizeof(entry->free_places));
+        for (int j = 0; j < room->num_of_challenges; ++j) {
+            if (room->challenges[j].visitor != NULL)
+                continue;
+            Level level = room->challenges[j].level;
+            entry->free_places[level]++;
+            if (level != All_Levels)
+                entry->free_places[All_Levels]++;
+        }
+    }
+    *snapshot = new_snapshot;
+    return OK;
+}
+
+/*  Function stops taking snapshots of the system and releases them. no
+ * reader may be reading any more.*/
+static void release_snapshots(ChallengeRoomSystem *sys){
+    if (sys->snapshots == NULL)
+        return;
+    reset_snapshot_domain(sys->snapshots);
+    free(sys->snapshots);
+    sys->snapshots = NULL;
+}
+
+/*  Room task: counts the occupied slots of one room into its place.*/
+static void count_occupied(void *context, int item, int worker){
+    RoomsTask *task = context;
+    ChallengeRoom *room = task->sys->rooms[item];
+    int occupied = 0;
+    for (int i = 0; i < room->num_of_challenges; ++i)
+        occupied += room->challenges[i].visitor != NULL;
+    task->places[item] = occupied;
+}
+
+/*  Room task: lists the occupied slots of one room, from the first entry its
+ * place holds.*/
+static void fill_occupancy(void *context, int item, int worker){
+    RoomsTask *task = context;
+    write_room_occupancy(task->sys->rooms[item], item, task->entries,
+                         task->places[item], task->capacity);
+}
+
+/*  Function writes the occupied slots of a room to entries, from the first
+ * entry on and only below capacity. returns the number of occupied slots.*/
+static int write_room_occupancy(ChallengeRoom *room, int room_index,
+                                OccupancyEntry *entries, int first,
+                                int capacity){
+    int occupied = 0;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        ChallengeActivity *activity = &room->challenges[i];
+        if (activity->visitor == NULL)
+            continue;
+        if (first + occupied < capacity){
+            OccupancyEntry *entry = &entries[first + occupied];
+            entry->room = room_index;
+            entry->challenge_id = activity->challenge->id;
+            entry->visitor_id = activity->visitor->visitor_id;
+            entry->start_time = activity->start_time;
+        }
+        occupied++;
+    }
+    return occupied;
+}
+
+/*  Function finds the challenge with the most visits, the smallest name
+ * breaking ties. returns NULL if no challenge was visited.*/
+static Challenge *find_most_popular(ChallengeRoomSystem *sys){
+    Challenge *popular = NULL;
+    int sum_of_visits = 0;
+    for (int i = 0; i < sys->challenge_array_size; ++i) {
+        Challenge *challenge = sys->challenges[i];
+        sum_of_visits += challenge->num_visits;
+        if (popular && challenge->num_visits == popular->num_visits)
+            STATS_ADD(sys, string_compares, 1);
+        if (!popular || more_popular(challenge, popular))
+            popular = challenge;
+    }
+    return sum_of_visits ? popular : NULL;
+}
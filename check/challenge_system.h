@@ -4,6 +4,9 @@
 #include "visitor_room.h"
 #include "system_additional_types.h"
 
+/* the slot restore_visitor takes for a visitor that waits in the room*/
+#define RESTORE_WAITING -1
+
 typedef struct SChallengeRoomSystem
 {
 
@@ -14,13 +17,31 @@ typedef struct SChallengeRoomSystem
 
 Result create_system(char *init_file, ChallengeRoomSystem **sys);
 
+Result create_system_parallel(char *init_file, ChallengeRoomSystem **sys,
+                              int num_threads);
+
+Result reload_system(ChallengeRoomSystem *sys, char *init_file,
+                     ReloadReport *report);
+
 
 Result destroy_system(ChallengeRoomSystem *sys, int destroy_time,
                       char **most_popular_challenge_p, char **challenge_best_time);
 
+Result destroy_system_parallel(ChallengeRoomSystem *sys, int destroy_time,
+                               char **most_popular_challenge_p,
+                               char **challenge_best_time, int num_threads);
+
 
 Result visitor_arrive(ChallengeRoomSystem *sys, char *room_name, char *visitor_name, int visitor_id, Level level, int start_time);
 
+Result visitor_arrive_or_wait(ChallengeRoomSystem *sys, char *room_name,
+                              char *visitor_name, int visitor_id, Level level,
+                              int start_time, bool *waiting);
+
+Result visitor_arrive_any_room(ChallengeRoomSystem *sys, char *visitor_name,
+                               int visitor_id, Level level, int start_time,
+                               const char **room_name);
+
 
 Result visitor_quit(ChallengeRoomSystem *sys, int visitor_id, int quit_time);
 
@@ -30,9 +51,16 @@ Result all_visitors_quit(ChallengeRoomSystem *sys, int quit_time);
 
 Result system_room_of_visitor(ChallengeRoomSystem *sys, char *visitor_name, char **room_name);
 
+Result system_room_of_visitor_view(ChallengeRoomSystem *sys,
+                                   char *visitor_name,
+                                   const char **room_name, int *length);
+
 
 Result change_challenge_name(ChallengeRoomSystem *sys, int challenge_id, char *new_name);
 
+Result change_challenge_names(ChallengeRoomSystem *sys,
+                              ChallengeRename *renames, int num_renames);
+
 
 Result change_system_room_name(ChallengeRoomSystem *sys, char *current_name, char *new_name);
 
@@ -42,6 +70,86 @@ Result best_time_of_system_challenge(ChallengeRoomSystem *sys, char *challenge_n
 
 Result most_popular_challenge(ChallengeRoomSystem *sys, char **challenge_name);
 
+Result most_popular_challenge_view(ChallengeRoomSystem *sys,
+                                   const char **challenge_name, int *length);
+
+
+Result set_system_window_width(ChallengeRoomSystem *sys, int bucket_width);
+
+Result most_popular_challenge_in_window(ChallengeRoomSystem *sys, int window,
+                                        char **challenge_name);
+
+Result best_time_of_system_challenge_in_window(ChallengeRoomSystem *sys,
+                                               char *challenge_name,
+                                               int window, int *time);
+
+Result completion_time_percentile(ChallengeRoomSystem *sys,
+                                  char *challenge_name, double percentile,
+                                  int *time);
+
+Result system_room_forecast(ChallengeRoomSystem *sys, char *room_name,
+                            Level level, RoomForecast *forecast);
+
+
+Result start_system_executor(ChallengeRoomSystem *sys, int num_workers);
+
+Result system_free_places(ChallengeRoomSystem *sys, Level level, int *places,
+                          int *total);
+
+Result system_occupancy(ChallengeRoomSystem *sys, OccupancyEntry *entries,
+                        int capacity, int *count);
+
+
+Result enable_system_snapshots(ChallengeRoomSystem *sys, int interval);
+
+Result publish_system_snapshot(ChallengeRoomSystem *sys);
+
+Result open_snapshot_reader(ChallengeRoomSystem *sys, int *reader);
+
+Result close_snapshot_reader(ChallengeRoomSystem *sys, int reader);
+
+Result begin_snapshot_read(ChallengeRoomSystem *sys, int reader,
+                           const SystemSnapshot **snapshot);
+
+Result end_snapshot_read(ChallengeRoomSystem *sys, int reader);
+
+
+Result restore_system_time(ChallengeRoomSystem *sys, int time);
+
+Result restore_challenge(ChallengeRoomSystem *sys, int position, char *name,
+                         int num_visits, int best_time);
+
+Result restore_room(ChallengeRoomSystem *sys, int position, char *name);
+
+Result restore_visitor(ChallengeRoomSystem *sys, int room, int slot,
+                       Level level, char *visitor_name, int visitor_id,
+                       int start_time);
+
+
+Result system_stats(ChallengeRoomSystem *sys, SystemStats *stats);
+
+
+Result system_latency(ChallengeRoomSystem *sys, SystemApi api,
+                      LatencyHistogram *histogram);
+
+
+Result dump_system_latency(ChallengeRoomSystem *sys, FILE *output);
+
+
+Result reset_system_stats(ChallengeRoomSystem *sys);
+
+
+const char *system_api_name(SystemApi api);
+
+
+Result system_memory(ChallengeRoomSystem *sys, MemoryUsage *usage);
+
+
+Result dump_system_memory(ChallengeRoomSystem *sys, FILE *output);
+
+
+const char *memory_category_name(MemoryCategory category);
+
 
 #endif // CHALLENGE_SYSTEM_H_
 
@@ -0,0 +1,320 @@
+#ifndef CHALLENGE_SYSTEM_HPP_
+#define CHALLENGE_SYSTEM_HPP_
+
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+extern "C" {
+#include "challenge_system.h"
+#include "system_journal.h"
+}
+
+/* Header only C++17 wrapper of challenge_system.h. A System owns its
+ * ChallengeRoomSystem and destroys it when it goes out of scope; it can be
+ * moved but not copied. Every call returns an Expected holding either its
+ * value or the Result of the C function. Names the core lends are returned as
+ * std::string_view and stay valid until the system changes; names the core
+ * allocates are handed over as CString, so no string is copied. Names passed
+ * in must be '\0' terminated, as the core expects. */
+
+namespace challenge_system {
+
+struct FreeDeleter
+{
+   void operator()(char *pointer) const noexcept { std::free(pointer); }
+};
+
+/* a name allocated by the core, released with free*/
+using CString = std::unique_ptr<char, FreeDeleter>;
+
+/* the error side of an Expected, like std::unexpected*/
+struct Unexpected
+{
+   Result error;
+};
+
+template <typename T>
+class [[nodiscard]] Expected
+{
+public:
+   Expected(T value) : value_(std::move(value)) {}
+   Expected(Unexpected error) : error_(error.error) { assert(error_ != OK); }
+
+   bool has_value() const noexcept { return error_ == OK; }
+   explicit operator bool() const noexcept { return has_value(); }
+   Result error() const noexcept { return error_; }
+
+   T &value() & { assert(has_value()); return *value_; }
+   const T &value() const & { assert(has_value()); return *value_; }
+   T &&value() && { assert(has_value()); return std::move(*value_); }
+   T &operator*() & { return value(); }
+   const T &operator*() const & { return value(); }
+   T *operator->() { return &value(); }
+   const T *operator->() const { return &value(); }
+
+   template <typename U>
+   T value_or(U &&other) const & {
+      return has_value() ? *value_ : static_cast<T>(std::forward<U>(other));
+   }
+
+private:
+   std::optional<T> value_;
+   Result error_ = OK;
+};
+
+template <>
+class [[nodiscard]] Expected<void>
+{
+public:
+   Expected() = default;
+   Expected(Unexpected error) : error_(error.error) { assert(error_ != OK); }
+
+   bool has_value() const noexcept { return error_ == OK; }
+   explicit operator bool() const noexcept { return has_value(); }
+   Result error() const noexcept { return error_; }
+
+private:
+   Result error_ = OK;
+};
+
+/* maps the Result of a C call to an Expected<void>*/
+inline Expected<void> expect(Result result) {
+   if (result != OK)
+      return Unexpected{result};
+   return {};
+}
+
+/* maps the Result of a C call and its out value to an Expected*/
+template <typename T>
+Expected<T> expect(Result result, T value) {
+   if (result != OK)
+      return Unexpected{result};
+   return Expected<T>(std::move(value));
+}
+
+class System
+{
+public:
+   /* what destroy_system reports. a name is empty if there was none.*/
+   struct Summary
+   {
+      CString most_popular;
+      CString best_time;
+   };
+
+   static Expected<System> create(const char *init_file) {
+      ChallengeRoomSystem *sys = nullptr;
+      Result result = create_system(const_cast<char *>(init_file), &sys);
+      return expect(result, System(sys));
+   }
+
+   static Expected<System> create_parallel(const char *init_file,
+                                           int num_threads) {
+      ChallengeRoomSystem *sys = nullptr;
+      Result result = create_system_parallel(const_cast<char *>(init_file),
+                                             &sys, num_threads);
+      return expect(result, System(sys));
+   }
+
+   static Expected<System> create_journaled(const char *init_file,
+                                            const char *journal_path,
+                                            int group_size,
+                                            int compact_every) {
+      ChallengeRoomSystem *sys = nullptr;
+      Result result = create_system_journaled(
+              const_cast<char *>(init_file), const_cast<char *>(journal_path),
+              group_size, compact_every, &sys);
+      return expect(result, System(sys));
+   }
+
+   System(const System &) = delete;
+   System &operator=(const System &) = delete;
+
+   System(System &&other) noexcept
+           : sys_(std::exchange(other.sys_, nullptr)) {}
+
+   System &operator=(System &&other) noexcept {
+      if (this != &other) {
+         reset();
+         sys_ = std::exchange(other.sys_, nullptr);
+      }
+      return *this;
+   }
+
+   /* destroys the system at its current time, dropping the summary*/
+   ~System() { reset(); }
+
+   /* the wrapped system, nullptr once moved from or destroyed*/
+   ChallengeRoomSystem *get() const noexcept { return sys_; }
+
+   /* destroys the system at destroy time. on success the handle is empty.*/
+   Expected<Summary> destroy(int destroy_time) {
+      char *most_popular = nullptr, *best_time = nullptr;
+      Result result = destroy_system(sys_, destroy_time, &most_popular,
+                                     &best_time);
+      if (result != OK)
+         return Unexpected{result};
+      sys_ = nullptr;
+      return Summary{CString(most_popular), CString(best_time)};
+   }
+
+   /* applies a changed init file, keeping the visitors and statistics*/
+   Expected<ReloadReport> reload(const char *init_file) {
+      ReloadReport report{};
+      Result result = reload_system(sys_, const_cast<char *>(init_file),
+                                    &report);
+      return expect(result, report);
+   }
+
+   Expected<void> arrive(const char *room_name, const char *visitor_name,
+                         int visitor_id, Level level, int start_time) {
+      return expect(visitor_arrive(sys_, const_cast<char *>(room_name),
+                                   const_cast<char *>(visitor_name),
+                                   visitor_id, level, start_time));
+   }
+
+   /* true if the visitor waits in the room for a challenge of the level*/
+   Expected<bool> arrive_or_wait(const char *room_name,
+                                 const char *visitor_name, int visitor_id,
+                                 Level level, int start_time) {
+      bool waiting = false;
+      Result result = visitor_arrive_or_wait(
+              sys_, const_cast<char *>(room_name),
+              const_cast<char *>(visitor_name), visitor_id, level,
+              start_time, &waiting);
+      return expect(result, waiting);
+   }
+
+   /* the name of the room the visitor entered*/
+   Expected<std::string_view> arrive_any_room(const char *visitor_name,
+                                              int visitor_id, Level level,
+                                              int start_time) {
+      const char *room_name = nullptr;
+      Result result = visitor_arrive_any_room(
+              sys_, const_cast<char *>(visitor_name), visitor_id, level,
+              start_time, &room_name);
+      return expect(result, result == OK ? std::string_view(room_name)
+                                         : std::string_view());
+   }
+
+   Expected<void> quit(int visitor_id, int quit_time) {
+      return expect(visitor_quit(sys_, visitor_id, quit_time));
+   }
+
+   Expected<void> all_quit(int quit_time) {
+      return expect(all_visitors_quit(sys_, quit_time));
+   }
+
+   Expected<std::string_view> room_of_visitor(const char *visitor_name) const {
+      const char *name = nullptr;
+      int length = 0;
+      Result result = system_room_of_visitor_view(
+              sys_, const_cast<char *>(visitor_name), &name, &length);
+      return expect(result, std::string_view(name, (size_t)length));
+   }
+
+   Expected<void> rename_challenge(int challenge_id, const char *new_name) {
+      return expect(change_challenge_name(sys_, challenge_id,
+                                          const_cast<char *>(new_name)));
+   }
+
+   Expected<void> rename_room(const char *current_name,
+                              const char *new_name) {
+      return expect(change_system_room_name(
+              sys_, const_cast<char *>(current_name),
+              const_cast<char *>(new_name)));
+   }
+
+   Expected<int> best_time(const char *challenge_name) const {
+      int time = 0;
+      Result result = best_time_of_system_challenge(
+              sys_, const_cast<char *>(challenge_name), &time);
+      return expect(result, time);
+   }
+
+   /* empty if no challenge was visited*/
+   Expected<std::string_view> most_popular() const {
+      const char *name = nullptr;
+      int length = 0;
+      Result result = most_popular_challenge_view(sys_, &name, &length);
+      return expect(result, name ? std::string_view(name, (size_t)length)
+                                 : std::string_view());
+   }
+
+   /* empty if the window had no visits*/
+   Expected<CString> most_popular_in_window(int window) const {
+      char *name = nullptr;
+      Result result = most_popular_challenge_in_window(sys_, window, &name);
+      return expect(result, CString(name));
+   }
+
+   Expected<int> best_time_in_window(const char *challenge_name,
+                                     int window) const {
+      int time = 0;
+      Result result = best_time_of_system_challenge_in_window(
+              sys_, const_cast<char *>(challenge_name), window, &time);
+      return expect(result, time);
+   }
+
+   Expected<int> completion_percentile(const char *challenge_name,
+                                       double percentile) const {
+      int time = 0;
+      Result result = completion_time_percentile(
+              sys_, const_cast<char *>(challenge_name), percentile, &time);
+      return expect(result, time);
+   }
+
+   Expected<RoomForecast> forecast(const char *room_name, Level level) const {
+      RoomForecast forecast{};
+      Result result = system_room_forecast(sys_, const_cast<char *>(room_name),
+                                           level, &forecast);
+      return expect(result, forecast);
+   }
+
+   /* places may be nullptr, or hold one count per room*/
+   Expected<int> free_places(Level level, int *places = nullptr) const {
+      int total = 0;
+      Result result = system_free_places(sys_, level, places, &total);
+      return expect(result, total);
+   }
+
+   Expected<void> start_executor(int num_workers) {
+      return expect(start_system_executor(sys_, num_workers));
+   }
+
+   Expected<void> attach_journal(const char *journal_path, int group_size,
+                                 int compact_every) {
+      return expect(attach_system_journal(
+              sys_, const_cast<char *>(journal_path), group_size,
+              compact_every));
+   }
+
+   Expected<void> sync_journal() {
+      return expect(sync_system_journal(sys_));
+   }
+
+private:
+   explicit System(ChallengeRoomSystem *sys) noexcept : sys_(sys) {}
+
+   void reset() noexcept {
+      if (sys_ == nullptr)
+         return;
+      char *most_popular = nullptr, *best_time = nullptr;
+      if (destroy_system(sys_, sys_->time_log, &most_popular,
+                         &best_time) == OK) {
+         std::free(most_popular);
+         std::free(best_time);
+      }
+      sys_ = nullptr;
+   }
+
+   ChallengeRoomSystem *sys_ = nullptr;
+};
+
+} // namespace challenge_system
+
+#endif // CHALLENGE_SYSTEM_HPP_
@@ -0,0 +1,492 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "challenge_system.h"
+#include "latency_histogram.h"
+#include "venue_manager.h"
+#include "system_journal.h"
+
+/* Microbenchmarks the public functions of challenge_system.h and
+ * visitor_room.h over growing systems. Every system of size N has N
+ * challenges, N rooms of BENCH_SLOTS slots and N visitors already inside.
+ * Usage: bench [--json] [--iterations N] [--max-size N]
+ * The results are printed as CSV (or JSON lines) to stdout.*/
+
+//Defines:
+#define BENCH_INIT_FILE "bench_init.txt"
+#define BENCH_SLOTS 4
+#define DEFAULT_ITERATIONS 1000
+#define DEFAULT_MAX_SIZE 4096
+#define MIN_SIZE 16
+#define SIZE_FACTOR 4
+#define NAME_LENGTH 51
+#define BENCH_VENUES 8
+#define BENCH_SHARDS 4
+#define BENCH_THREADS 4
+#define BENCH_JOURNAL_FILE "bench_journal.bin"
+#define BENCH_JOURNAL_GROUP 64
+
+typedef struct SBenchOptions
+{
+   bool json;
+   int iterations;
+   int max_size;
+} BenchOptions;
+
+/* time the statement into the histogram*/
+#define BENCH_TIME(histogram, statement) \
+   { unsigned long long bench_start = current_time_ns(); \
+     statement; \
+     record_value((histogram), current_time_ns() - bench_start); }
+
+//Static functions list:
+static Result write_init_file(int size);
+static Result build_system(int size, ChallengeRoomSystem **sys, int *time);
+static void discard_system(ChallengeRoomSystem *sys, int time);
+static void report(BenchOptions *options, char *function, int size,
+                   LatencyHistogram *histogram);
+static void bench_lifecycle(BenchOptions *options, int size);
+static void bench_visitors(BenchOptions *options, int size);
+static void bench_queries(BenchOptions *options, int size);
+static void bench_batch_rename(BenchOptions *options, int size);
+static void bench_room(BenchOptions *options, int size);
+static int count_free_branching(ChallengeRoom *room, Level level);
+static void bench_venues(BenchOptions *options, int size);
+
+
+int main(int argc, char **argv){
+    BenchOptions options = {false, DEFAULT_ITERATIONS, DEFAULT_MAX_SIZE};
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--json"))
+            options.json = true;
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            options.iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--max-size") && i + 1 < argc)
+            options.max_size = atoi(argv[++i]);
+        else {
+            printf("usage: bench [--json] [--iterations N] [--max-size N]\n");
+            return 1;
+        }
+    }
+    if (!options.json)
+        printf("function,size,iterations,mean_ns,p50_ns,p99_ns,max_ns\n");
+    for (int size = MIN_SIZE; size <= options.max_size; size *= SIZE_FACTOR) {
+        if (write_init_file(size) != OK){
+            printf("Error: cannot write %s.\n", BENCH_INIT_FILE);
+            return 1;
+        }
+        bench_lifecycle(&options, size);
+        bench_visitors(&options, size);
+        bench_queries(&options, size);
+        bench_batch_rename(&options, size);
+        bench_room(&options, size);
+        bench_venues(&options, size);
+    }
+    remove(BENCH_INIT_FILE);
+    return 0;
+}
+
+//static functions
+
+/*  Function writes an init file with size challenges and size rooms.
+ * Error Codes: ILLEGAL_PARAMETER if the file can't be opened*/
+static Result write_init_file(int size){
+    FILE *file = fopen(BENCH_INIT_FILE, "w");
+    if (!file)
+        return ILLEGAL_PARAMETER;
+    fprintf(file, "bench_system\n%d\n", size);
+    for (int i = 1; i <= size; ++i) {
+        fprintf(file, "challenge_%d %d %d\n", i, i, 1 + i % 3);
+    }
+    fprintf(file, "%d\n", size);
+    for (int i = 0; i < size; ++i) {
+        fprintf(file, "room_%d %d", i, BENCH_SLOTS);
+        for (int j = 0; j < BENCH_SLOTS; ++j) {
+            fprintf(file, " %d", 1 + (i * BENCH_SLOTS + j) % size);
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    return OK;
+}
+
+/*  Function creates the system from the bench init file and lets size
+ * visitors (ids 0..size-1) in, one per room.
+ * Error Codes: the result of the first failing system call*/
+static Result build_system(int size, ChallengeRoomSystem **sys, int *time){
+    Result result = create_system(BENCH_INIT_FILE, sys);
+    if (result != OK)
+        return result;
+    char room[NAME_LENGTH], visitor[NAME_LENGTH];
+    *time = 0;
+    for (int i = 0; i < size && result == OK; ++i) {
+        sprintf(room, "room_%d", i);
+        sprintf(visitor, "visitor_%d", i);
+        result = visitor_arrive(*sys, room, visitor, i, All_Levels, ++*time);
+    }
+    return result;
+}
+
+/*  Function destroys the system and releases the names it returns.*/
+static void discard_system(ChallengeRoomSystem *sys, int time){
+    char *most_popular = NULL, *best_time = NULL;
+    if (destroy_system(sys, time, &most_popular, &best_time) == OK){
+        free(most_popular);
+        free(best_time);
+    }
+}
+
+/*  Function prints one result line.*/
+static void report(BenchOptions *options, char *function, int size,
+                   LatencyHistogram *histogram){
+    unsigned long long p50, p99;
+    histogram_percentile(histogram, 50, &p50);
+    histogram_percentile(histogram, 99, &p99);
+    unsigned long long mean = histogram->total_count == 0 ? 0 :
+                           histogram->total_value / histogram->total_count;
+    if (options->json)
+        printf("{\"function\":\"%s\",\"size\":%d,\"iterations\":%llu,"
+               "\"mean_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,"
+               "\"max_ns\":%llu}\n", function, size, histogram->total_count,
+               mean, p50, p99, histogram->max_value);
+    else
+        printf("%s,%d,%llu,%llu,%llu,%llu,%llu\n", function, size,
+               histogram->total_count, mean, p50, p99, histogram->max_value);
+}
+
+/*  Function measures create_system and destroy_system (serial and parallel)
+ * and all_visitors_quit (in place and on an executor).
+ * these rebuild the whole system, so they run fewer iterations.*/
+static void bench_lifecycle(BenchOptions *options, int size){
+    LatencyHistogram create, create_parallel, all_quit, destroy;
+    LatencyHistogram destroy_parallel, all_quit_executor;
+    reset_histogram(&create);
+    reset_histogram(&create_parallel);
+    reset_histogram(&all_quit);
+    reset_histogram(&destroy);
+    reset_histogram(&destroy_parallel);
+    reset_histogram(&all_quit_executor);
+    int rounds = options->iterations / size + 1;
+    for (int i = 0; i < rounds; ++i) {
+        ChallengeRoomSystem *sys = NULL;
+        BENCH_TIME(&create, create_system(BENCH_INIT_FILE, &sys));
+        discard_system(sys, 0);
+        BENCH_TIME(&create_parallel,
+                   create_system_parallel(BENCH_INIT_FILE, &sys,
+                                          BENCH_THREADS));
+        discard_system(sys, 0);
+        int time;
+        if (build_system(size, &sys, &time) != OK)
+            return;
+        BENCH_TIME(&all_quit, all_visitors_quit(sys, ++time));
+        discard_system(sys, time);
+        if (build_system(size, &sys, &time) != OK)
+            return;
+        start_system_executor(sys, BENCH_THREADS);
+        BENCH_TIME(&all_quit_executor, all_visitors_quit(sys, ++time));
+        discard_system(sys, time);
+        if (build_system(size, &sys, &time) != OK)
+            return;
+        char *most_popular = NULL, *best_time = NULL;
+        BENCH_TIME(&destroy, destroy_system(sys, ++time, &most_popular,
+                                            &best_time));
+        free(most_popular);
+        free(best_time);
+        if (build_system(size, &sys, &time) != OK)
+            return;
+        BENCH_TIME(&destroy_parallel,
+                   destroy_system_parallel(sys, ++time, &most_popular,
+                                           &best_time, BENCH_THREADS));
+        free(most_popular);
+        free(best_time);
+    }
+    report(options, "create_system", size, &create);
+    report(options, "create_system_parallel", size, &create_parallel);
+    report(options, "all_visitors_quit", size, &all_quit);
+    report(options, "all_visitors_quit_executor", size, &all_quit_executor);
+    report(options, "destroy_system", size, &destroy);
+    report(options, "destroy_system_parallel", size, &destroy_parallel);
+}
+
+/*  Function measures visitor_arrive and visitor_quit next to size visitors
+ * that are already in the system, visitor_arrive_any_room, and then
+ * visitor_arrive and visitor_quit with a journal.*/
+static void bench_visitors(BenchOptions *options, int size){
+    ChallengeRoomSystem *sys = NULL;
+    int time;
+    if (build_system(size, &sys, &time) != OK)
+        return;
+    LatencyHistogram arrive, quit, arrive_any, arrive_journaled, quit_journaled;
+    reset_histogram(&arrive);
+    reset_histogram(&arrive_any);
+    reset_histogram(&quit);
+    reset_histogram(&arrive_journaled);
+    reset_histogram(&quit_journaled);
+    char room[NAME_LENGTH];
+    for (int i = 0; i < options->iterations; ++i) {
+        sprintf(room, "room_%d", i % size);
+        BENCH_TIME(&arrive, visitor_arrive(sys, room, "bench_visitor", -2,
+                                           All_Levels, ++time));
+        BENCH_TIME(&quit, visitor_quit(sys, -2, ++time));
+    }
+    for (int i = 0; i < options->iterations; ++i) {
+        BENCH_TIME(&arrive_any, visitor_arrive_any_room(sys, "bench_visitor",
+                                                        -2, All_Levels,
+                                                        ++time, NULL));
+        visitor_quit(sys, -2, ++time);
+    }
+    remove(BENCH_JOURNAL_FILE);
+    bool journaled = attach_system_journal(sys, BENCH_JOURNAL_FILE,
+                                           BENCH_JOURNAL_GROUP, 0) == OK;
+    for (int i = 0; i < options->iterations && journaled; ++i) {
+        sprintf(room, "room_%d", i % size);
+        BENCH_TIME(&arrive_journaled, visitor_arrive(sys, room,
+                                                     "bench_visitor", -2,
+                                                     All_Levels, ++time));
+        BENCH_TIME(&quit_journaled, visitor_quit(sys, -2, ++time));
+    }
+    discard_system(sys, ++time);
+    remove(BENCH_JOURNAL_FILE);
+    report(options, "visitor_arrive", size, &arrive);
+    report(options, "visitor_quit", size, &quit);
+    report(options, "visitor_arrive_any_room", size, &arrive_any);
+    if (journaled){
+        report(options, "visitor_arrive_journaled", size, &arrive_journaled);
+        report(options, "visitor_quit_journaled", size, &quit_journaled);
+    }
+}
+
+/*  Function measures the lookups, renames and reports of a full system.*/
+static void bench_queries(BenchOptions *options, int size){
+    ChallengeRoomSystem *sys = NULL;
+    int time;
+    if (build_system(size, &sys, &time) != OK)
+        return;
+    LatencyHistogram room_of, popular, best, challenge_rename, room_rename;
+    LatencyHistogram occupancy, room_of_view, popular_view, memory;
+    OccupancyEntry *entries = malloc(sizeof(*entries) * size);
+    if (!entries){
+        discard_system(sys, time);
+        return;
+    }
+    reset_histogram(&occupancy);
+    reset_histogram(&memory);
+    reset_histogram(&room_of_view);
+    reset_histogram(&popular_view);
+    reset_histogram(&room_of);
+    reset_histogram(&popular);
+    reset_histogram(&best);
+    reset_histogram(&challenge_rename);
+    reset_histogram(&room_rename);
+    char name[NAME_LENGTH], new_name[NAME_LENGTH];
+    for (int i = 0; i < options->iterations; ++i) {
+        char *result = NULL;
+        int best_time;
+        sprintf(name, "visitor_%d", i % size);
+        BENCH_TIME(&room_of, system_room_of_visitor(sys, name, &result));
+        free(result);
+        result = NULL;
+        BENCH_TIME(&popular, most_popular_challenge(sys, &result));
+        free(result);
+        const char *view = NULL;
+        int length;
+        BENCH_TIME(&room_of_view, system_room_of_visitor_view(sys, name, &view,
+                                                             &length));
+        BENCH_TIME(&popular_view, most_popular_challenge_view(sys, &view,
+                                                              &length));
+        sprintf(name, "challenge_%d", 1 + i % size);
+        BENCH_TIME(&best, best_time_of_system_challenge(sys, name,
+                                                        &best_time));
+        BENCH_TIME(&challenge_rename, change_challenge_name(sys, 1 + i % size,
+                                                            name));
+        sprintf(name, "room_%d", i % size);
+        strcpy(new_name, name);
+        BENCH_TIME(&room_rename, change_system_room_name(sys, name,
+                                                         new_name));
+        int count;
+        BENCH_TIME(&occupancy, system_occupancy(sys, entries, size, &count));
+        MemoryUsage usage;
+        BENCH_TIME(&memory, system_memory(sys, &usage));
+    }
+    free(entries);
+    discard_system(sys, ++time);
+    report(options, "system_room_of_visitor", size, &room_of);
+    report(options, "most_popular_challenge", size, &popular);
+    report(options, "system_room_of_visitor_view", size, &room_of_view);
+    report(options, "most_popular_challenge_view", size, &popular_view);
+    report(options, "best_time_of_system_challenge", size, &best);
+    report(options, "change_challenge_name", size, &challenge_rename);
+    report(options, "change_system_room_name", size, &room_rename);
+    report(options, "system_occupancy", size, &occupancy);
+    report(options, "system_memory", size, &memory);
+}
+
+/*  Function measures renaming every challenge to a name too long to be kept
+ * inline, with one change_challenge_names call and then with a loop of
+ * change_challenge_name calls. each sample is a whole round of renames.*/
+static void bench_batch_rename(BenchOptions *options, int size){
+    if (size <= 0)
+        return;
+    ChallengeRoomSystem *sys = NULL;
+    if (create_system(BENCH_INIT_FILE, &sys) != OK)
+        return;
+    ChallengeRename *renames = malloc(sizeof(*renames) * size);
+    char *names = malloc((size_t)size * NAME_LENGTH);
+    if (!renames || !names){
+        free(renames);
+        free(names);
+        discard_system(sys, 0);
+        return;
+    }
+    LatencyHistogram batch, loop;
+    reset_histogram(&batch);
+    reset_histogram(&loop);
+    int rounds = options->iterations / size + 1;
+    for (int i = 0; i < rounds; ++i) {
+        for (int j = 0; j < size; ++j) {
+            renames[j].challenge_id = j + 1;
+            renames[j].new_name = names + (size_t)j * NAME_LENGTH;
+            snprintf(names + (size_t)j * NAME_LENGTH, NAME_LENGTH,
+                     "seasonal_%d_challenge_number_%d", 2 * i, j + 1);
+        }
+        BENCH_TIME(&batch, change_challenge_names(sys, renames, size));
+        for (int j = 0; j < size; ++j) {
+            snprintf(names + (size_t)j * NAME_LENGTH, NAME_LENGTH,
+                     "seasonal_%d_challenge_number_%d", 2 * i + 1, j + 1);
+        }
+        BENCH_TIME(&loop, for (int j = 0; j < size; ++j)
+                              change_challenge_name(sys,
+                                                    renames[j].challenge_id,
+                                                    renames[j].new_name));
+    }
+    free(renames);
+    free(names);
+    discard_system(sys, 0);
+    report(options, "change_challenge_names", size, &batch);
+    report(options, "change_challenge_name_loop", size, &loop);
+}
+
+/*  Function measures the visitor_room.h functions on a standalone room with
+ * size slots.*/
+static void bench_room(BenchOptions *options, int size){
+    Challenge *challenges = malloc(sizeof(*challenges) * size);
+    if (!challenges)
+        return;
+    char name[NAME_LENGTH];
+    for (int i = 0; i < size; ++i) {
+        sprintf(name, "challenge_%d", size - i);
+        init_challenge(&challenges[i], i, name, (Level)(i % 3));
+    }
+    LatencyHistogram init, reset, free_places, free_places_branch, enter, quit;
+    LatencyHistogram room_of, rename;
+    reset_histogram(&init);
+    reset_histogram(&reset);
+    reset_histogram(&free_places);
+    reset_histogram(&free_places_branch);
+    reset_histogram(&enter);
+    reset_histogram(&quit);
+    reset_histogram(&room_of);
+    reset_histogram(&rename);
+    ChallengeRoom room;
+    VisitorTable table;
+    memset(&table, 0, sizeof(table));
+    VisitorHandle handle;
+    if (reserve_visitor_rooms(&table, 1) != OK ||
+        take_visitor_record(&table, &handle) != OK){
+        destroy_visitor_table(&table);
+        free(challenges);
+        return;
+    }
+    Visitor *visitor = VISITOR_RECORD(&table, handle);
+    init_visitor(visitor, "bench_visitor", 1);
+    for (int i = 0; i < options->iterations; ++i) {
+        BENCH_TIME(&init, init_room(&room, "bench_room", size));
+        for (int j = 0; j < size; ++j) {
+            init_challenge_activity(&room.challenges[j], &challenges[j]);
+        }
+        add_visitor_room(&table, &room);
+        int places;
+        BENCH_TIME(&free_places, num_of_free_places_for_level(&room,
+                                                    (Level)(i % 4), &places));
+        BENCH_TIME(&free_places_branch,
+                   places = count_free_branching(&room, (Level)(i % 4)));
+        BENCH_TIME(&enter, visitor_enter_room(&room, visitor,
+                                              (Level)(i % 4), i));
+        char *room_name = NULL;
+        BENCH_TIME(&room_of, room_of_visitor(&table, visitor, &room_name));
+        free(room_name);
+        BENCH_TIME(&rename, change_room_name(&room, "bench_room"));
+        BENCH_TIME(&quit, visitor_quit_room(&table, visitor, i + 1));
+        remove_visitor_room(&table, &room);
+        BENCH_TIME(&reset, reset_room(&room));
+    }
+    destroy_visitor_table(&table); //resets the visitor.
+    for (int i = 0; i < size; ++i) {
+        reset_challenge(&challenges[i]);
+    }
+    free(challenges);
+    report(options, "init_room", size, &init);
+    report(options, "num_of_free_places_for_level", size, &free_places);
+    report(options, "free_places_level_branch", size, &free_places_branch);
+    report(options, "visitor_enter_room", size, &enter);
+    report(options, "room_of_visitor", size, &room_of);
+    report(options, "change_room_name", size, &rename);
+    report(options, "visitor_quit_room", size, &quit);
+    report(options, "reset_room", size, &reset);
+}
+
+/*  Function counts the free places of a level with the level tested on every
+ * slot, the way the room scans did before their per level kernels. it is
+ * timed next to num_of_free_places_for_level for comparison.*/
+static int count_free_branching(ChallengeRoom *room, Level level){
+    int sum = 0;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        if (room->challenges[i].visitor == NULL &&
+            (level == All_Levels ||
+             room->challenges[i].challenge->level == level))
+            sum++;
+    }
+    return sum;
+}
+
+/*  Function measures the venue manager: routed arrivals and quits, and the
+ * cross venue queries over BENCH_VENUES venues on BENCH_SHARDS shards.*/
+static void bench_venues(BenchOptions *options, int size){
+    char *init_files[BENCH_VENUES];
+    for (int i = 0; i < BENCH_VENUES; ++i) {
+        init_files[i] = BENCH_INIT_FILE;
+    }
+    VenueManager *manager = NULL;
+    if (create_venue_manager(init_files, BENCH_VENUES, BENCH_SHARDS,
+                             &manager) != OK)
+        return;
+    LatencyHistogram arrive, quit, popular, best;
+    reset_histogram(&arrive);
+    reset_histogram(&quit);
+    reset_histogram(&popular);
+    reset_histogram(&best);
+    char room[NAME_LENGTH];
+    int time = 0;
+    for (int i = 0; i < options->iterations; ++i) {
+        int venue = i % BENCH_VENUES;
+        sprintf(room, "room_%d", i % size);
+        BENCH_TIME(&arrive, venue_visitor_arrive(manager, venue, room,
+                                                 "bench_visitor", i,
+                                                 All_Levels, ++time));
+        BENCH_TIME(&quit, venue_visitor_quit(manager, venue, i, ++time));
+        char *name = NULL;
+        BENCH_TIME(&popular, global_most_popular_challenge(manager, &name,
+                                                           NULL));
+        free(name);
+        name = NULL;
+        BENCH_TIME(&best, global_best_time(manager, &name, NULL, NULL));
+        free(name);
+    }
+    destroy_venue_manager(manager, ++time);
+    report(options, "venue_visitor_arrive", size, &arrive);
+    report(options, "venue_visitor_quit", size, &quit);
+    report(options, "global_most_popular_challenge", size, &popular);
+    report(options, "global_best_time", size, &best);
+}
@@ -4,11 +4,1248 @@
 #include <assert.h>
 
 #include "challenge_system.h"
+#include "system_journal.h"
+#include "room_load.h"
+#include "venue_manager.h"
 
 #define ASSERT(test_number, test_condition)  \
    if (!(test_condition)) {printf("\nTEST %s FAILED", test_number); } \
    else printf("\nTEST %s OK", test_number);
 
+static void latency_test(void)
+{
+   LatencyHistogram histogram;
+   reset_histogram(&histogram);
+   for (unsigned long long value = 1; value <= 100; ++value)
+      record_value(&histogram, value);
+   unsigned long long p50=0, p99=0;
+   Result r=histogram_percentile(&histogram, 50, &p50);
+   ASSERT("2.1" , r==OK && p50>=50 && p50<=50+50/HISTOGRAM_SUB_BUCKETS)
+   r=histogram_percentile(&histogram, 99, &p99);
+   ASSERT("2.2" , r==OK && p99>=99 && p99<=100)
+   r=histogram_percentile(&histogram, 101, &p99);
+   ASSERT("2.3" , r==ILLEGAL_PARAMETER)
+
+#ifdef CHALLENGE_SYSTEM_STATS
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   SystemStats stats;
+   r=system_stats(sys, &stats);
+   ASSERT("2.4" , r==OK && stats.api[API_CREATE_SYSTEM].calls==1 &&
+                  stats.allocations>0 &&
+                  stats.api[API_VISITOR_ARRIVE].calls==0)
+   visitor_arrive(sys, "room_1", "visitor_1", 201, Easy, 5);
+   system_stats(sys, &stats);
+   ASSERT("2.5" , stats.api[API_VISITOR_ARRIVE].calls==1 &&
+                  stats.string_compares>0 && stats.nodes_traversed>0)
+   SystemStats before=stats;
+   visitor_arrive(sys, "room_1", "visitor_2", 202, Easy, 6);
+   //a failed call is timed and counted too.
+   visitor_arrive(sys, "room_9", "visitor_3", 203, Easy, 7);
+   system_stats(sys, &stats);
+   ASSERT("2.6" , stats.api[API_VISITOR_ARRIVE].calls==3 &&
+                   stats.api[API_VISITOR_ARRIVE].nanoseconds>
+                   before.api[API_VISITOR_ARRIVE].nanoseconds &&
+                   stats.string_compares>before.string_compares &&
+                   stats.nodes_traversed>before.nodes_traversed)
+   char *room=NULL;
+   system_room_of_visitor(sys, "visitor_1", &room);
+   free(room);
+   before=stats;
+   system_stats(sys, &stats);
+   ASSERT("2.7" , stats.api[API_SYSTEM_ROOM_OF_VISITOR].calls==1 &&
+                   stats.allocations==before.allocations+1 &&
+                   stats.api[API_VISITOR_ARRIVE].calls==3)
+   r=system_latency(sys, API_VISITOR_ARRIVE, &histogram);
+   ASSERT("2.8" , r==OK && histogram.total_count==3)
+   r=histogram_percentile(&histogram, 99, &p99);
+   ASSERT("2.9" , r==OK && p99>=histogram.min_value && p99<=histogram.max_value)
+   r=system_latency(sys, API_VISITOR_QUIT, &histogram);
+   ASSERT("2.10" , r==OK && histogram.total_count==0)
+   reset_system_stats(sys);
+   r=system_latency(sys, API_VISITOR_ARRIVE, &histogram);
+   ASSERT("2.11" , r==OK && histogram.total_count==0)
+   system_stats(sys, &stats);
+   bool zero=stats.string_compares==0 && stats.nodes_traversed==0 &&
+             stats.allocations==0;
+   for (int api=0; api<API_COUNT; ++api)
+      zero=zero && stats.api[api].calls==0 && stats.api[api].nanoseconds==0;
+   ASSERT("2.12" , zero)
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 8, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+#endif
+}
+
+
+static void parallel_init_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   char *most_popular=NULL, *best_time=NULL;
+   Result r=create_system_parallel("test_1.txt", &sys, 3);
+   ASSERT("3.1" , r==OK && sys!=NULL && sys->room_array_size==4)
+   r=visitor_arrive(sys, "room_4", "visitor_1", 201, Hard, 5);
+   ASSERT("3.2" , r==OK)
+   r=destroy_system(sys, 9, &most_popular, &best_time);
+   ASSERT("3.3" , r==OK && strcmp(best_time, "challenge_5")==0)
+   free(most_popular);
+   free(best_time);
+
+   sys=NULL;
+   r=create_system_parallel("test_bad_room.txt", &sys, 1);
+   ASSERT("3.4" , r==ILLEGAL_PARAMETER && sys==NULL)
+   r=create_system_parallel("test_bad_room.txt", &sys, 3);
+   ASSERT("3.5" , r==ILLEGAL_PARAMETER && sys==NULL)
+   r=create_system_parallel("test_1.txt", &sys, 0);
+   ASSERT("3.6" , r==ILLEGAL_PARAMETER && sys==NULL)
+}
+
+static void most_popular_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   char *name=NULL;
+   create_system("test_1.txt", &sys);
+   Result r=most_popular_challenge(sys, &name);
+   ASSERT("4.1" , r==OK && name==NULL)
+
+   visitor_arrive(sys, "room_2", "visitor_1", 201, Medium, 1);
+   visitor_quit(sys, 201, 2);
+   r=most_popular_challenge(sys, &name);
+   ASSERT("4.2" , r==OK && name!=NULL && strcmp(name, "challenge_2")==0)
+   free(name);
+
+   visitor_arrive(sys, "room_1", "visitor_2", 202, Easy, 3);
+   visitor_arrive(sys, "room_1", "visitor_3", 203, Easy, 3);
+   visitor_quit(sys, 203, 4);
+   visitor_arrive(sys, "room_1", "visitor_4", 204, Easy, 5);
+   visitor_quit(sys, 204, 6);
+   r=most_popular_challenge(sys, &name);
+   ASSERT("4.3" , r==OK && name!=NULL && strcmp(name, "challenge_4")==0)
+   free(name);
+
+   visitor_quit(sys, 202, 7);
+   visitor_arrive(sys, "room_1", "visitor_5", 205, Easy, 8);
+   visitor_quit(sys, 205, 9);
+   r=most_popular_challenge(sys, &name);
+   ASSERT("4.4" , r==OK && name!=NULL && strcmp(name, "challenge_1")==0)
+   free(name);
+
+   char *most_popular=NULL, *best_time=NULL;
+   r=destroy_system_parallel(sys, 10, &most_popular, &best_time, 2);
+   ASSERT("4.5" , r==OK && most_popular!=NULL &&
+                  strcmp(most_popular, "challenge_1")==0)
+   free(most_popular);
+   free(best_time);
+}
+
+static void fill_rooms(ChallengeRoomSystem *sys)
+{
+   char *rooms[]={"room_1", "room_2", "room_3", "room_4"};
+   Level levels[]={Easy, Medium, Hard, All_Levels};
+   char name[16];
+   for (int i=0; i<24; ++i) {
+      sprintf(name, "visitor_%d", i);
+      visitor_arrive(sys, rooms[i%4], name, 300+i, levels[(i/4)%4], i);
+      if (i%5==4)
+         visitor_quit(sys, 300+i-2, i);
+   }
+}
+
+static void executor_quit_test(void)
+{
+   ChallengeRoomSystem *serial=NULL, *parallel=NULL;
+   create_system("test_1.txt", &serial);
+   create_system("test_1.txt", &parallel);
+   Result r=start_system_executor(parallel, 3);
+   ASSERT("5.1" , r==OK)
+   for (int round=0; round<2; ++round) {
+      fill_rooms(serial);
+      fill_rooms(parallel);
+      r=all_visitors_quit(serial, 40);
+      ASSERT("5.2" , r==OK)
+      r=all_visitors_quit(parallel, 40);
+      ASSERT("5.3" , r==OK)
+   }
+   bool same=serial->challenge_array_size==parallel->challenge_array_size;
+   for (int i=0; same && i<serial->challenge_array_size; ++i) {
+      Challenge *first=serial->challenges[i], *second=parallel->challenges[i];
+      int first_p90=0, second_p90=0;
+      completion_time_percentile(serial, first->name, 90, &first_p90);
+      completion_time_percentile(parallel, second->name, 90, &second_p90);
+      same=first->best_time==second->best_time &&
+           first->num_visits==second->num_visits &&
+           first->completions.total==second->completions.total &&
+           first_p90==second_p90;
+   }
+   ASSERT("5.4" , same)
+   int places[4], total=0;
+   r=system_free_places(parallel, All_Levels, places, &total);
+   ASSERT("5.5" , r==OK && total==11 && places[3]==4)
+   char *room=NULL;
+   r=system_room_of_visitor(parallel, "visitor_23", &room);
+   ASSERT("5.6" , r==NOT_IN_ROOM)
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(serial, 41, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+   destroy_system(parallel, 41, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static void snapshot_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   int reader=-1;
+   Result r=open_snapshot_reader(sys, &reader);
+   ASSERT("6.1" , r==ILLEGAL_PARAMETER)
+   r=enable_system_snapshots(sys, 0);
+   ASSERT("6.2" , r==OK)
+   r=open_snapshot_reader(sys, &reader);
+   ASSERT("6.3" , r==OK && reader>=0)
+
+   const SystemSnapshot *old=NULL, *current=NULL;
+   r=begin_snapshot_read(sys, reader, &old);
+   ASSERT("6.4" , r==OK && old->num_challenges==6 && old->num_rooms==4 &&
+                  old->most_popular==NULL && old->best_timed==NULL &&
+                  strcmp(old->rooms[0].name, "room_2")==0 &&
+                  old->rooms[0].free_places[All_Levels]==1)
+   //a published snapshot doesn't change while it is read.
+   visitor_arrive(sys, "room_2", "visitor_1", 201, Medium, 5);
+   r=publish_system_snapshot(sys);
+   ASSERT("6.5" , r==OK && old->rooms[0].free_places[Medium]==1 &&
+                  old->most_popular==NULL)
+   unsigned long old_version=old->version;
+   end_snapshot_read(sys, reader);
+   r=begin_snapshot_read(sys, reader, &current);
+   ASSERT("6.6" , r==OK && current->version>old_version &&
+                  current->time==5 &&
+                  current->rooms[0].free_places[Medium]==0 &&
+                  strcmp(current->most_popular, "challenge_2")==0 &&
+                  current->challenges[0].num_visits==1)
+   end_snapshot_read(sys, reader);
+
+   //every second change publishes on its own.
+   enable_system_snapshots(sys, 2);
+   begin_snapshot_read(sys, reader, &current);
+   unsigned long version=current->version;
+   end_snapshot_read(sys, reader);
+   visitor_quit(sys, 201, 7);
+   begin_snapshot_read(sys, reader, &current);
+   ASSERT("6.7" , current->version==version)
+   end_snapshot_read(sys, reader);
+   visitor_arrive(sys, "room_1", "visitor_2", 202, Easy, 8);
+   begin_snapshot_read(sys, reader, &current);
+   ASSERT("6.8" , current->version>version && current->best_timed!=NULL &&
+                  strcmp(current->best_timed, "challenge_2")==0)
+   end_snapshot_read(sys, reader);
+
+   r=close_snapshot_reader(sys, reader);
+   ASSERT("6.9" , r==OK)
+   r=close_snapshot_reader(sys, reader);
+   ASSERT("6.10" , r==ILLEGAL_PARAMETER)
+   int readers[SNAPSHOT_READERS];
+   for (int i=0; i<SNAPSHOT_READERS; ++i)
+      open_snapshot_reader(sys, &readers[i]);
+   r=open_snapshot_reader(sys, &reader);
+   ASSERT("6.11" , r==MEMORY_PROBLEM)
+   for (int i=0; i<SNAPSHOT_READERS; ++i)
+      close_snapshot_reader(sys, readers[i]);
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 9, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static bool same_entry(OccupancyEntry *entry, int room, int challenge_id,
+                       int visitor_id, int start_time)
+{
+   return entry->room==room && entry->challenge_id==challenge_id &&
+          entry->visitor_id==visitor_id && entry->start_time==start_time;
+}
+
+static void occupancy_test(void)
+{
+   for (int threads=0; threads<=3; threads+=3) {
+      ChallengeRoomSystem *sys=NULL;
+      create_system("test_1.txt", &sys);
+      if (threads)
+         start_system_executor(sys, threads);
+      int count=-1;
+      Result r=system_occupancy(sys, NULL, 0, &count);
+      ASSERT("7.1" , r==OK && count==0)
+      visitor_arrive(sys, "room_4", "visitor_3", 203, Hard, 5);
+      visitor_arrive(sys, "room_2", "visitor_1", 201, Medium, 6);
+      visitor_arrive(sys, "room_1", "visitor_2", 202, Easy, 7);
+      OccupancyEntry entries[4];
+      entries[2].room=-1;
+      r=system_occupancy(sys, entries, 2, &count);
+      ASSERT("7.2" , r==OK && count==3 && same_entry(&entries[0], 0, 22, 201, 6)
+                     && same_entry(&entries[1], 1, 11, 202, 7) &&
+                     entries[2].room==-1)
+      r=system_occupancy(sys, entries, 4, &count);
+      ASSERT("7.3" , r==OK && count==3 && same_entry(&entries[2], 3, 55, 203, 5))
+      visitor_quit(sys, 201, 8);
+      r=system_occupancy(sys, entries, 4, &count);
+      ASSERT("7.4" , r==OK && count==2 && same_entry(&entries[0], 1, 11, 202, 7))
+      r=system_occupancy(sys, entries, -1, &count);
+      ASSERT("7.5" , r==ILLEGAL_PARAMETER)
+      r=system_occupancy(sys, NULL, 1, &count);
+      ASSERT("7.6" , r==NULL_PARAMETER)
+      r=system_occupancy(sys, entries, 4, NULL);
+      ASSERT("7.7" , r==NULL_PARAMETER)
+      char *most_popular=NULL, *best_time=NULL;
+      destroy_system(sys, 9, &most_popular, &best_time);
+      free(most_popular);
+      free(best_time);
+   }
+}
+
+static void name_view_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   const char *name=NULL;
+   int length=-1;
+   Result r=most_popular_challenge_view(sys, &name, &length);
+   ASSERT("8.1" , r==OK && name==NULL && length==0)
+   visitor_arrive(sys, "room_3", "visitor_1", 201, Hard, 5);
+   r=system_room_of_visitor_view(sys, "visitor_1", &name, &length);
+   ASSERT("8.2" , r==OK && strcmp(name, "room_3")==0 && length==6)
+   r=change_system_room_name(sys, "room_3", "a_room_with_a_long_name_on_the_heap");
+   r=system_room_of_visitor_view(sys, "visitor_1", &name, NULL);
+   ASSERT("8.3" , r==OK && strcmp(name, "a_room_with_a_long_name_on_the_heap")==0)
+   char *copy=NULL;
+   system_room_of_visitor(sys, "visitor_1", &copy);
+   ASSERT("8.4" , copy!=NULL && copy!=name && strcmp(copy, name)==0)
+   free(copy);
+   r=most_popular_challenge_view(sys, &name, &length);
+   ASSERT("8.5" , r==OK && strcmp(name, "challenge_3")==0 && length==11)
+   r=system_room_of_visitor_view(sys, "visitor_9", &name, &length);
+   ASSERT("8.6" , r==NOT_IN_ROOM)
+   r=system_room_of_visitor_view(sys, NULL, &name, &length);
+   ASSERT("8.7" , r==ILLEGAL_PARAMETER)
+   r=system_room_of_visitor_view(NULL, "visitor_1", &name, &length);
+   ASSERT("8.8" , r==NULL_PARAMETER)
+   r=most_popular_challenge_view(sys, NULL, &length);
+   ASSERT("8.9" , r==NULL_PARAMETER)
+   visitor_quit(sys, 201, 6);
+   r=system_room_of_visitor_view(sys, "visitor_1", &name, &length);
+   ASSERT("8.10" , r==NOT_IN_ROOM)
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 9, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static void window_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   char *name=NULL;
+   int time=0;
+   create_system("test_1.txt", &sys);
+   Result r=set_system_window_width(sys, 10);
+   ASSERT("9.1" , r==OK)
+
+   visitor_arrive(sys, "room_2", "visitor_1", 201, Medium, 1);
+   visitor_quit(sys, 201, 2);
+   visitor_arrive(sys, "room_2", "visitor_2", 202, Medium, 15);
+   visitor_quit(sys, 202, 22);
+   //20 time units back from 22 reach the quit at 2, but only whole periods
+   //are counted, so the window starts at 10.
+   r=best_time_of_system_challenge_in_window(sys, "challenge_2", 20, &time);
+   ASSERT("9.2" , r==OK && time==7)
+   r=best_time_of_system_challenge_in_window(sys, "challenge_2", 21, &time);
+   ASSERT("9.3" , r==OK && time==1)
+   //the visit at 15 is in the period before the one of now.
+   r=most_popular_challenge_in_window(sys, 10, &name);
+   ASSERT("9.4" , r==OK && name==NULL)
+   r=most_popular_challenge_in_window(sys, 11, &name);
+   ASSERT("9.5" , r==OK && name!=NULL && strcmp(name, "challenge_2")==0)
+   free(name);
+
+   visitor_arrive(sys, "room_2", "visitor_3", 203, Medium, 235);
+   visitor_quit(sys, 203, 239);
+   r=best_time_of_system_challenge_in_window(sys, "challenge_2", 1000, &time);
+   ASSERT("9.6" , r==OK && time==1)
+   //the period of 241 takes the bucket of the period of 2.
+   visitor_arrive(sys, "room_2", "visitor_4", 204, Medium, 239);
+   visitor_quit(sys, 204, 241);
+   r=best_time_of_system_challenge_in_window(sys, "challenge_2", 1000, &time);
+   ASSERT("9.7" , r==OK && time==2)
+
+   visitor_arrive(sys, "room_2", "visitor_5", 205, Medium, 600);
+   r=best_time_of_system_challenge_in_window(sys, "challenge_2", 1000, &time);
+   ASSERT("9.8" , r==OK && time==0)
+   r=most_popular_challenge_in_window(sys, 1, &name);
+   ASSERT("9.9" , r==OK && name!=NULL && strcmp(name, "challenge_2")==0)
+   free(name);
+   r=best_time_of_system_challenge(sys, "challenge_2", &time);
+   ASSERT("9.10" , r==OK && time==1)
+   r=most_popular_challenge_in_window(sys, 0, &name);
+   ASSERT("9.11" , r==ILLEGAL_PARAMETER)
+   r=set_system_window_width(sys, 0);
+   ASSERT("9.12" , r==ILLEGAL_PARAMETER)
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 601, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static void completion_sketch_test(void)
+{
+   Challenge challenge;
+   Result r=init_challenge(&challenge, 1, "challenge_1", Easy);
+   ASSERT("10.1" , r==OK && sizeof(Challenge)<1024)
+   for (int i=0; i<COMPLETION_COUNT_MAX+100; ++i)
+      record_challenge_completion(&challenge, 1, 3);
+   for (int i=0; i<10; ++i)
+      record_challenge_completion(&challenge, 1, 1000);
+   //the bucket of 3 stopped counting, the other one didn't.
+   ASSERT("10.2" , challenge.completions.total==COMPLETION_COUNT_MAX+10)
+   int time=0;
+   r=challenge_completion_percentile(&challenge, 50, &time);
+   ASSERT("10.3" , r==OK && time==3)
+   r=challenge_completion_percentile(&challenge, 100, &time);
+   ASSERT("10.4" , r==OK && time==1000)
+   reset_challenge(&challenge);
+}
+
+static bool same_systems(ChallengeRoomSystem *first,
+                         ChallengeRoomSystem *second)
+{
+   if (first->time_log!=second->time_log ||
+       first->challenge_array_size!=second->challenge_array_size)
+      return false;
+   for (int i=0; i<first->challenge_array_size; ++i) {
+      Challenge *one=first->challenges[i], *other=second->challenges[i];
+      if (strcmp(one->name, other->name)!=0 ||
+          one->num_visits!=other->num_visits ||
+          one->best_time!=other->best_time)
+         return false;
+   }
+   int first_places[4], second_places[4], first_total=0, second_total=0;
+   system_free_places(first, All_Levels, first_places, &first_total);
+   system_free_places(second, All_Levels, second_places, &second_total);
+   if (first_total!=second_total ||
+       memcmp(first_places, second_places, sizeof(first_places))!=0)
+      return false;
+   char *names[]={"visitor_1", "visitor_2", "visitor_3", "visitor_4"};
+   for (int i=0; i<4; ++i) {
+      char *first_room=NULL, *second_room=NULL;
+      Result first_result=system_room_of_visitor(first, names[i], &first_room);
+      Result second_result=system_room_of_visitor(second, names[i],
+                                                  &second_room);
+      bool same=first_result==second_result &&
+                (first_room==NULL)==(second_room==NULL) &&
+                (first_room==NULL || strcmp(first_room, second_room)==0);
+      free(first_room);
+      free(second_room);
+      if (!same)
+         return false;
+   }
+   return true;
+}
+
+static void journal_test(void)
+{
+   char *path="journal_test.jnl";
+   remove(path);
+   ChallengeRoomSystem *sys=NULL, *reference=NULL;
+   Result r=create_system_journaled("test_1.txt", path, 2, 0, &sys);
+   ASSERT("11.1" , r==OK)
+   create_system("test_1.txt", &reference);
+   ChallengeRoomSystem *both[2]={sys, reference};
+   for (int i=0; i<2; ++i) {
+      bool waiting=false;
+      visitor_arrive(both[i], "room_1", "visitor_1", 201, Easy, 1);
+      visitor_arrive(both[i], "room_3", "visitor_2", 202, Hard, 2);
+      visitor_arrive(both[i], "room_2", "visitor_3", 203, Medium, 3);
+      visitor_arrive_or_wait(both[i], "room_2", "visitor_4", 204, Medium, 4,
+                             &waiting);
+      visitor_quit(both[i], 201, 9);
+      change_challenge_name(both[i], 22, "challenge_22");
+   }
+   //closing the journal first keeps the quits of destroy out of it, as if
+   //the system crashed after its last sync.
+   char *most_popular=NULL, *best_time=NULL;
+   r=close_system_journal(sys);
+   destroy_system(sys, 10, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+   r=create_system_journaled("test_1.txt", path, 2, 0, &sys);
+   ASSERT("11.2" , r==OK && same_systems(sys, reference))
+   //the changes were replayed, so the windows and sketches are rebuilt too.
+   int time=0, reference_time=0;
+   completion_time_percentile(sys, "challenge_1", 50, &time);
+   completion_time_percentile(reference, "challenge_1", 50, &reference_time);
+   ASSERT("11.3" , time==8 && reference_time==8)
+   char *name=NULL;
+   r=most_popular_challenge_in_window(sys, 60, &name);
+   ASSERT("11.4" , r==OK && name!=NULL && strcmp(name, "challenge_1")==0)
+   free(name);
+
+   r=compact_system_journal(sys);
+   ASSERT("11.5" , r==OK)
+   close_system_journal(sys);
+   destroy_system(sys, 10, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+   r=create_system_journaled("test_1.txt", path, 2, 0, &sys);
+   ASSERT("11.6" , r==OK && same_systems(sys, reference))
+   //a compacted journal only holds the totals: windows and sketches start
+   //empty again.
+   completion_time_percentile(sys, "challenge_1", 50, &time);
+   ASSERT("11.7" , time==0)
+   r=most_popular_challenge_in_window(sys, 60, &name);
+   ASSERT("11.8" , r==OK && name==NULL)
+   //the waiting visitor kept its place in the queue.
+   visitor_quit(sys, 203, 11);
+   visitor_quit(reference, 203, 11);
+   ASSERT("11.9" , same_systems(sys, reference))
+
+   destroy_system(sys, 12, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+   r=create_system_journaled("test_1.txt", path, 2, 0, &sys);
+   all_visitors_quit(reference, 12);
+   ASSERT("11.10" , r==OK && same_systems(sys, reference))
+
+   //names past the old record limit are journaled whole.
+   char long_names[2][58];
+   memset(long_names, 'v', sizeof(long_names));
+   long_names[0][57]='\0';
+   long_names[1][57]='\0';
+   long_names[1][0]='w';
+   for (int i=0; i<2; ++i) {
+      visitor_arrive(reference, "room_1", long_names[i], 301+i, Easy, 13);
+      r=visitor_arrive(sys, "room_1", long_names[i], 301+i, Easy, 13);
+      ASSERT("11.11" , r==OK)
+   }
+   visitor_quit(reference, 302, 14);
+   visitor_quit(sys, 302, 14);
+   ASSERT("11.12" , sync_system_journal(sys)==OK)
+   //a name the journal can't hold is refused before it changes the system.
+   char *huge_name=malloc(EVENT_NAME_LENGTH+1);
+   memset(huge_name, 'h', EVENT_NAME_LENGTH);
+   huge_name[EVENT_NAME_LENGTH]='\0';
+   r=visitor_arrive(sys, "room_1", huge_name, 303, Easy, 15);
+   ASSERT("11.13" , r==ILLEGAL_PARAMETER)
+   r=change_challenge_name(sys, 11, huge_name);
+   ASSERT("11.14" , r==ILLEGAL_PARAMETER && same_systems(sys, reference))
+   free(huge_name);
+   destroy_system(sys, 16, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+   r=create_system_journaled("test_1.txt", path, 2, 0, &sys);
+   all_visitors_quit(reference, 16);
+   ASSERT("11.15" , r==OK && same_systems(sys, reference))
+   destroy_system(sys, 16, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+   destroy_system(reference, 16, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+   remove(path);
+}
+
+static void level_kernel_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   int expected[All_Levels+1][4]={{0, 2, 1, 1}, {1, 0, 0, 1}, {0, 1, 2, 2},
+                                  {1, 3, 3, 4}};
+   int expected_totals[All_Levels+1]={4, 2, 5, 11};
+   bool same=true;
+   for (int round=0; round<2; ++round) {
+      //the second round counts on the executor.
+      if (round==1)
+         start_system_executor(sys, 2);
+      for (int level=Easy; level<=All_Levels; ++level) {
+         int places[4], total=0;
+         Result r=system_free_places(sys, (Level)level, places, &total);
+         same=same && r==OK && total==expected_totals[level] &&
+              memcmp(places, expected[level], sizeof(places))==0;
+      }
+   }
+   ASSERT("12.1" , same)
+   int places=-1;
+   Result r=num_of_free_places_for_level(sys->rooms[3], (Level)(All_Levels+1),
+                                         &places);
+   ASSERT("12.2" , r==OK && places==0)
+
+   //room_3 lists challenge_5 before challenge_3, the smaller name goes first.
+   r=visitor_arrive(sys, "room_3", "visitor_1", 201, Hard, 1);
+   ASSERT("12.3" , r==OK && sys->challenges[1]->num_visits==1 &&
+                   sys->challenges[3]->num_visits==0)
+   r=visitor_arrive(sys, "room_3", "visitor_2", 202, Hard, 2);
+   ASSERT("12.4" , r==OK && sys->challenges[3]->num_visits==1)
+   r=visitor_arrive(sys, "room_3", "visitor_3", 203, Hard, 3);
+   ASSERT("12.5" , r==NO_AVAILABLE_CHALLENGES)
+   r=visitor_arrive(sys, "room_1", "visitor_3", 203, Easy, 4);
+   ASSERT("12.6" , r==OK && sys->challenges[5]->num_visits==1 &&
+                   sys->challenges[2]->num_visits==0)
+   r=visitor_arrive(sys, "room_4", "visitor_4", 204, All_Levels, 5);
+   ASSERT("12.7" , r==OK && sys->challenges[0]->num_visits==1)
+   int room_places[4], total=0;
+   system_free_places(sys, Hard, room_places, &total);
+   ASSERT("12.8" , total==3 && room_places[2]==0)
+   system_free_places(sys, All_Levels, room_places, &total);
+   ASSERT("12.9" , total==11-4 && room_places[3]==3)
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 6, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static void inline_name_test(void)
+{
+   char inline_name[NAME_INLINE_SIZE];
+   char *name=NULL;
+   char fits[NAME_INLINE_SIZE], too_long[NAME_INLINE_SIZE+1];
+   memset(fits, 'a', NAME_INLINE_SIZE-1);
+   fits[NAME_INLINE_SIZE-1]='\0';
+   memset(too_long, 'b', NAME_INLINE_SIZE);
+   too_long[NAME_INLINE_SIZE]='\0';
+   Result r=store_name(&name, inline_name, fits);
+   ASSERT("13.1" , r==OK && name==inline_name && strcmp(name, fits)==0)
+   r=store_name(&name, inline_name, too_long);
+   ASSERT("13.2" , r==OK && NAME_ON_HEAP(name, inline_name) &&
+                   strcmp(name, too_long)==0)
+   //a name may be stored over itself, on the heap or inline.
+   r=store_name(&name, inline_name, name);
+   ASSERT("13.3" , r==OK && NAME_ON_HEAP(name, inline_name) &&
+                   strcmp(name, too_long)==0)
+   r=store_name(&name, inline_name, fits);
+   r=store_name(&name, inline_name, name);
+   ASSERT("13.4" , r==OK && name==inline_name && strcmp(name, fits)==0)
+   release_name(&name, inline_name);
+   ASSERT("13.5" , name==NULL)
+
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   Challenge *challenge=sys->challenges[0];
+   ASSERT("13.6" , challenge->name==challenge->inline_name)
+   r=change_challenge_name(sys, 22, too_long);
+   ASSERT("13.7" , r==OK && NAME_ON_HEAP(challenge->name,
+                                         challenge->inline_name))
+   r=change_system_room_name(sys, "room_2", too_long);
+   ASSERT("13.8" , r==OK && NAME_ON_HEAP(sys->rooms[0]->name,
+                                         sys->rooms[0]->inline_name))
+   char long_visitor[]="visitor_with_a_name_that_is_too_long";
+   r=visitor_arrive(sys, too_long, long_visitor, 201, Medium, 1);
+   char *room=NULL;
+   r=system_room_of_visitor(sys, long_visitor, &room);
+   ASSERT("13.9" , r==OK && room!=NULL && strcmp(room, too_long)==0)
+   free(room);
+   r=change_challenge_name(sys, 22, "challenge_2");
+   ASSERT("13.10" , r==OK && challenge->name==challenge->inline_name &&
+                    strcmp(challenge->name, "challenge_2")==0)
+   visitor_quit(sys, 201, 2);
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 3, &most_popular, &best_time);
+   ASSERT("13.11" , most_popular!=NULL &&
+                    strcmp(most_popular, "challenge_2")==0)
+   free(most_popular);
+   free(best_time);
+}
+
+static void wait_queue_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   bool waiting[6]={false};
+   //room_1 holds challenge_1 and challenge_4 (easy) and challenge_6 (hard).
+   visitor_arrive(sys, "room_1", "visitor_1", 201, Easy, 1);
+   visitor_arrive(sys, "room_1", "visitor_2", 202, Easy, 2);
+   Result r=visitor_arrive_or_wait(sys, "room_1", "visitor_3", 203, Easy, 3,
+                                   &waiting[0]);
+   ASSERT("14.1" , r==OK && waiting[0])
+   r=visitor_arrive_or_wait(sys, "room_1", "visitor_4", 204, All_Levels, 4,
+                            &waiting[1]);
+   ASSERT("14.2" , r==OK && !waiting[1])
+   visitor_arrive_or_wait(sys, "room_1", "visitor_5", 205, All_Levels, 5,
+                          &waiting[2]);
+   visitor_arrive_or_wait(sys, "room_1", "visitor_6", 206, Easy, 6,
+                          &waiting[3]);
+   ASSERT("14.3" , waiting[2] && waiting[3])
+   r=visitor_arrive(sys, "room_1", "visitor_7", 207, Easy, 7);
+   ASSERT("14.4" , r==NO_AVAILABLE_CHALLENGES)
+
+   //a waiting visitor is in the system, but in no room.
+   char *room=NULL;
+   const char *view=NULL;
+   r=system_room_of_visitor(sys, "visitor_3", &room);
+   ASSERT("14.5" , r==NOT_IN_ROOM && room==NULL)
+   r=system_room_of_visitor_view(sys, "visitor_3", &view, NULL);
+   ASSERT("14.6" , r==NOT_IN_ROOM)
+   r=visitor_arrive(sys, "room_2", "visitor_3", 203, Medium, 8);
+   ASSERT("14.7" , r==ALREADY_IN_ROOM)
+
+   //the easy place goes to the visitor waiting longest for easy or any level.
+   visitor_quit(sys, 201, 10);
+   r=system_room_of_visitor_view(sys, "visitor_3", &view, NULL);
+   ASSERT("14.8" , r==OK && strcmp(view, "room_1")==0 &&
+                   sys->challenges[5]->num_visits==2)
+   visitor_quit(sys, 203, 11);
+   r=system_room_of_visitor_view(sys, "visitor_5", &view, NULL);
+   ASSERT("14.9" , r==OK && strcmp(view, "room_1")==0 &&
+                   sys->challenges[5]->num_visits==3)
+   r=system_room_of_visitor_view(sys, "visitor_6", &view, NULL);
+   ASSERT("14.10" , r==NOT_IN_ROOM)
+
+   //a waiting visitor quits without a visit.
+   r=visitor_quit(sys, 206, 12);
+   ASSERT("14.11" , r==OK)
+   r=visitor_quit(sys, 206, 12);
+   ASSERT("14.12" , r==NOT_IN_ROOM)
+   visitor_quit(sys, 202, 13);
+   int places[4], total=0;
+   system_free_places(sys, Easy, places, &total);
+   ASSERT("14.13" , places[1]==1 && sys->challenges[5]->num_visits==3 &&
+                    sys->challenges[2]->num_visits==1)
+
+   //all_visitors_quit also empties the queues.
+   visitor_arrive_or_wait(sys, "room_1", "visitor_8", 208, Hard, 14,
+                          &waiting[4]);
+   r=all_visitors_quit(sys, 15);
+   ASSERT("14.14" , r==OK && waiting[4])
+   r=system_room_of_visitor_view(sys, "visitor_8", &view, NULL);
+   ASSERT("14.15" , r==NOT_IN_ROOM)
+   r=visitor_arrive_or_wait(sys, "room_1", "visitor_8", 208, Hard, 16,
+                            &waiting[5]);
+   ASSERT("14.16" , r==OK && !waiting[5] &&
+                    sys->challenges[4]->num_visits==2)
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 17, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static bool room_load_matches(ChallengeRoomSystem *sys)
+{
+   RoomLoad *load=sys->room_load;
+   for (int level=Easy; level<=All_Levels; ++level) {
+      int places[4], total=0, most=0;
+      system_free_places(sys, (Level)level, places, &total);
+      for (int i=0; i<load->num_rooms; ++i) {
+         RoomLoadEntry *entry=&load->heaps[level][i];
+         int free_places=entry->capacity-entry->room->occupied[level];
+         if (free_places!=places[entry->position] ||
+             entry->room->load_position[level]!=i)
+            return false;
+         if (i>0) {
+            RoomLoadEntry *parent=&load->heaps[level][(i-1)/2];
+            if (parent->capacity-parent->room->occupied[level]<free_places)
+               return false;
+         }
+         if (places[i]>places[most])
+            most=i;
+      }
+      ChallengeRoom *least_loaded=least_loaded_room(load, (Level)level);
+      if (least_loaded!=(places[most]>0 ? sys->rooms[most] : NULL))
+         return false;
+   }
+   return true;
+}
+
+static void any_room_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   const char *room=NULL;
+   //hard places: room_1 1, room_3 2, room_4 2. the tie goes to room_3, the
+   //first in the init file.
+   Result r=visitor_arrive_any_room(sys, "visitor_1", 201, Hard, 1, &room);
+   ASSERT("15.1" , r==OK && strcmp(room, "room_3")==0 &&
+                   room_load_matches(sys))
+   r=visitor_arrive_any_room(sys, "visitor_2", 202, Hard, 2, &room);
+   ASSERT("15.2" , r==OK && strcmp(room, "room_4")==0)
+   r=visitor_arrive_any_room(sys, "visitor_3", 203, Hard, 3, &room);
+   ASSERT("15.3" , r==OK && strcmp(room, "room_1")==0 &&
+                   room_load_matches(sys))
+   r=visitor_arrive_any_room(sys, "visitor_4", 204, Medium, 4, &room);
+   ASSERT("15.4" , r==OK && strcmp(room, "room_2")==0)
+   r=visitor_arrive_any_room(sys, "visitor_5", 205, All_Levels, 5, &room);
+   ASSERT("15.5" , r==OK && strcmp(room, "room_4")==0 &&
+                   room_load_matches(sys))
+   //quits and arrivals by name move the rooms in the heaps too.
+   visitor_quit(sys, 201, 6);
+   ASSERT("15.6" , room_load_matches(sys))
+   r=visitor_arrive_any_room(sys, "visitor_6", 206, All_Levels, 7, &room);
+   ASSERT("15.7" , r==OK && strcmp(room, "room_3")==0)
+   visitor_arrive(sys, "room_3", "visitor_7", 207, Hard, 8);
+   visitor_arrive(sys, "room_3", "visitor_8", 208, Hard, 9);
+   visitor_arrive(sys, "room_4", "visitor_9", 209, Hard, 9);
+   ASSERT("15.8" , room_load_matches(sys))
+   r=visitor_arrive_any_room(sys, "visitor_10", 210, Hard, 10, &room);
+   ASSERT("15.9" , r==NO_AVAILABLE_CHALLENGES)
+   r=visitor_arrive_any_room(sys, "visitor_10", 210, (Level)(All_Levels+1),
+                             10, &room);
+   ASSERT("15.10" , r==ILLEGAL_PARAMETER)
+   all_visitors_quit(sys, 11);
+   ASSERT("15.11" , room_load_matches(sys))
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 12, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+
+   //a_chal has level code 4, a challenge of all levels, and takes one place.
+   create_system("test_any_level.txt", &sys);
+   r=visitor_arrive_any_room(sys, "visitor_1", 201, All_Levels, 1, &room);
+   ASSERT("15.12" , r==OK && room_load_matches(sys))
+   r=visitor_arrive_any_room(sys, "visitor_2", 202, All_Levels, 2, &room);
+   ASSERT("15.13" , r==OK && strcmp(room, "room_a")==0 &&
+                    room_load_matches(sys))
+   r=visitor_arrive_any_room(sys, "visitor_3", 203, All_Levels, 3, &room);
+   ASSERT("15.14" , r==NO_AVAILABLE_CHALLENGES)
+   destroy_system(sys, 4, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static void forecast_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   RoomForecast forecast;
+   //room_4 holds challenge_2 (medium), challenge_4 (easy) and challenge_5,
+   //challenge_6 (hard). the averages move by FORECAST_WEIGHT = 1/8 of each
+   //new sample, so the expected values are exact.
+   visitor_arrive(sys, "room_4", "visitor_1", 201, Hard, 2);
+   visitor_arrive(sys, "room_4", "visitor_2", 202, Hard, 6);
+   visitor_arrive(sys, "room_4", "visitor_3", 203, Easy, 8);
+   Result r=system_room_forecast(sys, "room_4", Hard, &forecast);
+   ASSERT("16.1" , r==OK && forecast.arrival_rate==1/4.0 &&
+                   forecast.mean_service==0 && forecast.free_places==0 &&
+                   forecast.time_to_free_place==FORECAST_UNKNOWN)
+   system_room_forecast(sys, "room_4", Easy, &forecast);
+   ASSERT("16.2" , forecast.arrival_rate==0 && forecast.free_places==0)
+   //gaps of 4 and 2: 4 + (2 - 4) / 8.
+   system_room_forecast(sys, "room_4", All_Levels, &forecast);
+   ASSERT("16.3" , forecast.arrival_rate==1/3.75 && forecast.free_places==1)
+
+   visitor_quit(sys, 201, 12);
+   visitor_arrive(sys, "room_4", "visitor_4", 204, Hard, 14);
+   visitor_quit(sys, 203, 16);
+   //one of the two busy hard challenges frees up after 10 / 2.
+   system_room_forecast(sys, "room_4", Hard, &forecast);
+   ASSERT("16.4" , forecast.arrival_rate==1/4.5 &&
+                   forecast.mean_service==10 &&
+                   forecast.time_to_free_place==5)
+   system_room_forecast(sys, "room_4", Easy, &forecast);
+   ASSERT("16.5" , forecast.mean_service==8 &&
+                   forecast.time_to_free_place==0)
+   system_room_forecast(sys, "room_4", All_Levels, &forecast);
+   ASSERT("16.6" , forecast.arrival_rate==1/4.03125 &&
+                   forecast.mean_service==9.75)
+
+   bool waiting=false;
+   visitor_arrive_or_wait(sys, "room_4", "visitor_5", 205, Hard, 17,
+                          &waiting);
+   system_room_forecast(sys, "room_4", Hard, &forecast);
+   ASSERT("16.7" , waiting && forecast.waiting==1 &&
+                   forecast.arrival_rate==1/4.3125 &&
+                   forecast.time_to_free_place==10)
+   //the waiting visitor takes the place of visitor_2 after 14.
+   visitor_quit(sys, 202, 20);
+   system_room_forecast(sys, "room_4", Hard, &forecast);
+   ASSERT("16.8" , forecast.waiting==0 && forecast.mean_service==10.5 &&
+                   forecast.time_to_free_place==6)
+   system_room_forecast(sys, "room_4", All_Levels, &forecast);
+   ASSERT("16.9" , forecast.arrival_rate==1/3.90234375 &&
+                   forecast.mean_service==10.28125)
+   system_room_forecast(sys, "room_4", Medium, &forecast);
+   ASSERT("16.10" , forecast.arrival_rate==0 && forecast.mean_service==0 &&
+                    forecast.free_places==1 &&
+                    forecast.time_to_free_place==0)
+   r=system_room_forecast(sys, "room_4", (Level)(All_Levels+1), &forecast);
+   ASSERT("16.11" , r==ILLEGAL_PARAMETER)
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 21, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+
+   //a_chal is of all levels, its times are counted once: 4, then 4 + 4 / 8.
+   create_system("test_any_level.txt", &sys);
+   visitor_arrive(sys, "room_a", "visitor_1", 201, All_Levels, 1);
+   visitor_arrive(sys, "room_a", "visitor_2", 202, Easy, 1);
+   visitor_quit(sys, 202, 5);
+   visitor_quit(sys, 201, 9);
+   r=system_room_forecast(sys, "room_a", All_Levels, &forecast);
+   ASSERT("16.12" , r==OK && forecast.mean_service==4.5)
+   //both challenges are busy, one frees up after 4.5 / 2.
+   visitor_arrive(sys, "room_a", "visitor_1", 201, All_Levels, 10);
+   visitor_arrive(sys, "room_a", "visitor_2", 202, Easy, 10);
+   system_room_forecast(sys, "room_a", All_Levels, &forecast);
+   ASSERT("16.13" , forecast.free_places==0 &&
+                    forecast.time_to_free_place==3)
+   destroy_system(sys, 11, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static int count_name_blocks(ChallengeRoomSystem *sys)
+{
+   int count=0;
+   for (NameBlock *block=sys->name_blocks; block; block=block->next)
+      count++;
+   return count;
+}
+
+static bool same_names(ChallengeRoomSystem *sys, char **names)
+{
+   for (int i=0; i<sys->challenge_array_size; ++i)
+      if (strcmp(sys->challenges[i]->name, names[i])!=0)
+         return false;
+   return true;
+}
+
+static void batch_rename_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   char *names[]={"challenge_2", "challenge_3", "challenge_4", "challenge_5",
+                  "challenge_6", "challenge_1"};
+   char *long_names[]={"a_challenge_name_too_long_to_be_inline",
+                       "b_challenge_name_too_long_to_be_inline",
+                       "c_challenge_name_too_long_to_be_inline"};
+   ChallengeRename mixed[]={{22, long_names[0]}, {999, "challenge_999"},
+                            {33, "challenge_33"}};
+   Result r=change_challenge_names(sys, mixed, 3);
+   ASSERT("17.1" , r==ILLEGAL_PARAMETER && same_names(sys, names) &&
+                   count_name_blocks(sys)==0)
+   ChallengeRename null_name[]={{22, long_names[0]}, {33, NULL}};
+   r=change_challenge_names(sys, null_name, 2);
+   ASSERT("17.2" , r==NULL_PARAMETER && same_names(sys, names))
+   r=change_challenge_names(sys, NULL, 1);
+   ASSERT("17.3" , r==NULL_PARAMETER)
+   r=change_challenge_names(sys, mixed, -1);
+   ASSERT("17.4" , r==ILLEGAL_PARAMETER && same_names(sys, names))
+
+   ChallengeRename first[]={{22, long_names[0]}, {33, "challenge_33"},
+                            {44, long_names[1]}};
+   r=change_challenge_names(sys, first, 3);
+   names[0]=long_names[0];
+   names[1]="challenge_33";
+   names[2]=long_names[1];
+   NameBlock *block=sys->challenges[0]->name_block;
+   ASSERT("17.5" , r==OK && same_names(sys, names) && block!=NULL &&
+                   sys->challenges[2]->name_block==block &&
+                   block->references==2 && count_name_blocks(sys)==1)
+   int time=-1;
+   r=best_time_of_system_challenge(sys, long_names[1], &time);
+   ASSERT("17.6" , r==OK && time==0)
+
+   //a block lives while one of its names is used.
+   ChallengeRename second[]={{22, long_names[2]}};
+   change_challenge_names(sys, second, 1);
+   names[0]=long_names[2];
+   ASSERT("17.7" , same_names(sys, names) && block->references==1 &&
+                   count_name_blocks(sys)==2)
+   r=change_challenge_name(sys, 44, "challenge_44");
+   names[2]="challenge_44";
+   ASSERT("17.8" , r==OK && same_names(sys, names) &&
+                   count_name_blocks(sys)==1)
+
+   //a name lent and replaced in the same call.
+   ChallengeRename twice[]={{55, long_names[0]}, {55, long_names[1]},
+                            {66, long_names[2]}, {66, "challenge_66"}};
+   r=change_challenge_names(sys, twice, 4);
+   names[3]=long_names[1];
+   names[4]="challenge_66";
+   ASSERT("17.9" , r==OK && same_names(sys, names) &&
+                   sys->challenges[3]->name_block->references==1 &&
+                   count_name_blocks(sys)==2)
+   ChallengeRename dropped[]={{55, long_names[0]}, {55, "challenge_55"}};
+   r=change_challenge_names(sys, dropped, 2);
+   names[3]="challenge_55";
+   ASSERT("17.10" , r==OK && same_names(sys, names) &&
+                    count_name_blocks(sys)==1)
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 1, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static void reload_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   char *names[]={"challenge_2", "challenge_3", "challenge_4", "challenge_5",
+                  "challenge_6", "challenge_1"};
+   visitor_arrive(sys, "room_4", "visitor_1", 201, Hard, 1);
+   visitor_arrive(sys, "room_2", "visitor_2", 202, Medium, 2);
+   visitor_arrive(sys, "room_1", "visitor_3", 203, Easy, 3);
+   //challenge_2 turns hard: nothing changes, not even the renames planned
+   //before it.
+   ReloadReport report={0, 0, 0, 0, 0};
+   Result r=reload_system(sys, "test_reload_level.txt", &report);
+   ASSERT("18.1" , r==ILLEGAL_PARAMETER && same_names(sys, names) &&
+                   sys->room_array_size==4 && report.added_rooms==0)
+   r=reload_system(sys, "no_such_file.txt", &report);
+   ASSERT("18.2" , r==ILLEGAL_PARAMETER && same_names(sys, names))
+
+   //challenges 55 and 66 leave, 77 is added and 33, 44 are renamed. only
+   //room_2 keeps its challenges: room_1 and room_3 are replaced, room_4
+   //leaves, and the rooms that still have visitors drain.
+   r=reload_system(sys, "test_reload.txt", &report);
+   ASSERT("18.3" , r==OK && report.added_challenges==1 &&
+                   report.retired_challenges==2 && report.added_rooms==3 &&
+                   report.retired_rooms==3 && report.draining_rooms==2)
+   char *reloaded[]={"challenge_2", "challenge_three_with_a_long_name",
+                     "challenge_4x", "challenge_7", "challenge_1"};
+   ASSERT("18.4" , sys->challenge_array_size==5 &&
+                   same_names(sys, reloaded) &&
+                   sys->challenges[0]->num_visits==1 &&
+                   sys->challenges[4]->num_visits==1)
+   int time=0;
+   r=best_time_of_system_challenge(sys, "challenge_three_with_a_long_name",
+                                   &time);
+   ASSERT("18.5" , r==OK)
+   r=best_time_of_system_challenge(sys, "challenge_3", &time);
+   ASSERT("18.6" , r==ILLEGAL_PARAMETER)
+
+   //the kept room keeps its visitor, the draining ones keep theirs.
+   const char *view=NULL;
+   r=system_room_of_visitor_view(sys, "visitor_2", &view, NULL);
+   ASSERT("18.7" , r==OK && strcmp(view, "room_2")==0)
+   r=system_room_of_visitor_view(sys, "visitor_1", &view, NULL);
+   ASSERT("18.8" , r==OK && strcmp(view, "room_4")==0 &&
+                   sys->num_draining_rooms==2)
+   r=visitor_arrive(sys, "room_4", "visitor_4", 204, All_Levels, 4);
+   ASSERT("18.9" , r==ILLEGAL_PARAMETER)
+   //the new room_1 is empty, the draining one still holds visitor_3.
+   r=visitor_arrive(sys, "room_1", "visitor_4", 204, Easy, 4);
+   ASSERT("18.10" , r==OK && sys->challenges[4]->num_visits==2)
+   int places[4], total=0;
+   system_free_places(sys, All_Levels, places, &total);
+   ASSERT("18.11" , total==7-2 && places[1]==1)
+
+   visitor_quit(sys, 201, 5);
+   ASSERT("18.12" , sys->num_draining_rooms==1 &&
+                    sys->num_retired_challenges==2)
+   visitor_quit(sys, 203, 6);
+   ASSERT("18.13" , sys->num_draining_rooms==0 &&
+                    sys->num_retired_challenges==0)
+   r=visitor_quit(sys, 204, 7);
+   ASSERT("18.14" , r==OK && sys->challenges[4]->best_time==3)
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 8, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static void memory_test(void)
+{
+   char *path="memory_test.jnl";
+   remove(path);
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   MemoryUsage empty, busy, quit;
+   Result r=system_memory(sys, &empty);
+   ASSERT("19.1" , r==OK && empty.bytes[MEMORY_SNAPSHOTS]==0 &&
+                   empty.bytes[MEMORY_JOURNAL]==0 &&
+                   empty.bytes[MEMORY_EXECUTOR]==0)
+
+   //names this long do not fit in the visitor, they are allocated.
+   visitor_arrive(sys, "room_1", "visitor_with_a_name_too_long_to_inline",
+                  301, Easy, 1);
+   visitor_arrive(sys, "room_4", "another_visitor_with_a_long_name",
+                  302, All_Levels, 2);
+   r=system_memory(sys, &busy);
+   ASSERT("19.2" , r==OK && busy.num_visitors==2 && busy.total>empty.total &&
+                   busy.bytes[MEMORY_NAMES]>empty.bytes[MEMORY_NAMES])
+
+   //the visitor table keeps its chunks for the next arrivals, the names go.
+   r=all_visitors_quit(sys, 3);
+   system_memory(sys, &quit);
+   ASSERT("19.3" , r==OK && quit.num_visitors==0 && quit.total<busy.total &&
+                   quit.bytes[MEMORY_NAMES]==empty.bytes[MEMORY_NAMES] &&
+                   quit.bytes[MEMORY_VISITORS]==busy.bytes[MEMORY_VISITORS])
+   //the dummy visitor left with the others, a visitor with its id counts.
+   r=visitor_arrive(sys, "room_1", "visitor_1", -1, Easy, 3);
+   system_memory(sys, &quit);
+   ASSERT("19.4" , r==OK && empty.num_visitors==0 && quit.num_visitors==1)
+   visitor_quit(sys, -1, 3);
+
+   enable_system_snapshots(sys, 1);
+   publish_system_snapshot(sys);
+   attach_system_journal(sys, path, 2, 0);
+   start_system_executor(sys, 2);
+   MemoryUsage usage;
+   system_memory(sys, &usage);
+   ASSERT("19.5" , usage.bytes[MEMORY_SNAPSHOTS]>0 &&
+                   usage.bytes[MEMORY_JOURNAL]>0 &&
+                   usage.bytes[MEMORY_EXECUTOR]>0)
+   size_t sum=0;
+   for (int i=0; i<MEMORY_CATEGORIES; ++i)
+      sum+=usage.bytes[i];
+   ASSERT("19.6" , sum==usage.total &&
+                   strcmp(memory_category_name(MEMORY_EXECUTOR), "executor")==0)
+
+   close_system_journal(sys);
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 4, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+   remove(path);
+}
+
+static void visitor_index_test(void)
+{
+   ChallengeRoomSystem *sys=NULL;
+   create_system("test_1.txt", &sys);
+   VisitorTable *table=&sys->visitors;
+   //the dummy visitor holds the first record, visitor_1 the second.
+   visitor_arrive(sys, "room_1", "visitor_1", 301, Easy, 1);
+   VisitorHandle first=find_visitor_id(table, 301);
+   ASSERT("20.1" , first==1 && find_visitor_name(table, "visitor_1")==first)
+   visitor_quit(sys, 301, 2);
+   ASSERT("20.2" , find_visitor_id(table, 301)==NO_VISITOR &&
+                   find_visitor_name(table, "visitor_1")==NO_VISITOR)
+   //the record of visitor_1 is handed out again, under the new keys only.
+   Result r=visitor_arrive(sys, "room_4", "visitor_2", 302, All_Levels, 3);
+   const char *view=NULL;
+   ASSERT("20.3" , r==OK && find_visitor_id(table, 302)==first &&
+                   find_visitor_name(table, "visitor_2")==first)
+   r=system_room_of_visitor_view(sys, "visitor_1", &view, NULL);
+   ASSERT("20.4" , r==NOT_IN_ROOM)
+   r=system_room_of_visitor_view(sys, "visitor_2", &view, NULL);
+   ASSERT("20.5" , r==OK && strcmp(view, "room_4")==0)
+
+   //room_1 has a single hard challenge: the first visitor takes it and the
+   //others wait, well past the first size of the indexes.
+   char name[32];
+   bool waiting=false;
+   for (int id=100; id<140; ++id){
+      sprintf(name, "waiter_%d", id);
+      visitor_arrive_or_wait(sys, "room_1", name, id, Hard, 4, &waiting);
+   }
+   ASSERT("20.6" , waiting && table->index_capacity>=2*(40+2))
+   for (int id=102; id<140; id+=2)
+      visitor_quit(sys, id, 5);
+   bool found=true;
+   for (int id=100; id<140; ++id){
+      sprintf(name, "waiter_%d", id);
+      VisitorHandle by_id=find_visitor_id(table, id);
+      VisitorHandle by_name=find_visitor_name(table, name);
+      if (id>100 && id%2==0)
+         found=found && by_id==NO_VISITOR && by_name==NO_VISITOR;
+      else
+         found=found && by_id!=NO_VISITOR && by_id==by_name &&
+               VISITOR_RECORD(table, by_id)->visitor_id==id;
+   }
+   ASSERT("20.7" , found && table->num_indexed==1+1+21)
+   //the oldest waiter left is handed the challenge.
+   visitor_quit(sys, 100, 6);
+   r=system_room_of_visitor_view(sys, "waiter_101", &view, NULL);
+   ASSERT("20.8" , r==OK && strcmp(view, "room_1")==0)
+   r=system_room_of_visitor_view(sys, "waiter_103", &view, NULL);
+   ASSERT("20.9" , r==NOT_IN_ROOM)
+
+   //after all quit no visitor is found, and the records are reused.
+   uint32_t num_records=table->num_records;
+   r=all_visitors_quit(sys, 7);
+   char *room=NULL;
+   ASSERT("20.10" , r==OK && table->num_indexed==0 &&
+                    find_visitor_id(table, 101)==NO_VISITOR)
+   r=system_room_of_visitor(sys, "waiter_101", &room);
+   ASSERT("20.11" , r==NOT_IN_ROOM && room==NULL)
+   r=system_room_of_visitor_view(sys, "visitor_2", &view, NULL);
+   ASSERT("20.12" , r==NOT_IN_ROOM)
+   r=visitor_quit(sys, 302, 8);
+   ASSERT("20.13" , r==NOT_IN_ROOM)
+   r=visitor_arrive(sys, "room_3", "waiter_101", 101, Hard, 9);
+   ASSERT("20.14" , r==OK && find_visitor_id(table, 101)<num_records &&
+                    table->num_records==num_records)
+   r=system_room_of_visitor_view(sys, "waiter_101", &view, NULL);
+   ASSERT("20.15" , r==OK && strcmp(view, "room_3")==0)
+
+   char *most_popular=NULL, *best_time=NULL;
+   destroy_system(sys, 10, &most_popular, &best_time);
+   free(most_popular);
+   free(best_time);
+}
+
+static void venue_manager_test(void)
+{
+   char *files[]={"test_1.txt", "test_1.txt", "test_1.txt"};
+   VenueManager *manager=NULL;
+   //venues 0 and 2 are on the first shard, venue 1 on the second.
+   Result r=create_venue_manager(files, 3, 2, &manager);
+   ASSERT("21.1" , r==OK && manager->num_shards==2)
+
+   //a call only reaches its own venue, so ids repeat across venues.
+   r=venue_visitor_arrive(manager, 1, "room_1", "visitor_1", 301, Easy, 1);
+   ASSERT("21.2" , r==OK && manager->venues[1]->challenges[5]->num_visits==1 &&
+                   manager->venues[0]->challenges[5]->num_visits==0 &&
+                   manager->venues[2]->challenges[5]->num_visits==0)
+   r=venue_visitor_arrive(manager, 2, "room_1", "visitor_1", 301, Easy, 1);
+   ASSERT("21.3" , r==OK && manager->venues[2]->challenges[5]->num_visits==1)
+   r=venue_visitor_arrive(manager, 2, "room_1", "visitor_1", 301, Easy, 2);
+   ASSERT("21.4" , r==ALREADY_IN_ROOM)
+   r=venue_visitor_arrive(manager, 0, "room_4", "visitor_1", 301, Medium, 1);
+   ASSERT("21.5" , r==OK && manager->venues[0]->challenges[0]->num_visits==1)
+   r=venue_visitor_arrive(manager, 3, "room_1", "visitor_2", 302, Easy, 2);
+   ASSERT("21.6" , r==ILLEGAL_PARAMETER)
+   r=venue_visitor_arrive(manager, -1, "room_1", "visitor_2", 302, Easy, 2);
+   ASSERT("21.7" , r==ILLEGAL_PARAMETER)
+   r=venue_visitor_quit(manager, 3, 301, 2);
+   ASSERT("21.8" , r==ILLEGAL_PARAMETER)
+
+   //one visit each: challenge_1 beats challenge_2 by name, and venue 1 beats
+   //venue 2 on the other shard.
+   char *name=NULL;
+   int venue=-1, time=-1;
+   r=global_most_popular_challenge(manager, &name, &venue);
+   ASSERT("21.9" , r==OK && name && strcmp(name, "challenge_1")==0 &&
+                   venue==1)
+   free(name);
+   r=global_best_time(manager, &name, &venue, &time);
+   ASSERT("21.10" , r==OK && name==NULL)
+   for (int v=0; v<3; ++v)
+      venue_visitor_quit(manager, v, 301, 4);
+   r=global_best_time(manager, &name, &venue, &time);
+   ASSERT("21.11" , r==OK && name && strcmp(name, "challenge_1")==0 &&
+                    venue==1 && time==3)
+   free(name);
+
+   //challenge_3 of venue 2 takes the lead on both.
+   venue_visitor_arrive(manager, 2, "room_3", "visitor_2", 302, Hard, 5);
+   venue_visitor_quit(manager, 2, 302, 6);
+   venue_visitor_arrive(manager, 2, "room_3", "visitor_2", 302, Hard, 7);
+   r=global_best_time(manager, &name, &venue, &time);
+   ASSERT("21.12" , r==OK && name && strcmp(name, "challenge_3")==0 &&
+                    venue==2 && time==1)
+   free(name);
+   r=global_most_popular_challenge(manager, &name, NULL);
+   ASSERT("21.13" , r==OK && name && strcmp(name, "challenge_3")==0)
+   free(name);
+
+   //venue 2 is at time 7: the others go, the manager stays for a retry.
+   r=destroy_venue_manager(manager, 6);
+   ASSERT("21.14" , r==ILLEGAL_TIME && manager->venues[0]==NULL &&
+                    manager->venues[1]==NULL && manager->venues[2]!=NULL)
+   r=global_most_popular_challenge(manager, &name, &venue);
+   ASSERT("21.15" , r==OK && name && strcmp(name, "challenge_3")==0 &&
+                    venue==2)
+   free(name);
+   r=venue_visitor_quit(manager, 2, 302, 8);
+   ASSERT("21.16" , r==OK)
+   r=destroy_venue_manager(manager, 9);
+   ASSERT("21.17" , r==OK)
+}
 
 int main(int argc, char **argv)
 {
@@ -83,6 +1320,27 @@ int main(int argc, char **argv)
 
    free(challenge_best_time);
 
+   latency_test();
+   parallel_init_test();
+   most_popular_test();
+   executor_quit_test();
+   snapshot_test();
+   occupancy_test();
+   name_view_test();
+   window_test();
+   completion_sketch_test();
+   journal_test();
+   level_kernel_test();
+   inline_name_test();
+   wait_queue_test();
+   any_room_test();
+   forecast_test();
+   batch_rename_test();
+   reload_test();
+   memory_test();
+   visitor_index_test();
+   venue_manager_test();
+
    return 0;
 }
 
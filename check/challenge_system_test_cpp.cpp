@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include "challenge_system.hpp"
+
+#define ASSERT(test_number, test_condition)  \
+   if (!(test_condition)) {printf("\nTEST %s FAILED", test_number); } \
+   else printf("\nTEST %s OK", test_number);
+
+using challenge_system::Expected;
+using challenge_system::System;
+
+int main()
+{
+   auto missing=System::create("no_such_file.txt");
+   ASSERT("1.1" , !missing && missing.error()!=OK)
+
+   auto created=System::create("test_1.txt");
+   ASSERT("1.2" , created.has_value() && created->get()!=nullptr)
+   System sys=std::move(created).value();
+   ASSERT("1.3" , sys.get()!=nullptr && created->get()==nullptr)
+
+   auto popular=sys.most_popular();
+   ASSERT("1.4" , popular && popular->empty())
+
+   auto arrived=sys.arrive("room_1", "visitor_1", 1, Easy, 1);
+   ASSERT("1.5" , arrived.has_value())
+   arrived=sys.arrive("room_1", "visitor_1", 1, Easy, 2);
+   ASSERT("1.6" , !arrived && arrived.error()==ALREADY_IN_ROOM)
+
+   auto room=sys.room_of_visitor("visitor_1");
+   ASSERT("1.7" , room && *room==std::string_view("room_1"))
+   room=sys.room_of_visitor("visitor_2");
+   ASSERT("1.8" , !room && room.error()==NOT_IN_ROOM)
+
+   auto waiting=sys.arrive_or_wait("room_2", "visitor_2", 2, Medium, 3);
+   ASSERT("1.9" , waiting && !*waiting)
+   waiting=sys.arrive_or_wait("room_2", "visitor_3", 3, Medium, 4);
+   ASSERT("1.10" , waiting && *waiting)
+
+   auto any_room=sys.arrive_any_room("visitor_4", 4, Hard, 5);
+   ASSERT("1.11" , any_room && !any_room->empty())
+
+   ASSERT("1.12" , sys.quit(1, 7).has_value())
+   auto quit=sys.quit(1, 8);
+   ASSERT("1.13" , !quit && quit.error()==NOT_IN_ROOM)
+   auto time=sys.best_time("challenge_1");
+   ASSERT("1.14" , time && *time==6)
+   time=sys.best_time("no_such_challenge");
+   ASSERT("1.15" , !time && time.value_or(-1)==-1)
+
+   ASSERT("1.16" , sys.rename_challenge(11, "challenge_11").has_value())
+   auto window=sys.most_popular_in_window(60);
+   ASSERT("1.17" , window && *window &&
+                   std::strcmp(window->get(), "challenge_11")==0)
+
+   int places[4];
+   auto total=sys.free_places(All_Levels, places);
+   ASSERT("1.18" , total && *total==11-2 && places[0]==0)
+
+   auto failed=sys.destroy(0);
+   ASSERT("1.19" , !failed && failed.error()==ILLEGAL_TIME &&
+                   sys.get()!=nullptr)
+   auto summary=sys.destroy(20);
+   ASSERT("1.20" , summary && sys.get()==nullptr && summary->best_time &&
+                   std::strcmp(summary->best_time.get(), "challenge_11")==0)
+
+   System other=System::create("test_1.txt").value();
+   other.arrive("room_4", "visitor_1", 1, All_Levels, 1).has_value();
+   sys=std::move(other);
+   room=sys.room_of_visitor("visitor_1");
+   ASSERT("1.21" , room && *room==std::string_view("room_4") &&
+                   other.get()==nullptr)
+
+   return 0;
+}
@@ -0,0 +1,26 @@
+# Generates workloads and replays each one on the serial and the parallel code
+# paths of the system with `replay --compare`, failing on the first
+# difference. Run by ctest with GENERATOR, REPLAY and WORK_DIR set.
+
+foreach(seed 1 2 3 4)
+    set(init_file ${WORK_DIR}/differential_${seed}_init.txt)
+    set(log_file ${WORK_DIR}/differential_${seed}_log)
+    set(format_option)
+    if(seed GREATER 2)
+        set(format_option --binary)
+    endif()
+    execute_process(COMMAND ${GENERATOR} ${init_file} ${log_file}
+            --challenges 40 --rooms 24 --slots 6 --arrivals 3000 --rate 3
+            --stay 8 --zipf 1 --queries 0.2 --waits 0.3 --all-quit 500
+            --seed ${seed} ${format_option}
+            RESULT_VARIABLE result OUTPUT_VARIABLE output)
+    if(result)
+        message(FATAL_ERROR "generator failed for seed ${seed}: ${output}")
+    endif()
+    execute_process(COMMAND ${REPLAY} ${init_file} ${log_file} --compare 3
+            RESULT_VARIABLE result OUTPUT_VARIABLE output)
+    message(STATUS "seed ${seed}: ${output}")
+    if(result)
+        message(FATAL_ERROR "replay --compare failed for seed ${seed}")
+    endif()
+endforeach()
@@ -0,0 +1,570 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "event_log.h"
+
+//Defines:
+#define MAX_TOKENS 7
+#define DECIMAL 10
+#define ALL_LEVELS_CODE 0
+
+typedef struct SEventSyntax
+{
+   const char *name;
+   int num_tokens;
+   int num_names;
+   bool has_position; //the record carries a position and a value.
+} EventSyntax;
+
+//the order matches the EventOp enum.
+static const EventSyntax event_syntax[EVENT_OP_COUNT] = {
+        {"arrive", 6, 2, false}, {"quit", 3, 0, false},
+        {"all_quit", 2, 0, false}, {"rename_challenge", 3, 1, false},
+        {"rename_room", 3, 2, false}, {"room_of_visitor", 2, 1, false},
+        {"best_time", 2, 1, false}, {"most_popular", 1, 0, false},
+        {"restore_time", 2, 0, false}, {"restore_challenge", 5, 1, true},
+        {"restore_room", 3, 1, true}, {"restore_slot", 7, 1, true},
+        {"arrive_or_wait", 6, 2, false}};
+
+//Static functions list:
+static Result fill_buffer(EventLogReader *reader, int needed);
+static Result read_text_event(EventLogReader *reader, Event *event,
+                              bool *has_event);
+static Result read_binary_event(EventLogReader *reader, Event *event,
+                                bool *has_event);
+static Result parse_text_event(char **tokens, int num_tokens, Event *event);
+static Result parse_int(char *token, int *value);
+static Level level_of_code(int code);
+static int code_of_level(Level level);
+static Result copy_binary_name(EventLogReader *reader, char *target,
+                               int length);
+static void fill_record_header(Event *event, EventRecordHeader *header);
+static bool valid_event_names(Event *event);
+
+
+/*  Function opens an event log for buffered reading and detects its format.
+ * Receives: reader pointer - to initialize
+ *           path of the log file
+ * Error Codes: NULL_PARAMETER if reader or path is NULL
+ *              ILLEGAL_PARAMETER if the file can't be opened
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result open_event_log(EventLogReader *reader, char *path){
+    if (reader == NULL || path == NULL)
+        return NULL_PARAMETER;
+    reader->file = fopen(path, "rb");
+    if (!reader->file)
+        return ILLEGAL_PARAMETER;
+    //one extra byte to terminate a last line that has no new line.
+    reader->buffer = malloc(EVENT_LOG_BUFFER_SIZE + 1);
+    reader->first_name = malloc(EVENT_NAME_LENGTH);
+    reader->second_name = malloc(EVENT_NAME_LENGTH);
+    if (!reader->buffer || !reader->first_name || !reader->second_name){
+        close_event_log(reader);
+        return MEMORY_PROBLEM;
+    }
+    reader->begin = 0;
+    reader->end = 0;
+    reader->end_of_file = false;
+    reader->line = 0;
+    reader->format = EVENT_LOG_TEXT;
+    Result result = fill_buffer(reader, EVENT_LOG_MAGIC_SIZE);
+    if (result != OK){
+        close_event_log(reader);
+        return result;
+    }
+    if (reader->end - reader->begin >= EVENT_LOG_MAGIC_SIZE &&
+        memcmp(reader->buffer, EVENT_LOG_MAGIC, EVENT_LOG_MAGIC_SIZE) == 0){
+        reader->format = EVENT_LOG_BINARY;
+        reader->begin += EVENT_LOG_MAGIC_SIZE;
+    }
+    return OK;
+}
+
+/*  Function reads the next event from the log.
+ * Receives: reader pointer
+ *           event - return value is the next event
+ *           has_event - return value is false once the log is exhausted
+ * Error Codes: NULL_PARAMETER if one of the parameters is NULL
+ *              ILLEGAL_PARAMETER if the event is malformed*/
+Result read_event(EventLogReader *reader, Event *event, bool *has_event){
+    if (reader == NULL || event == NULL || has_event == NULL)
+        return NULL_PARAMETER;
+    if (reader->format == EVENT_LOG_BINARY)
+        return read_binary_event(reader, event, has_event);
+    return read_text_event(reader, event, has_event);
+}
+
+/*  Function closes the log file and releases the reader buffers.
+ * Error Codes: NULL_PARAMETER if reader is NULL*/
+Result close_event_log(EventLogReader *reader){
+    if (reader == NULL)
+        return NULL_PARAMETER;
+    if (reader->file)
+        fclose(reader->file);
+    free(reader->buffer);
+    free(reader->first_name);
+    free(reader->second_name);
+    reader->file = NULL;
+    reader->buffer = NULL;
+    reader->first_name = NULL;
+    reader->second_name = NULL;
+    return OK;
+}
+
+/*  Function writes the format marker at the start of a new log.
+ * Error Codes: NULL_PARAMETER if file is NULL*/
+Result write_event_log_header(FILE *file, EventLogFormat format){
+    if (file == NULL)
+        return NULL_PARAMETER;
+    if (format == EVENT_LOG_BINARY)
+        fwrite(EVENT_LOG_MAGIC, 1, EVENT_LOG_MAGIC_SIZE, file);
+    return OK;
+}
+
+/*  Function appends one event to a log in the given format.
+ * Receives: file to write to
+ *           format of the log
+ *           event to write
+ * Error Codes: NULL_PARAMETER if file or event is NULL
+ *              ILLEGAL_PARAMETER if the event op is unknown or a name is
+ *                                missing or too long*/
+Result write_event(FILE *file, EventLogFormat format, Event *event){
+    if (file == NULL || event == NULL)
+        return NULL_PARAMETER;
+    if (format == EVENT_LOG_BINARY){
+        //written in parts, the names may be too long for a record buffer.
+        if (event->op >= EVENT_OP_COUNT || !valid_event_names(event))
+            return ILLEGAL_PARAMETER;
+        EventRecordHeader header;
+        fill_record_header(event, &header);
+        fwrite(&header, sizeof(header), 1, file);
+        if (header.first_name_length > 0)
+            fwrite(event->first_name, 1, header.first_name_length, file);
+        if (header.second_name_length > 0)
+            fwrite(event->second_name, 1, header.second_name_length, file);
+        if (event_syntax[event->op].has_position){
+            fwrite(&event->position, sizeof(int), 1, file);
+            fwrite(&event->value, sizeof(int), 1, file);
+        }
+        return OK;
+    }
+    if (event->op >= EVENT_OP_COUNT || !valid_event_names(event))
+        return ILLEGAL_PARAMETER;
+    const char *name = event_syntax[event->op].name;
+    switch (event->op){
+        case EVENT_ARRIVE:
+        case EVENT_ARRIVE_OR_WAIT:
+            fprintf(file, "%s %s %s %d %d %d\n", name, event->first_name,
+                    event->second_name, event->id,
+                    code_of_level(event->level), event->time);
+            break;
+        case EVENT_QUIT:
+            fprintf(file, "%s %d %d\n", name, event->id, event->time);
+            break;
+        case EVENT_ALL_QUIT:
+        case EVENT_RESTORE_TIME:
+            fprintf(file, "%s %d\n", name, event->time);
+            break;
+        case EVENT_RENAME_CHALLENGE:
+            fprintf(file, "%s %d %s\n", name, event->id, event->first_name);
+            break;
+        case EVENT_RENAME_ROOM:
+            fprintf(file, "%s %s %s\n", name, event->first_name,
+                    event->second_name);
+            break;
+        case EVENT_MOST_POPULAR:
+            fprintf(file, "%s\n", name);
+            break;
+        case EVENT_RESTORE_CHALLENGE:
+            fprintf(file, "%s %d %d %d %s\n", name, event->position,
+                    event->value, event->time, event->first_name);
+            break;
+        case EVENT_RESTORE_ROOM:
+            fprintf(file, "%s %d %s\n", name, event->position,
+                    event->first_name);
+            break;
+        case EVENT_RESTORE_SLOT:
+            fprintf(file, "%s %d %d %d %d %d %s\n", name, event->position,
+                    event->value, code_of_level(event->level), event->id,
+                    event->time, event->first_name);
+            break;
+        default:
+            fprintf(file, "%s %s\n", name, event->first_name);
+            break;
+    }
+    return OK;
+}
+
+/*  Function encodes one event as a binary record, the way write_event writes
+ * it to a binary log.
+ * Receives: event to encode
+ *           buffer - at least EVENT_RECORD_MAX_SIZE bytes to encode into
+ *           length - return value is the size of the record
+ * Error Codes: NULL_PARAMETER if one of the parameters is NULL
+ *              ILLEGAL_PARAMETER if the event op is unknown or a name is
+ *                                missing or too long*/
+Result encode_event(Event *event, char *buffer, int *length){
+    if (event == NULL || buffer == NULL || length == NULL)
+        return NULL_PARAMETER;
+    if (event->op >= EVENT_OP_COUNT || !valid_event_names(event))
+        return ILLEGAL_PARAMETER;
+    EventRecordHeader header;
+    fill_record_header(event, &header);
+    char *current = buffer;
+    memcpy(current, &header, sizeof(header));
+    current += sizeof(header);
+    if (header.first_name_length)
+        memcpy(current, event->first_name, header.first_name_length);
+    current += header.first_name_length;
+    if (header.second_name_length)
+        memcpy(current, event->second_name, header.second_name_length);
+    current += header.second_name_length;
+    if (event_syntax[event->op].has_position){
+        memcpy(current, &event->position, sizeof(int));
+        memcpy(current + sizeof(int), &event->value, sizeof(int));
+        current += 2 * sizeof(int);
+    }
+    *length = (int)(current - buffer);
+    return OK;
+}
+
+/*  Function performs the event on the system through the public interface.
+ *  strings returned by the queries are released right away.
+ * Receives: system pointer
+ *           event to apply
+ * Error Codes: NULL_PARAMETER if sys or event is NULL
+ *              otherwise the result of the system function.*/
+Result apply_event(ChallengeRoomSystem *sys, Event *event){
+    if (sys == NULL || event == NULL)
+        return NULL_PARAMETER;
+    Result result = OK;
+    char *name = NULL;
+    int time;
+    bool waiting;
+    switch (event->op){
+        case EVENT_ARRIVE:
+            return visitor_arrive(sys, event->first_name, event->second_name,
+                                  event->id, event->level, event->time);
+        case EVENT_QUIT:
+            return visitor_quit(sys, event->id, event->time);
+        case EVENT_ALL_QUIT:
+            return all_visitors_quit(sys, event->time);
+        case EVENT_RENAME_CHALLENGE:
+            return change_challenge_name(sys, event->id, event->first_name);
+        case EVENT_RENAME_ROOM:
+            return change_system_room_name(sys, event->first_name,
+                                           event->second_name);
+        case EVENT_ROOM_OF_VISITOR:
+            result = system_room_of_visitor(sys, event->first_name, &name);
+            break;
+        case EVENT_BEST_TIME:
+            return best_time_of_system_challenge(sys, event->first_name,
+                                                 &time);
+        case EVENT_MOST_POPULAR:
+            result = most_popular_challenge(sys, &name);
+            break;
+        case EVENT_RESTORE_TIME:
+            return restore_system_time(sys, event->time);
+        case EVENT_RESTORE_CHALLENGE:
+            return restore_challenge(sys, event->position, event->first_name,
+                                     event->value, event->time);
+        case EVENT_RESTORE_ROOM:
+            return restore_room(sys, event->position, event->first_name);
+        case EVENT_RESTORE_SLOT:
+            return restore_visitor(sys, event->position, event->value,
+                                   event->level, event->first_name,
+                                   event->id, event->time);
+        case EVENT_ARRIVE_OR_WAIT:
+            return visitor_arrive_or_wait(sys, event->first_name,
+                                          event->second_name, event->id,
+                                          event->level, event->time,
+                                          &waiting);
+        default:
+            return ILLEGAL_PARAMETER;
+    }
+    if (result == OK)
+        free(name);
+    return result;
+}
+
+/*  Function returns the text log keyword of an op.*/
+const char *event_op_name(EventOp op){
+    if (op >= EVENT_OP_COUNT)
+        return "unknown";
+    return event_syntax[op].name;
+}
+
+//static functions
+
+/*  Function moves the unread bytes to the start of the buffer and reads until
+ * at least needed bytes are available or the file ends.
+ * Error Codes: ILLEGAL_PARAMETER if needed is larger than the buffer*/
+static Result fill_buffer(EventLogReader *reader, int needed){
+    if (needed > EVENT_LOG_BUFFER_SIZE)
+        return ILLEGAL_PARAMETER;
+    if (reader->end - reader->begin >= needed || reader->end_of_file)
+        return OK;
+    memmove(reader->buffer, reader->buffer + reader->begin,
+            (size_t)(reader->end - reader->begin));
+    reader->end -= reader->begin;
+    reader->begin = 0;
+    while (reader->end < needed && !reader->end_of_file){
+        size_t read = fread(reader->buffer + reader->end, 1,
+                            (size_t)(EVENT_LOG_BUFFER_SIZE - reader->end),
+                            reader->file);
+        if (read == 0)
+            reader->end_of_file = true;
+        reader->end += (int)read;
+    }
+    return OK;
+}
+
+/*  Function splits the next non empty line into tokens in place.
+ * Error Codes: ILLEGAL_PARAMETER if the line is malformed or too long*/
+static Result read_text_event(EventLogReader *reader, Event *event,
+                              bool *has_event){
+    while (true){
+        char *line = reader->buffer + reader->begin;
+        char *line_end = memchr(line, '\n', (size_t)(reader->end -
+                                                      reader->begin));
+        if (line_end == NULL){
+            if (!reader->end_of_file){
+                int unread = reader->end - reader->begin;
+                if (unread == EVENT_LOG_BUFFER_SIZE)
+                    return ILLEGAL_PARAMETER; //line longer than the buffer.
+                Result result = fill_buffer(reader, unread + 1);
+                if (result != OK)
+                    return result;
+                continue;
+            }
+            if (reader->begin == reader->end){
+                *has_event = false;
+                return OK;
+            }
+            line_end = reader->buffer + reader->end;
+        }
+        *line_end = '\0';
+        reader->begin = (int)(line_end - reader->buffer) + 1;
+        if (reader->begin > reader->end)
+            reader->begin = reader->end;
+        reader->line++;
+        char *tokens[MAX_TOKENS];
+        int num_tokens = 0;
+        char *current = line;
+        while (*current != '\0'){
+            while (isspace((unsigned char)*current))
+                *current++ = '\0';
+            if (*current == '\0' || *current == '#')
+                break;
+            if (num_tokens == MAX_TOKENS)
+                return ILLEGAL_PARAMETER;
+            tokens[num_tokens++] = current;
+            while (*current != '\0' && !isspace((unsigned char)*current))
+                current++;
+        }
+        if (num_tokens == 0)
+            continue; //empty or comment line.
+        *has_event = true;
+        return parse_text_event(tokens, num_tokens, event);
+    }
+}
+
+/*  Function decodes the next binary record.
+ * Error Codes: ILLEGAL_PARAMETER if the record is truncated or malformed*/
+static Result read_binary_event(EventLogReader *reader, Event *event,
+                                bool *has_event){
+    EventRecordHeader header;
+    Result result = fill_buffer(reader, sizeof(header));
+    if (result != OK)
+        return result;
+    if (reader->begin == reader->end){
+        *has_event = false;
+        return OK;
+    }
+    if (reader->end - reader->begin < (int)sizeof(header))
+        return ILLEGAL_PARAMETER;
+    memcpy(&header, reader->buffer + reader->begin, sizeof(header));
+    int names_length = header.first_name_length + header.second_name_length;
+    if (header.op >= EVENT_OP_COUNT || header.level > All_Levels ||
+        header.first_name_length >= EVENT_NAME_LENGTH ||
+        header.second_name_length >= EVENT_NAME_LENGTH)
+        return ILLEGAL_PARAMETER;
+    int extra_length = event_syntax[header.op].has_position ?
+                       2 * (int)sizeof(int) : 0;
+    int record_length = (int)sizeof(header) + names_length + extra_length;
+    result = fill_buffer(reader, record_length);
+    if (result != OK)
+        return result;
+    if (reader->end - reader->begin < record_length)
+        return ILLEGAL_PARAMETER;
+    reader->begin += sizeof(header);
+    copy_binary_name(reader, reader->first_name, header.first_name_length);
+    copy_binary_name(reader, reader->second_name, header.second_name_length);
+    event->position = 0;
+    event->value = 0;
+    if (extra_length){
+        memcpy(&event->position, reader->buffer + reader->begin, sizeof(int));
+        memcpy(&event->value, reader->buffer + reader->begin + sizeof(int),
+               sizeof(int));
+        reader->begin += extra_length;
+    }
+    reader->line++;
+    event->op = (EventOp)header.op;
+    event->level = (Level)header.level;
+    event->id = header.id;
+    event->time = header.time;
+    event->first_name = reader->first_name;
+    event->second_name = reader->second_name;
+    *has_event = true;
+    return OK;
+}
+
+/*  Function fills an event from the tokens of one text line.
+ * Error Codes: ILLEGAL_PARAMETER if the op is unknown or the tokens don't
+ *                                match it*/
+static Result parse_text_event(char **tokens, int num_tokens, Event *event){
+    int op = 0;
+    while (op < EVENT_OP_COUNT && strcmp(tokens[0], event_syntax[op].name))
+        op++;
+    if (op == EVENT_OP_COUNT || num_tokens != event_syntax[op].num_tokens)
+        return ILLEGAL_PARAMETER;
+    event->op = (EventOp)op;
+    event->level = All_Levels;
+    event->id = 0;
+    event->time = 0;
+    event->first_name = NULL;
+    event->second_name = NULL;
+    event->position = 0;
+    event->value = 0;
+    Result result = OK;
+    int level = 0;
+    switch (event->op){
+        case EVENT_ARRIVE:
+        case EVENT_ARRIVE_OR_WAIT:
+            event->first_name = tokens[1];
+            event->second_name = tokens[2];
+            result = parse_int(tokens[3], &event->id);
+            if (result == OK)
+                result = parse_int(tokens[4], &level);
+            if (result == OK)
+                result = parse_int(tokens[5], &event->time);
+            event->level = level_of_code(level);
+            break;
+        case EVENT_QUIT:
+            result = parse_int(tokens[1], &event->id);
+            if (result == OK)
+                result = parse_int(tokens[2], &event->time);
+            break;
+        case EVENT_ALL_QUIT:
+        case EVENT_RESTORE_TIME:
+            result = parse_int(tokens[1], &event->time);
+            break;
+        case EVENT_RENAME_CHALLENGE:
+            result = parse_int(tokens[1], &event->id);
+            event->first_name = tokens[2];
+            break;
+        case EVENT_RESTORE_CHALLENGE:
+            result = parse_int(tokens[1], &event->position);
+            if (result == OK)
+                result = parse_int(tokens[2], &event->value);
+            if (result == OK)
+                result = parse_int(tokens[3], &event->time);
+            event->first_name = tokens[4];
+            break;
+        case EVENT_RESTORE_ROOM:
+            result = parse_int(tokens[1], &event->position);
+            event->first_name = tokens[2];
+            break;
+        case EVENT_RESTORE_SLOT:
+            result = parse_int(tokens[1], &event->position);
+            if (result == OK)
+                result = parse_int(tokens[2], &event->value);
+            if (result == OK)
+                result = parse_int(tokens[3], &level);
+            if (result == OK)
+                result = parse_int(tokens[4], &event->id);
+            if (result == OK)
+                result = parse_int(tokens[5], &event->time);
+            event->level = level_of_code(level);
+            event->first_name = tokens[6];
+            break;
+        case EVENT_RENAME_ROOM:
+            event->first_name = tokens[1];
+            event->second_name = tokens[2];
+            break;
+        case EVENT_MOST_POPULAR:
+            break;
+        default:
+            event->first_name = tokens[1];
+            break;
+    }
+    return result;
+}
+
+/*  Function parses a decimal token.
+ * Error Codes: ILLEGAL_PARAMETER if the token is not a whole number*/
+static Result parse_int(char *token, int *value){
+    char *end = NULL;
+    long parsed = strtol(token, &end, DECIMAL);
+    if (end == token || *end != '\0')
+        return ILLEGAL_PARAMETER;
+    *value = (int)parsed;
+    return OK;
+}
+
+/*  Function maps the init file level numbering to a Level, the same way
+ * create_system does.*/
+static Level level_of_code(int code){
+    switch (code){
+        case 1: return Easy;
+        case 2: return Medium;
+        case 3: return Hard;
+        default: return All_Levels;
+    }
+}
+
+/*  Function maps a Level back to the init file numbering.*/
+static int code_of_level(Level level){
+    switch (level){
+        case Easy: return 1;
+        case Medium: return 2;
+        case Hard: return 3;
+        default: return ALL_LEVELS_CODE;
+    }
+}
+
+/*  Function copies a name that follows a binary record header and terminates
+ * it, so the event can hand it to the system as a string.*/
+static Result copy_binary_name(EventLogReader *reader, char *target,
+                               int length){
+    memcpy(target, reader->buffer + reader->begin, (size_t)length);
+    target[length] = '\0';
+    reader->begin += length;
+    return OK;
+}
+
+/*  Function fills the binary record header of an event with legal names.*/
+static void fill_record_header(Event *event, EventRecordHeader *header){
+    memset(header, 0, sizeof(*header));
+    header->op = (unsigned char)event->op;
+    header->level = (unsigned char)event->level;
+    header->id = event->id;
+    header->time = event->time;
+    header->first_name_length = event_syntax[event->op].num_names > 0 ?
+                                (unsigned short)strlen(event->first_name) : 0;
+    header->second_name_length = event_syntax[event->op].num_names > 1 ?
+                                (unsigned short)strlen(event->second_name) : 0;
+}
+
+/*  Function checks that the names the event op needs are present and short
+ * enough to be read back.*/
+static bool valid_event_names(Event *event){
+    int num_names = event_syntax[event->op].num_names;
+    if (num_names > 0 && (!event->first_name ||
+        strlen(event->first_name) >= EVENT_NAME_LENGTH))
+        return false;
+    return num_names < 2 || (event->second_name &&
+                             strlen(event->second_name) < EVENT_NAME_LENGTH);
+}
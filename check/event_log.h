@@ -0,0 +1,108 @@
+#ifndef EVENT_LOG_H_
+#define EVENT_LOG_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include "challenge_system.h"
+
+/* An event log is either a text file with one operation per line:
+ *      arrive <room_name> <visitor_name> <visitor_id> <level> <time>
+ *      arrive_or_wait <room_name> <visitor_name> <visitor_id> <level> <time>
+ *      quit <visitor_id> <time>
+ *      all_quit <time>
+ *      rename_challenge <challenge_id> <new_name>
+ *      rename_room <current_name> <new_name>
+ *      room_of_visitor <visitor_name>
+ *      best_time <challenge_name>
+ *      most_popular
+ *      restore_time <time>
+ *      restore_challenge <position> <num_visits> <best_time> <name>
+ *      restore_room <position> <name>
+ *      restore_slot <room> <slot> <level> <visitor_id> <start_time>
+ *                   <visitor_name>
+ * (levels use the init file numbering: 1 easy, 2 medium, 3 hard, anything
+ * else all levels; lines starting with '#' are skipped), or a binary file that
+ * starts with EVENT_LOG_MAGIC followed by EventRecordHeader records, each one
+ * followed by its names without a terminating '\0', and for the restore
+ * records by their position and value. the restore records describe the
+ * state of a system, positions are indexes in the init file order: a
+ * compacted journal starts with them; a restore_slot with slot -1 is a
+ * visitor that waits in the room for a challenge of the level.*/
+#define EVENT_LOG_MAGIC "CRSEVT1"
+#define EVENT_LOG_MAGIC_SIZE 8
+/* a name of a binary record is stored with its 16 bit length, so it has up
+ * to USHRT_MAX characters, and a name buffer takes the terminating '\0' too*/
+#define EVENT_NAME_LENGTH (USHRT_MAX + 1)
+#define EVENT_LOG_BUFFER_SIZE (1 << 20)
+#define EVENT_RECORD_MAX_SIZE (sizeof(EventRecordHeader) + \
+                               2 * EVENT_NAME_LENGTH + 2 * sizeof(int))
+
+typedef enum EEventOp {EVENT_ARRIVE, EVENT_QUIT, EVENT_ALL_QUIT,
+                       EVENT_RENAME_CHALLENGE, EVENT_RENAME_ROOM,
+                       EVENT_ROOM_OF_VISITOR, EVENT_BEST_TIME,
+                       EVENT_MOST_POPULAR, EVENT_RESTORE_TIME,
+                       EVENT_RESTORE_CHALLENGE, EVENT_RESTORE_ROOM,
+                       EVENT_RESTORE_SLOT, EVENT_ARRIVE_OR_WAIT,
+                       EVENT_OP_COUNT} EventOp;
+
+typedef enum EEventLogFormat {EVENT_LOG_TEXT, EVENT_LOG_BINARY} EventLogFormat;
+
+typedef struct SEventRecordHeader
+{
+   unsigned char op;
+   unsigned char level;
+   unsigned short first_name_length;
+   unsigned short second_name_length;
+   unsigned short reserved;
+   int id;
+   int time;
+} EventRecordHeader;
+
+/* names point into the reader's buffers and stay valid until the next read.
+ * position and value are only used by the restore records.*/
+typedef struct SEvent
+{
+   EventOp op;
+   Level level;
+   int id;
+   int time;
+   char *first_name;
+   char *second_name;
+   int position;
+   int value;
+} Event;
+
+typedef struct SEventLogReader
+{
+   FILE *file;
+   EventLogFormat format;
+   char *buffer;
+   int begin;
+   int end;
+   bool end_of_file;
+   int line;
+   char *first_name; //EVENT_NAME_LENGTH bytes each.
+   char *second_name;
+} EventLogReader;
+
+
+Result open_event_log(EventLogReader *reader, char *path);
+
+Result read_event(EventLogReader *reader, Event *event, bool *has_event);
+
+Result close_event_log(EventLogReader *reader);
+
+Result write_event_log_header(FILE *file, EventLogFormat format);
+
+Result write_event(FILE *file, EventLogFormat format, Event *event);
+
+Result encode_event(Event *event, char *buffer, int *length);
+
+Result apply_event(ChallengeRoomSystem *sys, Event *event);
+
+const char *event_op_name(EventOp op);
+
+
+#endif // EVENT_LOG_H_
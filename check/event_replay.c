@@ -0,0 +1,314 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event_log.h"
+#include "latency_histogram.h"
+
+/* Replays an event log against a system built from an init file and reports
+ * the throughput and the latency distribution of every operation.
+ * Usage: replay <init_file> <event_log> [--buckets] [--compare N]
+ *   compare - instead of timing, replay the log on a system made by
+ *             create_system and on one made by create_system_parallel that
+ *             runs its bulk operations on an executor of N threads, and fail
+ *             on the first event the two answer differently.*/
+
+//Defines:
+#define USAGE "usage: replay <init_file> <event_log> [--buckets] " \
+              "[--compare N]\n"
+#define NANO_IN_SECOND 1e9
+#define RESULT_COUNT (ILLEGAL_TIME + 1)
+
+typedef struct SOperationReport
+{
+   LatencyHistogram latency;
+   unsigned long long results[RESULT_COUNT];
+} OperationReport;
+
+//Static functions list:
+static Result replay_log(ChallengeRoomSystem *sys, EventLogReader *reader,
+                         OperationReport *reports);
+static void print_report(OperationReport *reports, unsigned long long elapsed,
+                         bool print_buckets);
+static void print_buckets_of(LatencyHistogram *histogram);
+static void print_system_stats(ChallengeRoomSystem *sys);
+static int compare_replays(char *init_file, char *log_file, int num_threads);
+static bool same_answer(ChallengeRoomSystem *serial,
+                        ChallengeRoomSystem *parallel, Event *event);
+static bool same_free_places(ChallengeRoomSystem *serial,
+                             ChallengeRoomSystem *parallel);
+static bool same_challenges(ChallengeRoomSystem *serial,
+                            ChallengeRoomSystem *parallel);
+static bool same_name(const char *first, const char *second);
+
+
+int main(int argc, char **argv){
+    if (argc < 3){
+        printf(USAGE);
+        return 1;
+    }
+    bool print_buckets = false;
+    int compare_threads = 0;
+    for (int i = 3; i < argc; ++i) {
+        if (!strcmp(argv[i], "--buckets"))
+            print_buckets = true;
+        else if (!strcmp(argv[i], "--compare") && i + 1 < argc)
+            compare_threads = atoi(argv[++i]);
+        else {
+            printf(USAGE);
+            return 1;
+        }
+    }
+    if (compare_threads > 0)
+        return compare_replays(argv[1], argv[2], compare_threads);
+    OperationReport *reports = calloc(EVENT_OP_COUNT, sizeof(*reports));
+    if (!reports)
+        return 1;
+    ChallengeRoomSystem *sys = NULL;
+    unsigned long long create_start = current_time_ns();
+    Result result = create_system(argv[1], &sys);
+    if (result != OK){
+        printf("Error: create_system failed with %d.\n", result);
+        free(reports);
+        return 1;
+    }
+    printf("create_system      %lluns\n", current_time_ns() - create_start);
+    char *most_popular = NULL, *best_time = NULL;
+    EventLogReader reader;
+    result = open_event_log(&reader, argv[2]);
+    if (result != OK){
+        printf("Error: cannot open event log.\n");
+        destroy_system(sys, sys->time_log, &most_popular, &best_time);
+        free(most_popular);
+        free(best_time);
+        free(reports);
+        return 1;
+    }
+    unsigned long long replay_start = current_time_ns();
+    result = replay_log(sys, &reader, reports);
+    unsigned long long elapsed = current_time_ns() - replay_start;
+    if (result != OK)
+        printf("Error: malformed event on line %d.\n", reader.line);
+    close_event_log(&reader);
+    print_report(reports, elapsed, print_buckets);
+    print_system_stats(sys);
+    unsigned long long destroy_start = current_time_ns();
+    destroy_system(sys, sys->time_log, &most_popular, &best_time);
+    printf("destroy_system     %lluns\n", current_time_ns() - destroy_start);
+    printf("most popular: %s\nbest time: %s\n",
+           most_popular ? most_popular : "(none)",
+           best_time ? best_time : "(none)");
+    free(most_popular);
+    free(best_time);
+    free(reports);
+    return result == OK ? 0 : 1;
+}
+
+//static functions
+
+/*  Function applies every event of the log and records its latency.
+ * Error Codes: ILLEGAL_PARAMETER if the log holds a malformed event*/
+static Result replay_log(ChallengeRoomSystem *sys, EventLogReader *reader,
+                         OperationReport *reports){
+    Event event;
+    bool has_event = true;
+    while (true){
+        Result result = read_event(reader, &event, &has_event);
+        if (result != OK)
+            return result;
+        if (!has_event)
+            return OK;
+        unsigned long long start = current_time_ns();
+        result = apply_event(sys, &event);
+        unsigned long long latency = current_time_ns() - start;
+        record_value(&reports[event.op].latency, latency);
+        reports[event.op].results[result]++;
+    }
+}
+
+/*  Function prints the throughput and a latency line per operation.*/
+static void print_report(OperationReport *reports, unsigned long long elapsed,
+                         bool print_buckets){
+    unsigned long long total = 0;
+    for (int op = 0; op < EVENT_OP_COUNT; ++op) {
+        total += reports[op].latency.total_count;
+    }
+    double seconds = elapsed / NANO_IN_SECOND;
+    printf("events             %llu in %.6fs (%.0f events/s)\n", total,
+           seconds, seconds > 0 ? total / seconds : 0.0);
+    for (int op = 0; op < EVENT_OP_COUNT; ++op) {
+        OperationReport *report = &reports[op];
+        if (report->latency.total_count == 0)
+            continue;
+        print_histogram(stdout, (char*)event_op_name((EventOp)op),
+                        &report->latency);
+        printf("%-18s results:", "");
+        for (int r = 0; r < RESULT_COUNT; ++r) {
+            if (report->results[r])
+                printf(" %d=%llu", r, report->results[r]);
+        }
+        printf("\n");
+        if (print_buckets)
+            print_buckets_of(&report->latency);
+    }
+}
+
+/*  Function prints the non empty buckets of a histogram.*/
+static void print_buckets_of(LatencyHistogram *histogram){
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        if (histogram->counts[i])
+            printf("%-18s <=%lluns %llu\n", "", histogram_bucket_value(i),
+                   histogram->counts[i]);
+    }
+}
+
+/*  Function prints the system hot path counters and latencies, when they were
+ * compiled in.*/
+static void print_system_stats(ChallengeRoomSystem *sys){
+    SystemStats stats;
+    system_stats(sys, &stats);
+    if (stats.api[API_CREATE_SYSTEM].calls == 0)
+        return; //compiled without CHALLENGE_SYSTEM_STATS.
+    printf("string compares    %llu\nnodes traversed    %llu\n"
+           "allocations        %llu\n", stats.string_compares,
+           stats.nodes_traversed, stats.allocations);
+    dump_system_latency(sys, stdout);
+}
+
+/*  Function replays the log on a serial and on a parallel system side by
+ * side, and checks the answers after every event, the free places after
+ * every event, and the challenges and the destroy results at the end.
+ * returns the exit status of the tool.*/
+static int compare_replays(char *init_file, char *log_file, int num_threads){
+    ChallengeRoomSystem *serial = NULL, *parallel = NULL;
+    Result result = create_system(init_file, &serial);
+    if (result == OK)
+        result = create_system_parallel(init_file, &parallel, num_threads);
+    if (result == OK)
+        result = start_system_executor(parallel, num_threads);
+    EventLogReader reader;
+    if (result == OK)
+        result = open_event_log(&reader, log_file);
+    if (result != OK){
+        printf("Error: cannot start the comparison (%d).\n", result);
+        return 1;
+    }
+    bool same = true;
+    int num_events = 0;
+    Event event;
+    bool has_event = true;
+    while (same){
+        result = read_event(&reader, &event, &has_event);
+        if (result != OK || !has_event)
+            break;
+        num_events++;
+        same = same_answer(serial, parallel, &event) &&
+               same_free_places(serial, parallel);
+    }
+    if (result != OK)
+        printf("Error: malformed event on line %d.\n", reader.line);
+    else if (!same)
+        printf("Error: the systems differ after %s on line %d.\n",
+               event_op_name(event.op), reader.line);
+    close_event_log(&reader);
+    if (same && result == OK && !same_challenges(serial, parallel)){
+        printf("Error: the challenges differ at the end of the log.\n");
+        same = false;
+    }
+    int time = serial->time_log > parallel->time_log ? serial->time_log :
+               parallel->time_log;
+    char *serial_popular = NULL, *serial_best = NULL;
+    char *parallel_popular = NULL, *parallel_best = NULL;
+    destroy_system(serial, time, &serial_popular, &serial_best);
+    destroy_system_parallel(parallel, time, &parallel_popular,
+                            &parallel_best, num_threads);
+    if (same && (!same_name(serial_popular, parallel_popular) ||
+                 !same_name(serial_best, parallel_best))){
+        printf("Error: the systems are destroyed with different results.\n");
+        same = false;
+    }
+    free(serial_popular);
+    free(serial_best);
+    free(parallel_popular);
+    free(parallel_best);
+    if (same && result == OK)
+        printf("compared %d events on %d threads: same results\n",
+               num_events, num_threads);
+    return same && result == OK ? 0 : 1;
+}
+
+/*  Function applies the event to both systems and tells if they gave the
+ * same result, and for the queries the same answer.*/
+static bool same_answer(ChallengeRoomSystem *serial,
+                        ChallengeRoomSystem *parallel, Event *event){
+    const char *first = NULL, *second = NULL;
+    Result first_result, second_result;
+    int first_time = 0, second_time = 0;
+    switch (event->op){
+        case EVENT_ROOM_OF_VISITOR:
+            first_result = system_room_of_visitor_view(serial,
+                    event->first_name, &first, NULL);
+            second_result = system_room_of_visitor_view(parallel,
+                    event->first_name, &second, NULL);
+            return first_result == second_result &&
+                   (first_result != OK || same_name(first, second));
+        case EVENT_MOST_POPULAR:
+            first_result = most_popular_challenge_view(serial, &first, NULL);
+            second_result = most_popular_challenge_view(parallel, &second,
+                                                        NULL);
+            return first_result == second_result && same_name(first, second);
+        case EVENT_BEST_TIME:
+            first_result = best_time_of_system_challenge(serial,
+                    event->first_name, &first_time);
+            second_result = best_time_of_system_challenge(parallel,
+                    event->first_name, &second_time);
+            return first_result == second_result && first_time == second_time;
+        default:
+            return apply_event(serial, event) == apply_event(parallel, event);
+    }
+}
+
+/*  Function tells if every room of both systems has as many free places.*/
+static bool same_free_places(ChallengeRoomSystem *serial,
+                             ChallengeRoomSystem *parallel){
+    if (serial->room_array_size != parallel->room_array_size)
+        return false;
+    int size = serial->room_array_size;
+    int *places = malloc(sizeof(int) * 2 * (size + 1));
+    if (!places)
+        return false;
+    int first_total = 0, second_total = 0;
+    bool same = system_free_places(serial, All_Levels, places,
+                                   &first_total) == OK &&
+                system_free_places(parallel, All_Levels, places + size,
+                                   &second_total) == OK &&
+                first_total == second_total &&
+                memcmp(places, places + size, sizeof(int) * size) == 0;
+    free(places);
+    return same;
+}
+
+/*  Function tells if the challenges of both systems have the same names,
+ * visits, best times and completion counts.*/
+static bool same_challenges(ChallengeRoomSystem *serial,
+                            ChallengeRoomSystem *parallel){
+    if (serial->challenge_array_size != parallel->challenge_array_size)
+        return false;
+    for (int i = 0; i < serial->challenge_array_size; ++i) {
+        Challenge *first = serial->challenges[i];
+        Challenge *second = parallel->challenges[i];
+        if (strcmp(first->name, second->name) ||
+            first->num_visits != second->num_visits ||
+            first->best_time != second->best_time ||
+            first->completions.total != second->completions.total)
+            return false;
+    }
+    return true;
+}
+
+/*  Function tells if two names that may be NULL are the same.*/
+static bool same_name(const char *first, const char *second){
+    if (first == NULL || second == NULL)
+        return first == second;
+    return strcmp(first, second) == 0;
+}
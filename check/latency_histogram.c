@@ -0,0 +1,157 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "latency_histogram.h"
+
+//Defines:
+#define NANO_IN_SECOND 1000000000ULL
+#define MAX_PERCENTILE 100.0
+
+//Static functions list:
+static int most_significant_bit(unsigned long long value);
+
+
+/*  Function clears every bucket and summary field of a histogram.
+ * Receives: histogram pointer
+ * Error Codes: NULL_PARAMETER if histogram is NULL*/
+Result reset_histogram(LatencyHistogram *histogram){
+    if (histogram == NULL)
+        return NULL_PARAMETER;
+    memset(histogram, 0, sizeof(*histogram));
+    return OK;
+}
+
+/*  Function adds one sample to the histogram.
+ * Receives: histogram pointer
+ *           value to record (nanoseconds for latencies)
+ * Error Codes: NULL_PARAMETER if histogram is NULL*/
+Result record_value(LatencyHistogram *histogram, unsigned long long value){
+    if (histogram == NULL)
+        return NULL_PARAMETER;
+    histogram->counts[histogram_bucket_index(value)]++;
+    if (histogram->total_count == 0 || value < histogram->min_value)
+        histogram->min_value = value;
+    if (value > histogram->max_value)
+        histogram->max_value = value;
+    histogram->total_count++;
+    histogram->total_value += value;
+    return OK;
+}
+
+/*  Function adds all the samples of source into target.
+ * Receives: target histogram pointer
+ *           source histogram pointer
+ * Error Codes: NULL_PARAMETER if target or source is NULL*/
+Result merge_histogram(LatencyHistogram *target, LatencyHistogram *source){
+    if (target == NULL || source == NULL)
+        return NULL_PARAMETER;
+    if (source->total_count == 0)
+        return OK;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        target->counts[i] += source->counts[i];
+    }
+    if (target->total_count == 0 || source->min_value < target->min_value)
+        target->min_value = source->min_value;
+    if (source->max_value > target->max_value)
+        target->max_value = source->max_value;
+    target->total_count += source->total_count;
+    target->total_value += source->total_value;
+    return OK;
+}
+
+/*  Function finds the value below which the given percentage of samples fall.
+ * Receives: histogram pointer
+ *           percentile between 0 and 100
+ *           value - return value is the highest value of the matching bucket
+ * Error Codes: NULL_PARAMETER if histogram or value is NULL
+ *              ILLEGAL_PARAMETER if percentile is out of range*/
+Result histogram_percentile(LatencyHistogram *histogram, double percentile,
+                            unsigned long long *value){
+    if (histogram == NULL || value == NULL)
+        return NULL_PARAMETER;
+    if (percentile < 0 || percentile > MAX_PERCENTILE)
+        return ILLEGAL_PARAMETER;
+    if (histogram->total_count == 0){
+        *value = 0;
+        return OK;
+    }
+    unsigned long long wanted = (unsigned long long)
+            (percentile / MAX_PERCENTILE * histogram->total_count + 0.5);
+    if (wanted == 0)
+        wanted = 1;
+    unsigned long long seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += histogram->counts[i];
+        if (seen >= wanted){
+            unsigned long long bucket_value = histogram_bucket_value(i);
+            //the bucket upper bound may overshoot the real maximum.
+            *value = bucket_value < histogram->max_value ?
+                     bucket_value : histogram->max_value;
+            return OK;
+        }
+    }
+    *value = histogram->max_value;
+    return OK;
+}
+
+/*  Function prints a one line summary of the histogram.
+ * Receives: output file
+ *           label to print before the summary
+ *           histogram pointer
+ * Error Codes: NULL_PARAMETER if one of the parameters is NULL*/
+Result print_histogram(FILE *output, char *label, LatencyHistogram *histogram){
+    if (output == NULL || label == NULL || histogram == NULL)
+        return NULL_PARAMETER;
+    unsigned long long p50, p90, p99, p999;
+    histogram_percentile(histogram, 50, &p50);
+    histogram_percentile(histogram, 90, &p90);
+    histogram_percentile(histogram, 99, &p99);
+    histogram_percentile(histogram, 99.9, &p999);
+    unsigned long long mean = histogram->total_count == 0 ? 0 :
+                           histogram->total_value / histogram->total_count;
+    fprintf(output, "%-18s count=%llu mean=%lluns min=%lluns p50=%lluns "
+                    "p90=%lluns p99=%lluns p999=%lluns max=%lluns\n",
+            label, histogram->total_count, mean, histogram->min_value, p50,
+            p90, p99, p999, histogram->max_value);
+    return OK;
+}
+
+/*  Function maps a value to its bucket. values under two sub bucket ranges
+ * are kept exactly, above that every power of two is split linearly.*/
+int histogram_bucket_index(unsigned long long value){
+    if (value < 2 * HISTOGRAM_SUB_BUCKETS)
+        return (int)value;
+    int shift = most_significant_bit(value) - HISTOGRAM_SUB_BUCKET_BITS;
+    return shift * HISTOGRAM_SUB_BUCKETS + (int)(value >> shift);
+}
+
+/*  Function returns the highest value that maps to the given bucket.*/
+unsigned long long histogram_bucket_value(int index){
+    if (index < 2 * HISTOGRAM_SUB_BUCKETS)
+        return (unsigned long long)index;
+    int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    unsigned long long top = (unsigned long long)
+            (index - shift * HISTOGRAM_SUB_BUCKETS);
+    return ((top + 1) << shift) - 1;
+}
+
+/*  Function returns a monotonic time stamp in nanoseconds.*/
+unsigned long long current_time_ns(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * NANO_IN_SECOND +
+           (unsigned long long)now.tv_nsec;
+}
+
+//static functions
+
+/*  Function returns the index of the highest set bit of a non zero value.*/
+static int most_significant_bit(unsigned long long value){
+    int bit = 0;
+    while (value >>= 1)
+        bit++;
+    return bit;
+}
@@ -0,0 +1,44 @@
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <stdio.h>
+
+#include "constants.h"
+
+/* Log-bucketed (HDR style) histogram: every power of two range is split into
+ * HISTOGRAM_SUB_BUCKETS linear buckets, so the relative error of a reported
+ * value is at most 1/HISTOGRAM_SUB_BUCKETS. */
+#define HISTOGRAM_SUB_BUCKET_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKETS ((65 - HISTOGRAM_SUB_BUCKET_BITS) * \
+                           HISTOGRAM_SUB_BUCKETS)
+
+typedef struct SLatencyHistogram
+{
+   unsigned long long counts[HISTOGRAM_BUCKETS];
+   unsigned long long total_count;
+   unsigned long long total_value;
+   unsigned long long min_value;
+   unsigned long long max_value;
+} LatencyHistogram;
+
+
+Result reset_histogram(LatencyHistogram *histogram);
+
+Result record_value(LatencyHistogram *histogram, unsigned long long value);
+
+Result merge_histogram(LatencyHistogram *target, LatencyHistogram *source);
+
+Result histogram_percentile(LatencyHistogram *histogram, double percentile,
+                            unsigned long long *value);
+
+Result print_histogram(FILE *output, char *label, LatencyHistogram *histogram);
+
+int histogram_bucket_index(unsigned long long value);
+
+unsigned long long histogram_bucket_value(int index);
+
+unsigned long long current_time_ns(void);
+
+
+#endif // LATENCY_HISTOGRAM_H_
@@ -1,6 +1,43 @@
 #include <iostream>
 
-int main() {
-    std::cout << "Hello, World!" << std::endl;
+#include "challenge_system.hpp"
+
+/* Drives a system through the C++ wrapper.
+ * Usage: cpp_demo [init_file]   (test_1.txt by default)*/
+
+using challenge_system::System;
+
+int main(int argc, char **argv) {
+    const char *init_file = argc > 1 ? argv[1] : "test_1.txt";
+    auto created = System::create(init_file);
+    if (!created) {
+        std::cerr << "create failed: " << created.error() << std::endl;
+        return 1;
+    }
+    System sys = std::move(created).value();
+    auto arrived = sys.arrive("room_1", "visitor_1", 1, Easy, 1);
+    if (arrived)
+        arrived = sys.arrive("room_4", "visitor_2", 2, All_Levels, 2);
+    if (!arrived) {
+        std::cerr << "arrive failed: " << arrived.error() << std::endl;
+        return 1;
+    }
+    std::cout << "visitor_1 is in " << sys.room_of_visitor("visitor_1").value()
+              << std::endl;
+    std::cout << "most popular: " << sys.most_popular().value() << std::endl;
+    if (!sys.quit(1, 5)) {
+        std::cerr << "quit failed" << std::endl;
+        return 1;
+    }
+    std::cout << "free places: " << sys.free_places(All_Levels).value()
+              << std::endl;
+    auto summary = sys.destroy(10);
+    if (!summary) {
+        std::cerr << "destroy failed: " << summary.error() << std::endl;
+        return 1;
+    }
+    std::cout << "best time: "
+              << (summary->best_time ? summary->best_time.get() : "none")
+              << std::endl;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,77 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "parallel_for.h"
+
+typedef struct SRangeChunk
+{
+   RangeBody body;
+   void *context;
+   int begin;
+   int end;
+   int worker;
+   pthread_t thread;
+   bool started;
+} RangeChunk;
+
+//Static functions list:
+static void *run_chunk(void *argument);
+
+
+/*  Function splits [0, count) into num_threads contiguous chunks and runs the
+ * body on each of them in parallel. the calling thread runs the first chunk,
+ * and a chunk whose thread can't be started runs on the caller as well, so
+ * the loop always completes.
+ * Receives: count - number of items
+ *           num threads - number of chunks, 1 runs the body in place
+ *           body - function handling a chunk
+ *           context - passed to every call of the body
+ * Error Codes: NULL_PARAMETER if body is NULL
+ *              ILLEGAL_PARAMETER if count is negative or num threads < 1
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result parallel_for(int count, int num_threads, RangeBody body, void *context){
+    if (body == NULL)
+        return NULL_PARAMETER;
+    if (count < 0 || num_threads < 1)
+        return ILLEGAL_PARAMETER;
+    if (num_threads > count)
+        num_threads = count > 0 ? count : 1;
+    if (num_threads == 1){
+        body(context, 0, count, 0);
+        return OK;
+    }
+    RangeChunk *chunks = malloc(sizeof(*chunks) * num_threads);
+    if (!chunks)
+        return MEMORY_PROBLEM;
+    for (int i = 0; i < num_threads; ++i) {
+        chunks[i].body = body;
+        chunks[i].context = context;
+        chunks[i].begin = (int)((long long)count * i / num_threads);
+        chunks[i].end = (int)((long long)count * (i + 1) / num_threads);
+        chunks[i].worker = i;
+        chunks[i].started = i > 0 && !pthread_create(&chunks[i].thread, NULL,
+                                                     run_chunk, &chunks[i]);
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        if (!chunks[i].started)
+            run_chunk(&chunks[i]);
+    }
+    for (int i = 1; i < num_threads; ++i) {
+        if (chunks[i].started)
+            pthread_join(chunks[i].thread, NULL);
+    }
+    free(chunks);
+    return OK;
+}
+
+//static functions
+
+/*  Function runs the body over one chunk, as a thread entry point.*/
+static void *run_chunk(void *argument){
+    RangeChunk *chunk = argument;
+    chunk->body(chunk->context, chunk->begin, chunk->end, chunk->worker);
+    return NULL;
+}
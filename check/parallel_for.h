@@ -0,0 +1,14 @@
+#ifndef PARALLEL_FOR_H_
+#define PARALLEL_FOR_H_
+
+#include "constants.h"
+
+/* body of a parallel loop: handles the items [begin, end). worker is the index
+ * of the chunk, between 0 and num_threads - 1.*/
+typedef void (*RangeBody)(void *context, int begin, int end, int worker);
+
+
+Result parallel_for(int count, int num_threads, RangeBody body, void *context);
+
+
+#endif // PARALLEL_FOR_H_
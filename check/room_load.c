@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "room_load.h"
+
+//Static functions list:
+static int free_places_of(RoomLoadEntry *entry, Level level);
+static bool less_loaded(RoomLoadEntry *first, RoomLoadEntry *second,
+                        Level level);
+static void place_entry(RoomLoad *load, Level level, int index,
+                        RoomLoadEntry entry);
+static void sift_up(RoomLoad *load, Level level, int index);
+static void sift_down(RoomLoad *load, Level level, int index);
+
+
+/*  Function builds the heaps of the rooms. the places of every level are
+ * counted once here, the occupied places are read from the rooms.
+ * Receives: rooms - array of the rooms in the init file order
+ *           num rooms - size of the array
+ *           load - return value is the new heaps
+ * Error Codes: NULL_PARAMETER if rooms or load is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result create_room_load(ChallengeRoom **rooms, int num_rooms,
+                        RoomLoad **load){
+    if (rooms == NULL || load == NULL)
+        return NULL_PARAMETER;
+    RoomLoad *new_load = calloc(1, sizeof(*new_load));
+    if (!new_load)
+        return MEMORY_PROBLEM;
+    new_load->num_rooms = num_rooms;
+    for (int level = 0; level <= All_Levels; ++level) {
+        new_load->heaps[level] = malloc(sizeof(RoomLoadEntry) *
+                                        (num_rooms > 0 ? num_rooms : 1));
+        if (!new_load->heaps[level]){
+            destroy_room_load(new_load);
+            return MEMORY_PROBLEM;
+        }
+    }
+    for (int i = 0; i < num_rooms; ++i) {
+        ChallengeRoom *room = rooms[i];
+        for (int level = 0; level <= All_Levels; ++level)
+            new_load->heaps[level][i] = (RoomLoadEntry){room, i, 0};
+        for (int j = 0; j < room->num_of_challenges; ++j)
+            if (room->challenges[j].level != All_Levels)
+                new_load->heaps[room->challenges[j].level][i].capacity++;
+        new_load->heaps[All_Levels][i].capacity = room->num_of_challenges;
+    }
+    rebuild_room_load(new_load);
+    *load = new_load;
+    return OK;
+}
+
+/*  Function moves a room to its place in every heap after its occupancy
+ * changed. rooms retired by a reload are in no heap.*/
+void update_room_load(RoomLoad *load, ChallengeRoom *room){
+    if (load == NULL || room == NULL || room->retired)
+        return;
+    for (int level = 0; level <= All_Levels; ++level) {
+        int index = room->load_position[level];
+        sift_up(load, level, index);
+        sift_down(load, level, room->load_position[level]);
+    }
+}
+
+/*  Function orders the heaps again from scratch, after the occupancy of many
+ * rooms changed at once.*/
+void rebuild_room_load(RoomLoad *load){
+    if (load == NULL)
+        return;
+    for (int level = 0; level <= All_Levels; ++level) {
+        for (int i = 0; i < load->num_rooms; ++i)
+            place_entry(load, level, i, load->heaps[level][i]);
+        for (int i = load->num_rooms / 2 - 1; i >= 0; --i)
+            sift_down(load, level, i);
+    }
+}
+
+/*  Function returns the room with the most free places of the level, or NULL
+ * if no room has a free place of the level or the level is illegal.*/
+ChallengeRoom *least_loaded_room(RoomLoad *load, Level level){
+    if (load == NULL || (unsigned)level > All_Levels || load->num_rooms == 0)
+        return NULL;
+    RoomLoadEntry *top = &load->heaps[level][0];
+    return free_places_of(top, level) > 0 ? top->room : NULL;
+}
+
+/*  Function releases the heaps. the rooms are not touched.*/
+void destroy_room_load(RoomLoad *load){
+    if (load == NULL)
+        return;
+    for (int level = 0; level <= All_Levels; ++level)
+        free(load->heaps[level]);
+    free(load);
+}
+
+//static functions
+
+/*  Function returns the free places of the entry's room in the level.*/
+static int free_places_of(RoomLoadEntry *entry, Level level){
+    return entry->capacity - entry->room->occupied[level];
+}
+
+/*  Function checks if the first room should be above the second one.*/
+static bool less_loaded(RoomLoadEntry *first, RoomLoadEntry *second,
+                        Level level){
+    int first_free = free_places_of(first, level);
+    int second_free = free_places_of(second, level);
+    if (first_free != second_free)
+        return first_free > second_free;
+    return first->position < second->position;
+}
+
+/*  Function puts an entry at an index of a heap and tells its room.*/
+static void place_entry(RoomLoad *load, Level level, int index,
+                        RoomLoadEntry entry){
+    load->heaps[level][index] = entry;
+    entry.room->load_position[level] = index;
+}
+
+static void sift_up(RoomLoad *load, Level level, int index){
+    RoomLoadEntry *heap = load->heaps[level];
+    RoomLoadEntry entry = heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!less_loaded(&entry, &heap[parent], level))
+            break;
+        place_entry(load, level, index, heap[parent]);
+        index = parent;
+    }
+    place_entry(load, level, index, entry);
+}
+
+static void sift_down(RoomLoad *load, Level level, int index){
+    RoomLoadEntry *heap = load->heaps[level];
+    RoomLoadEntry entry = heap[index];
+    while (true) {
+        int child = 2 * index + 1;
+        if (child >= load->num_rooms)
+            break;
+        if (child + 1 < load->num_rooms &&
+            less_loaded(&heap[child + 1], &heap[child], level))
+            child++;
+        if (!less_loaded(&heap[child], &entry, level))
+            break;
+        place_entry(load, level, index, heap[child]);
+        index = child;
+    }
+    place_entry(load, level, index, entry);
+}
@@ -0,0 +1,39 @@
+#ifndef ROOM_LOAD_H_
+#define ROOM_LOAD_H_
+
+#include "visitor_room.h"
+
+/* Max heaps of the rooms by their free places, one heap per level, so the
+ * room with the most free places of a level is found in O(1) and a room whose
+ * occupancy changed is moved to its place in O(log R). The rooms count their
+ * occupied places themselves; the heaps only keep the places of each level,
+ * which never change. Rooms with as many free places are ordered by their
+ * position in the init file. */
+
+typedef struct SRoomLoadEntry
+{
+   ChallengeRoom *room;
+   int position; //of the room in the init file.
+   int capacity; //places of the heap's level in the room.
+} RoomLoadEntry;
+
+typedef struct SRoomLoad
+{
+   RoomLoadEntry *heaps[All_Levels + 1];
+   int num_rooms;
+} RoomLoad;
+
+
+Result create_room_load(ChallengeRoom **rooms, int num_rooms,
+                        RoomLoad **load);
+
+void update_room_load(RoomLoad *load, ChallengeRoom *room);
+
+void rebuild_room_load(RoomLoad *load);
+
+ChallengeRoom *least_loaded_room(RoomLoad *load, Level level);
+
+void destroy_room_load(RoomLoad *load);
+
+
+#endif // ROOM_LOAD_H_
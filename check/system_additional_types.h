@@ -3,10 +3,78 @@
 #ifndef SYSTEM_ADDITIONAL_TYPES_H_
 #define SYSTEM_ADDITIONAL_TYPES_H_
 
-typedef struct SVisitorList {
-    Visitor *visitor;
-    struct SVisitorList* next_visitor;
-    struct SVisitorList* previous_visitor;
-} *VisitorList;
+#include "system_stats.h"
+#include "task_executor.h"
+#include "system_snapshot.h"
+#include "room_load.h"
+#include "visitor_table.h"
+
+struct SSystemJournal; //defined in system_journal.h
+
+/* entry of the challenge id index: the challenges sorted by id, and by their
+ * position in the challenge array for equal ids.*/
+typedef struct SChallengeIndexEntry {
+    int id;
+    int position;
+} ChallengeIndexEntry;
+
+/* entry of the challenge name order: the challenges sorted by name, and by
+ * their position in the challenge array for equal names.*/
+typedef struct SChallengeNameEntry {
+    Challenge *challenge;
+    int position;
+} ChallengeNameEntry;
+
+/* the activities of every room grouped by their challenge, so the challenges
+ * can be updated on many threads without two of them sharing one. group i is
+ * activities [starts[i], starts[i + 1]).*/
+typedef struct SActivityGroups {
+    ChallengeActivity **activities;
+    int *starts;
+    int num_groups;
+} ActivityGroups;
+
+/* one rename of change_challenge_names*/
+typedef struct SChallengeRename {
+    int challenge_id;
+    char *new_name;
+} ChallengeRename;
+
+/* what reload_system changed. draining rooms are retired rooms that still
+ * have visitors.*/
+typedef struct SReloadReport {
+    int added_challenges;
+    int retired_challenges;
+    int added_rooms;
+    int retired_rooms;
+    int draining_rooms;
+} ReloadReport;
+
+/* what the memory of a system is used for, as reported by system_memory*/
+typedef enum EMemoryCategory {MEMORY_SYSTEM, MEMORY_CHALLENGES, MEMORY_ROOMS,
+                              MEMORY_VISITORS, MEMORY_NAMES,
+                              MEMORY_ACTIVITIES, MEMORY_VISITOR_TABLE,
+                              MEMORY_INDEXES, MEMORY_SNAPSHOTS,
+                              MEMORY_JOURNAL, MEMORY_EXECUTOR,
+                              MEMORY_CATEGORIES} MemoryCategory;
+
+/* bytes a system uses by category, and how many challenges, rooms and
+ * visitors they are spread over.*/
+typedef struct SMemoryUsage {
+    size_t bytes[MEMORY_CATEGORIES];
+    size_t total;
+    int num_challenges;
+    int num_rooms;
+    int num_visitors;
+} MemoryUsage;
+
+/* one occupied slot, as reported by system_occupancy. room is the position of
+ * the room in the init file.*/
+typedef struct SOccupancyEntry {
+    int room;
+    int challenge_id;
+    int visitor_id;
+    int start_time;
+} OccupancyEntry;
 
 #endif  //SYSTEM_ADDITIONAL_TYPES
@@ -0,0 +1,394 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "system_journal.h"
+
+//Static functions list:
+static Result replay_journal(ChallengeRoomSystem *sys, char *path,
+                             int *changes, bool *rewrite);
+static Result write_system_state(ChallengeRoomSystem *sys, FILE *file);
+static Result write_room_waiters(VisitorTable *table, ChallengeRoom *room,
+                                 int position, FILE *file);
+static void write_journal_buffer(SystemJournal *journal);
+static void commit_journal(SystemJournal *journal);
+static void note_journal_error(SystemJournal *journal, Result result);
+static void free_journal(SystemJournal *journal);
+
+
+/*  Function creates a system from its init file and attaches a journal to it,
+ * replaying the journal first if it already exists.
+ * Receives: init file - string. the name of the file with the init information.
+ *          journal path - the journal file.
+ *          group size, compact every - as in attach_system_journal.
+ *          **sys - return pointer. via it user gains access to the system.
+ * Error Codes: NULL_PARAMETER if sys or journal path is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.
+ *              ILLEGAL_PARAMETER if a file is incorrect or a number is
+ *                                illegal
+ *              otherwise the error of the journal change that failed to
+ *              replay.*/
+Result create_system_journaled(char *init_file, char *journal_path,
+                               int group_size, int compact_every,
+                               ChallengeRoomSystem **sys){
+    if (sys == NULL || journal_path == NULL)
+        return NULL_PARAMETER;
+    ChallengeRoomSystem *new_sys = NULL;
+    Result result = create_system(init_file, &new_sys);
+    if (result != OK)
+        return result;
+    result = attach_system_journal(new_sys, journal_path, group_size,
+                                   compact_every);
+    if (result != OK){
+        char *most_popular = NULL, *best_time = NULL;
+        destroy_system(new_sys, new_sys->time_log, &most_popular,
+                       &best_time);
+        free(most_popular);
+        free(best_time);
+        return result;
+    }
+    *sys = new_sys;
+    return OK;
+}
+
+/*  Function replays the journal on the system and then journals every change
+ * made to it. the system should be as its init file describes it. a torn
+ * record at the end of the journal, left by a crash, ends the replay and the
+ * journal is rewritten without it.
+ * Receives: system pointer
+ *          journal path - the journal file, created if it doesn't exist.
+ *          group size - number of changes written and synced together.
+ *          compact every - number of changes between compactions, 0 compacts
+ *                          only when compact_system_journal is called.
+ * Error Codes: NULL_PARAMETER if sys or journal path is NULL
+ *              ILLEGAL_PARAMETER if group size < 1, compact every < 0, the
+ *                                system already has a journal or rooms
+ *                                retired by a reload still drain, or the
+ *                                file is not a journal or can't be written
+ *              MEMORY_PROBLEM if system was unable to allocate memory.
+ *              otherwise the error of the journal change that failed to
+ *              replay.*/
+Result attach_system_journal(ChallengeRoomSystem *sys, char *journal_path,
+                             int group_size, int compact_every){
+    if (sys == NULL || journal_path == NULL)
+        return NULL_PARAMETER;
+    if (group_size < 1 || compact_every < 0 || sys->journal ||
+        sys->num_draining_rooms > 0)
+        return ILLEGAL_PARAMETER;
+    int changes = 0;
+    bool rewrite = false;
+    Result result = replay_journal(sys, journal_path, &changes, &rewrite);
+    if (result != OK)
+        return result;
+    SystemJournal *journal = calloc(1, sizeof(*journal));
+    if (!journal)
+        return MEMORY_PROBLEM;
+    journal->path = malloc(strlen(journal_path) + 1);
+    journal->buffer = malloc(JOURNAL_BUFFER_SIZE);
+    if (!journal->path || !journal->buffer){
+        free_journal(journal);
+        return MEMORY_PROBLEM;
+    }
+    strcpy(journal->path, journal_path);
+    journal->group_size = group_size;
+    journal->compact_every = compact_every;
+    journal->changes = changes;
+    journal->error = OK;
+    sys->journal = journal;
+    if (rewrite || (compact_every && changes >= compact_every))
+        result = compact_system_journal(sys);
+    else {
+        journal->file = fopen(journal_path, "ab");
+        result = journal->file ? OK : ILLEGAL_PARAMETER;
+    }
+    if (result != OK){
+        sys->journal = NULL;
+        free_journal(journal);
+    }
+    return result;
+}
+
+/*  Function checks that a change with the given names can be journaled, so
+ * the system rejects it before applying it instead of leaving it out of the
+ * journal. a system without a journal accepts every name.
+ * Receives: system pointer
+ *          first name, second name - names of the change, NULL if unused.*/
+bool journal_accepts_names(ChallengeRoomSystem *sys, const char *first_name,
+                           const char *second_name){
+    if (sys == NULL || sys->journal == NULL)
+        return true;
+    return (first_name == NULL || strlen(first_name) < EVENT_NAME_LENGTH) &&
+           (second_name == NULL || strlen(second_name) < EVENT_NAME_LENGTH);
+}
+
+/*  Function appends a change of the system to its journal. the system calls
+ * it after every change that succeeded, and does nothing when it has no
+ * journal. the record reaches the disk when its group is committed.
+ * Receives: system pointer
+ *          event - the change.
+ * Error Codes: NULL_PARAMETER if sys or event is NULL
+ *              ILLEGAL_PARAMETER if the change can't be encoded or the
+ *                                journal failed to be written
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result journal_system_change(ChallengeRoomSystem *sys, Event *event){
+    if (sys == NULL || event == NULL)
+        return NULL_PARAMETER;
+    SystemJournal *journal = sys->journal;
+    if (journal == NULL)
+        return OK;
+    if (journal->used + (int)EVENT_RECORD_MAX_SIZE > JOURNAL_BUFFER_SIZE)
+        write_journal_buffer(journal);
+    int length = 0;
+    Result result = encode_event(event, journal->buffer + journal->used,
+                                 &length);
+    if (result != OK){
+        note_journal_error(journal, result);
+        return result;
+    }
+    journal->used += length;
+    journal->changes++;
+    if (++journal->pending >= journal->group_size)
+        commit_journal(journal);
+    if (journal->compact_every && journal->changes >= journal->compact_every)
+        return compact_system_journal(sys);
+    return journal->error;
+}
+
+/*  Function writes and syncs the changes of the current group right away.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if the system has no journal, or the
+ *                                journal failed to be written since it was
+ *                                attached.*/
+Result sync_system_journal(ChallengeRoomSystem *sys){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    if (sys->journal == NULL)
+        return ILLEGAL_PARAMETER;
+    commit_journal(sys->journal);
+    return sys->journal->error;
+}
+
+/*  Function replaces the journal with one that holds only the current state
+ * of the system. the new journal is written to a temporary file that is
+ * renamed over the old one, so a crash leaves one of them whole.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if the system has no journal or the new
+ *                                journal can't be written
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result compact_system_journal(ChallengeRoomSystem *sys){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    SystemJournal *journal = sys->journal;
+    if (journal == NULL)
+        return ILLEGAL_PARAMETER;
+    commit_journal(journal);
+    char *temp_path = malloc(strlen(journal->path) +
+                             sizeof(JOURNAL_TEMP_SUFFIX));
+    if (!temp_path)
+        return MEMORY_PROBLEM;
+    sprintf(temp_path, "%s%s", journal->path, JOURNAL_TEMP_SUFFIX);
+    FILE *file = fopen(temp_path, "wb");
+    if (!file){
+        free(temp_path);
+        return ILLEGAL_PARAMETER;
+    }
+    Result result = write_system_state(sys, file);
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+        result = ILLEGAL_PARAMETER;
+    if (fclose(file) != 0)
+        result = ILLEGAL_PARAMETER;
+    if (result == OK && rename(temp_path, journal->path) != 0)
+        result = ILLEGAL_PARAMETER;
+    if (result != OK)
+        remove(temp_path);
+    free(temp_path);
+    if (result != OK)
+        return result;
+    if (journal->file)
+        fclose(journal->file);
+    journal->file = fopen(journal->path, "ab");
+    journal->changes = 0;
+    if (!journal->file){
+        note_journal_error(journal, ILLEGAL_PARAMETER);
+        return ILLEGAL_PARAMETER;
+    }
+    return OK;
+}
+
+/*  Function commits the last group and detaches the journal from the system.
+ * the journal file stays, to be replayed by the next system.
+ * Error Codes: NULL_PARAMETER if sys is NULL
+ *              ILLEGAL_PARAMETER if the system has no journal, or the
+ *                                journal failed to be written since it was
+ *                                attached.*/
+Result close_system_journal(ChallengeRoomSystem *sys){
+    if (sys == NULL)
+        return NULL_PARAMETER;
+    SystemJournal *journal = sys->journal;
+    if (journal == NULL)
+        return ILLEGAL_PARAMETER;
+    commit_journal(journal);
+    Result result = journal->error;
+    sys->journal = NULL;
+    free_journal(journal);
+    return result;
+}
+
+//static functions
+
+/*  Function applies the records of an existing journal to the system.
+ * Receives: system pointer
+ *          path of the journal
+ *          changes - return value is the number of changes replayed, not
+ *                    counting the restore records.
+ *          rewrite - return value is true if the journal is missing, empty
+ *                    or ends with a torn record.
+ * Error Codes: ILLEGAL_PARAMETER if the file is not a journal
+ *              MEMORY_PROBLEM if system was unable to allocate memory.
+ *              otherwise the error of the change that failed to replay.*/
+static Result replay_journal(ChallengeRoomSystem *sys, char *path,
+                             int *changes, bool *rewrite){
+    *changes = 0;
+    *rewrite = true;
+    FILE *probe = fopen(path, "rb");
+    if (!probe)
+        return OK; //a new journal.
+    fclose(probe);
+    EventLogReader reader;
+    Result result = open_event_log(&reader, path);
+    if (result != OK)
+        return result;
+    if (reader.format != EVENT_LOG_BINARY){
+        bool empty = reader.begin == reader.end;
+        close_event_log(&reader);
+        return empty ? OK : ILLEGAL_PARAMETER;
+    }
+    while (result == OK){
+        Event event;
+        bool has_event = false;
+        if (read_event(&reader, &event, &has_event) != OK)
+            break; //a torn record, the rest of the journal is lost.
+        if (!has_event){
+            *rewrite = false;
+            break;
+        }
+        result = apply_event(sys, &event);
+        if (event.op < EVENT_RESTORE_TIME || event.op > EVENT_RESTORE_SLOT)
+            (*changes)++;
+    }
+    close_event_log(&reader);
+    return result;
+}
+
+/*  Function writes a journal that holds only the restore records of the
+ * current state: the system time, every challenge, every room, every
+ * occupied slot and every waiting visitor.
+ * Error Codes: ILLEGAL_PARAMETER if a record can't be encoded or written*/
+static Result write_system_state(ChallengeRoomSystem *sys, FILE *file){
+    Result result = write_event_log_header(file, EVENT_LOG_BINARY);
+    Event event = {EVENT_RESTORE_TIME, All_Levels, 0, sys->time_log,
+                   NULL, NULL, 0, 0};
+    if (result == OK)
+        result = write_event(file, EVENT_LOG_BINARY, &event);
+    for (int i = 0; i < sys->challenge_array_size && result == OK; ++i) {
+        Challenge *challenge = sys->challenges[i];
+        Event restore = {EVENT_RESTORE_CHALLENGE, All_Levels, 0,
+                         challenge->best_time, challenge->name, NULL, i,
+                         challenge->num_visits};
+        result = write_event(file, EVENT_LOG_BINARY, &restore);
+    }
+    for (int i = 0; i < sys->room_array_size && result == OK; ++i) {
+        ChallengeRoom *room = sys->rooms[i];
+        Event restore = {EVENT_RESTORE_ROOM, All_Levels, 0, 0, room->name,
+                         NULL, i, 0};
+        result = write_event(file, EVENT_LOG_BINARY, &restore);
+        for (int j = 0; j < room->num_of_challenges && result == OK; ++j) {
+            Visitor *visitor = room->challenges[j].visitor;
+            if (visitor == NULL)
+                continue;
+            Event slot = {EVENT_RESTORE_SLOT, All_Levels, visitor->visitor_id,
+                          room->challenges[j].start_time,
+                          visitor->visitor_name, NULL, i, j};
+            result = write_event(file, EVENT_LOG_BINARY, &slot);
+        }
+        if (result == OK)
+            result = write_room_waiters(&sys->visitors, room, i, file);
+    }
+    if (result == OK && ferror(file))
+        result = ILLEGAL_PARAMETER;
+    return result;
+}
+
+/*  Function writes the visitors waiting in a room in the order they arrived,
+ * merging the queues of all the levels, so replay queues them in that order
+ * again.*/
+static Result write_room_waiters(VisitorTable *table, ChallengeRoom *room,
+                                 int position, FILE *file){
+    VisitorHandle next[All_Levels + 1];
+    for (int level = 0; level <= All_Levels; ++level)
+        next[level] = room->queues[level].first;
+    Result result = OK;
+    while (result == OK) {
+        Visitor *visitor = NULL;
+        int oldest = 0;
+        for (int level = 0; level <= All_Levels; ++level) {
+            if (next[level] == NO_VISITOR)
+                continue;
+            Visitor *candidate = VISITOR_RECORD(table, next[level]);
+            if (!visitor || candidate->ticket < visitor->ticket) {
+                visitor = candidate;
+                oldest = level;
+            }
+        }
+        if (visitor == NULL)
+            break;
+        Event waiter = {EVENT_RESTORE_SLOT, visitor->waiting_level,
+                        visitor->visitor_id, 0, visitor->visitor_name, NULL,
+                        position, RESTORE_WAITING};
+        result = write_event(file, EVENT_LOG_BINARY, &waiter);
+        next[oldest] = visitor->next_waiting;
+    }
+    return result;
+}
+
+/*  Function hands the buffered records to the journal file, without syncing
+ * them.*/
+static void write_journal_buffer(SystemJournal *journal){
+    if (journal->used == 0)
+        return;
+    if (!journal->file || fwrite(journal->buffer, 1, (size_t)journal->used,
+                                 journal->file) != (size_t)journal->used)
+        note_journal_error(journal, ILLEGAL_PARAMETER);
+    journal->used = 0;
+}
+
+/*  Function writes the buffered records and syncs the journal file, which
+ * makes every change of the group durable with a single sync.*/
+static void commit_journal(SystemJournal *journal){
+    if (journal->pending == 0 && journal->used == 0)
+        return;
+    write_journal_buffer(journal);
+    if (journal->file && (fflush(journal->file) != 0 ||
+                          fsync(fileno(journal->file)) != 0))
+        note_journal_error(journal, ILLEGAL_PARAMETER);
+    journal->pending = 0;
+}
+
+/*  Function keeps the first error of the journal.*/
+static void note_journal_error(SystemJournal *journal, Result result){
+    if (journal->error == OK)
+        journal->error = result;
+}
+
+/*  Function closes the journal file and releases the journal.*/
+static void free_journal(SystemJournal *journal){
+    if (journal->file)
+        fclose(journal->file);
+    free(journal->buffer);
+    free(journal->path);
+    free(journal);
+}
@@ -0,0 +1,58 @@
+#ifndef SYSTEM_JOURNAL_H_
+#define SYSTEM_JOURNAL_H_
+
+#include <stdio.h>
+
+#include "event_log.h"
+
+/* An optional append only journal of the changes made to a system: arrive,
+ * quit, all_quit and the renames, kept as a binary event log. Records are
+ * gathered in a buffer and written and synced to disk once per group of
+ * group_size changes (group commit), so a crash loses at most the last
+ * group. Replaying the journal on top of the system's init file brings the
+ * system back. After compact_every changes the journal is replaced, through
+ * a temporary file and a rename, by one that only holds the restore records
+ * of the current state, so replay time stays bounded. The restore records
+ * keep the totals of every challenge but not its recent activity window or
+ * completion sketch, so after a compaction those restart empty, while a
+ * journal that is not compacted rebuilds them by replaying the changes. The
+ * window width is not journaled and goes back to the default. */
+
+//the buffer holds at least one record of the longest names.
+#define JOURNAL_BUFFER_SIZE (1 << 18)
+#define JOURNAL_TEMP_SUFFIX ".tmp"
+
+typedef struct SSystemJournal
+{
+   FILE *file;
+   char *path;
+   char *buffer;
+   int used;
+   int pending; //changes in the buffer that are not synced yet.
+   int group_size;
+   int changes; //changes since the last compaction.
+   int compact_every; //0 never compacts on its own.
+   Result error; //first failed write, reported by sync and close.
+} SystemJournal;
+
+
+Result create_system_journaled(char *init_file, char *journal_path,
+                               int group_size, int compact_every,
+                               ChallengeRoomSystem **sys);
+
+Result attach_system_journal(ChallengeRoomSystem *sys, char *journal_path,
+                             int group_size, int compact_every);
+
+bool journal_accepts_names(ChallengeRoomSystem *sys, const char *first_name,
+                           const char *second_name);
+
+Result journal_system_change(ChallengeRoomSystem *sys, Event *event);
+
+Result sync_system_journal(ChallengeRoomSystem *sys);
+
+Result compact_system_journal(ChallengeRoomSystem *sys);
+
+Result close_system_journal(ChallengeRoomSystem *sys);
+
+
+#endif // SYSTEM_JOURNAL_H_
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "system_snapshot.h"
+
+//Static functions list:
+static void reclaim_snapshots(SnapshotDomain *domain);
+static bool valid_reader(SnapshotDomain *domain, int reader);
+
+
+/*  Function initializes an empty snapshot domain.
+ * Receives: domain - the domain to initialize.
+ *          interval - number of system changes between automatic publishes,
+ *                     0 to publish only on request.*/
+void init_snapshot_domain(SnapshotDomain *domain, int interval){
+    memset(domain, 0, sizeof(*domain));
+    domain->epoch = 1;
+    domain->interval = interval;
+}
+
+/*  Function releases the current and every retired snapshot. no reader may
+ * be reading any more.*/
+void reset_snapshot_domain(SnapshotDomain *domain){
+    free(domain->current);
+    domain->current = NULL;
+    while (domain->retired) {
+        SystemSnapshot *next = domain->retired->next_retired;
+        free(domain->retired);
+        domain->retired = next;
+    }
+}
+
+/*  Function makes a new snapshot the current one, and retires the one it
+ * replaces. only the thread changing the system may publish.
+ * Receives: domain - the domain to publish in.
+ *          snapshot - a complete snapshot, owned by the domain from now on.*/
+void publish_snapshot(SnapshotDomain *domain, SystemSnapshot *snapshot){
+    snapshot->version = ++domain->version;
+    SystemSnapshot *old = __atomic_exchange_n(&domain->current, snapshot,
+                                              __ATOMIC_SEQ_CST);
+    domain->changes = 0;
+    if (old){
+        old->retired_epoch = __atomic_fetch_add(&domain->epoch, 1,
+                                                __ATOMIC_SEQ_CST);
+        old->next_retired = domain->retired;
+        domain->retired = old;
+    }
+    reclaim_snapshots(domain);
+}
+
+/*  Function takes a free reader slot, for a thread that will read snapshots.
+ * Error Codes: NULL_PARAMETER if reader is NULL
+ *              MEMORY_PROBLEM if all SNAPSHOT_READERS slots are taken*/
+Result snapshot_reader_open(SnapshotDomain *domain, int *reader){
+    if (reader == NULL)
+        return NULL_PARAMETER;
+    for (int i = 0; i < SNAPSHOT_READERS; ++i) {
+        int free_slot = 0;
+        if (__atomic_compare_exchange_n(&domain->readers[i].in_use,
+                                        &free_slot, 1, 0, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED)){
+            *reader = i;
+            return OK;
+        }
+    }
+    return MEMORY_PROBLEM;
+}
+
+/*  Function frees a reader slot. the reader must not be reading.
+ * Error Codes: ILLEGAL_PARAMETER if reader isn't an open slot*/
+Result snapshot_reader_close(SnapshotDomain *domain, int reader){
+    if (!valid_reader(domain, reader))
+        return ILLEGAL_PARAMETER;
+    __atomic_store_n(&domain->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&domain->readers[reader].in_use, 0, __ATOMIC_RELEASE);
+    return OK;
+}
+
+/*  Function starts a read: announces the current epoch and loads the current
+ * snapshot, which stays valid until snapshot_read_end.
+ * Error Codes: NULL_PARAMETER if snapshot is NULL
+ *              ILLEGAL_PARAMETER if reader isn't an open slot*/
+Result snapshot_read_begin(SnapshotDomain *domain, int reader,
+                           const SystemSnapshot **snapshot){
+    if (snapshot == NULL)
+        return NULL_PARAMETER;
+    if (!valid_reader(domain, reader))
+        return ILLEGAL_PARAMETER;
+    unsigned long epoch = __atomic_load_n(&domain->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&domain->readers[reader].epoch, epoch, __ATOMIC_SEQ_CST);
+    *snapshot = __atomic_load_n(&domain->current, __ATOMIC_SEQ_CST);
+    return OK;
+}
+
+/*  Function ends a read. the snapshot it returned may be freed from now on.
+ * Error Codes: ILLEGAL_PARAMETER if reader isn't an open slot*/
+Result snapshot_read_end(SnapshotDomain *domain, int reader){
+    if (!valid_reader(domain, reader))
+        return ILLEGAL_PARAMETER;
+    __atomic_store_n(&domain->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+    return OK;
+}
+
+//static functions
+
+/*  Function frees the retired snapshots no reader can still be reading: the
+ * ones retired before the oldest epoch a reader announced.*/
+static void reclaim_snapshots(SnapshotDomain *domain){
+    unsigned long oldest = __atomic_load_n(&domain->epoch, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < SNAPSHOT_READERS; ++i) {
+        unsigned long epoch = __atomic_load_n(&domain->readers[i].epoch,
+                                              __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest)
+            oldest = epoch;
+    }
+    SystemSnapshot **link = &domain->retired;
+    while (*link) {
+        SystemSnapshot *snapshot = *link;
+        if (snapshot->retired_epoch < oldest){
+            *link = snapshot->next_retired;
+            free(snapshot);
+        }
+        else
+            link = &snapshot->next_retired;
+    }
+}
+
+/*  Function checks that a reader is an open slot of the domain.*/
+static bool valid_reader(SnapshotDomain *domain, int reader){
+    return reader >= 0 && reader < SNAPSHOT_READERS &&
+           __atomic_load_n(&domain->readers[reader].in_use, __ATOMIC_ACQUIRE);
+}
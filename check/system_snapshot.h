@@ -0,0 +1,81 @@
+#ifndef SYSTEM_SNAPSHOT_H_
+#define SYSTEM_SNAPSHOT_H_
+
+#include "constants.h"
+
+/* Read optimized snapshots of the system statistics for dashboards. A
+ * snapshot is immutable once published, and readers on any thread reach it
+ * with one atomic pointer load, without ever blocking the thread that
+ * changes the system. Replaced snapshots are reclaimed with epochs: a reader
+ * announces the epoch it started reading in, and a snapshot is freed only
+ * once every reader announced a later epoch or finished reading. */
+
+#define SNAPSHOT_READERS 64
+#define SNAPSHOT_CACHE_LINE 64
+
+typedef struct SSnapshotChallenge
+{
+   const char *name;
+   int id;
+   Level level;
+   int best_time;
+   int num_visits;
+} SnapshotChallenge;
+
+typedef struct SSnapshotRoom
+{
+   const char *name;
+   int free_places[All_Levels + 1]; //free places of every level.
+} SnapshotRoom;
+
+typedef struct SSystemSnapshot
+{
+   unsigned long version;
+   int time;
+   int num_challenges;
+   SnapshotChallenge *challenges;
+   int num_rooms;
+   SnapshotRoom *rooms;
+   const char *most_popular; //NULL if no challenge was visited.
+   const char *best_timed; //NULL if no challenge has a best time.
+   unsigned long retired_epoch;
+   struct SSystemSnapshot *next_retired;
+} SystemSnapshot;
+
+/* a reader slot takes a whole cache line, so readers don't slow each other*/
+typedef struct SSnapshotReader
+{
+   unsigned long epoch; //0 while the reader isn't reading.
+   int in_use;
+   char padding[SNAPSHOT_CACHE_LINE - sizeof(unsigned long) - sizeof(int)];
+} SnapshotReader;
+
+typedef struct SSnapshotDomain
+{
+   SystemSnapshot *current;
+   unsigned long epoch;
+   unsigned long version;
+   SystemSnapshot *retired;
+   int interval; //changes between automatic publishes, 0 for none.
+   int changes;
+   SnapshotReader readers[SNAPSHOT_READERS];
+} SnapshotDomain;
+
+
+void init_snapshot_domain(SnapshotDomain *domain, int interval);
+
+void reset_snapshot_domain(SnapshotDomain *domain);
+
+void publish_snapshot(SnapshotDomain *domain, SystemSnapshot *snapshot);
+
+Result snapshot_reader_open(SnapshotDomain *domain, int *reader);
+
+Result snapshot_reader_close(SnapshotDomain *domain, int reader);
+
+Result snapshot_read_begin(SnapshotDomain *domain, int reader,
+                           const SystemSnapshot **snapshot);
+
+Result snapshot_read_end(SnapshotDomain *domain, int reader);
+
+
+#endif // SYSTEM_SNAPSHOT_H_
@@ -0,0 +1,62 @@
+#ifndef SYSTEM_STATS_H_
+#define SYSTEM_STATS_H_
+
+#include "latency_histogram.h"
+
+/* Hot path counters and per API latency histograms of a ChallengeRoomSystem.
+ * They are only collected when the system is compiled with
+ * CHALLENGE_SYSTEM_STATS (the cmake default), otherwise every STATS_ macro expands to nothing and
+ * the system has no stats fields. */
+
+typedef enum ESystemApi {API_CREATE_SYSTEM, API_VISITOR_ARRIVE,
+                         API_VISITOR_QUIT, API_ALL_VISITORS_QUIT,
+                         API_SYSTEM_ROOM_OF_VISITOR, API_CHANGE_CHALLENGE_NAME,
+                         API_CHANGE_SYSTEM_ROOM_NAME,
+                         API_BEST_TIME_OF_SYSTEM_CHALLENGE,
+                         API_MOST_POPULAR_CHALLENGE,
+                         API_CREATE_SYSTEM_PARALLEL,
+                         API_VISITOR_ARRIVE_OR_WAIT,
+                         API_VISITOR_ARRIVE_ANY_ROOM,
+                         API_CHANGE_CHALLENGE_NAMES, API_COUNT} SystemApi;
+
+typedef struct SApiStats
+{
+   unsigned long long calls;
+   unsigned long long nanoseconds;
+} ApiStats;
+
+typedef struct SSystemStats
+{
+   ApiStats api[API_COUNT];
+   unsigned long long string_compares;
+   unsigned long long nodes_traversed;
+   unsigned long long allocations;
+} SystemStats;
+
+
+#ifdef CHALLENGE_SYSTEM_STATS
+
+#define STATS_ADD(sys, counter, amount) ((sys)->stats.counter += (amount))
+
+#define STATS_API_BEGIN() unsigned long long stats_start = current_time_ns()
+
+#define STATS_API_END(sys, which) \
+   do { if ((sys) != NULL) { \
+      unsigned long long stats_elapsed = current_time_ns() - stats_start; \
+      (sys)->stats.api[which].calls++; \
+      (sys)->stats.api[which].nanoseconds += stats_elapsed; \
+      record_value(&(sys)->latency[which], stats_elapsed); \
+   } } while (0)
+
+#else
+
+#define STATS_ADD(sys, counter, amount) ((void)0)
+
+#define STATS_API_BEGIN() ((void)0)
+
+#define STATS_API_END(sys, which) ((void)0)
+
+#endif // CHALLENGE_SYSTEM_STATS
+
+
+#endif // SYSTEM_STATS_H_
@@ -0,0 +1,217 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+
+#include "task_executor.h"
+
+/* arguments of a worker thread*/
+typedef struct SWorkerStart
+{
+   TaskExecutor *executor;
+   int worker;
+} WorkerStart;
+
+//Static functions list:
+static void *worker_thread(void *argument);
+static void work(TaskExecutor *executor, int worker);
+static bool take_item(TaskExecutor *executor, int worker, int *item);
+static bool steal_items(TaskExecutor *executor, int worker, int *item);
+static void stop_workers(TaskExecutor *executor, int num_started);
+
+
+/*  Function creates an executor of num workers workers: the caller of
+ * run_tasks and num workers - 1 threads.
+ * Receives: num workers - number of workers, 1 runs every task in place.
+ *          **executor - return value is the new executor.
+ * Error Codes: NULL_PARAMETER if executor is NULL
+ *              ILLEGAL_PARAMETER if num workers < 1
+ *              MEMORY_PROBLEM if system was unable to allocate memory or
+ *                             start a thread.*/
+Result create_task_executor(int num_workers, TaskExecutor **executor){
+    if (executor == NULL)
+        return NULL_PARAMETER;
+    if (num_workers < 1)
+        return ILLEGAL_PARAMETER;
+    TaskExecutor *new_executor = calloc(1, sizeof(*new_executor));
+    if (!new_executor)
+        return MEMORY_PROBLEM;
+    new_executor->num_workers = num_workers;
+    new_executor->threads = malloc(sizeof(pthread_t) * num_workers);
+    new_executor->deques = malloc(sizeof(TaskDeque) * num_workers);
+    WorkerStart *starts = malloc(sizeof(WorkerStart) * num_workers);
+    if (!new_executor->threads || !new_executor->deques || !starts){
+        free(starts);
+        free(new_executor->threads);
+        free(new_executor->deques);
+        free(new_executor);
+        return MEMORY_PROBLEM;
+    }
+    pthread_mutex_init(&new_executor->lock, NULL);
+    pthread_cond_init(&new_executor->run_started, NULL);
+    pthread_cond_init(&new_executor->run_finished, NULL);
+    for (int i = 0; i < num_workers; ++i) {
+        pthread_mutex_init(&new_executor->deques[i].lock, NULL);
+        new_executor->deques[i].head = new_executor->deques[i].tail = 0;
+    }
+    for (int i = 1; i < num_workers; ++i) {
+        starts[i].executor = new_executor;
+        starts[i].worker = i;
+        if (pthread_create(&new_executor->threads[i], NULL, worker_thread,
+                           &starts[i])){
+            stop_workers(new_executor, i);
+            free(starts);
+            return MEMORY_PROBLEM;
+        }
+    }
+    //workers copy their start arguments before the first run begins.
+    pthread_mutex_lock(&new_executor->lock);
+    new_executor->busy_workers = num_workers - 1;
+    new_executor->run++;
+    pthread_cond_broadcast(&new_executor->run_started);
+    while (new_executor->busy_workers > 0)
+        pthread_cond_wait(&new_executor->run_finished, &new_executor->lock);
+    pthread_mutex_unlock(&new_executor->lock);
+    free(starts);
+    *executor = new_executor;
+    return OK;
+}
+
+/*  Function stops the worker threads and releases the executor.
+ * Error Codes: NULL_PARAMETER if executor is NULL*/
+Result destroy_task_executor(TaskExecutor *executor){
+    if (executor == NULL)
+        return NULL_PARAMETER;
+    stop_workers(executor, executor->num_workers);
+    return OK;
+}
+
+/*  Function runs the body on every item of [0, count) and returns once all
+ * of them were handled.
+ * Receives: executor - the executor to run on.
+ *          count - number of items.
+ *          body - function handling an item.
+ *          context - passed to every call of the body.
+ * Error Codes: NULL_PARAMETER if executor or body is NULL
+ *              ILLEGAL_PARAMETER if count is negative*/
+Result run_tasks(TaskExecutor *executor, int count, TaskBody body,
+                 void *context){
+    if (executor == NULL || body == NULL)
+        return NULL_PARAMETER;
+    if (count < 0)
+        return ILLEGAL_PARAMETER;
+    int num_workers = executor->num_workers;
+    if (num_workers == 1 || count == 1){
+        for (int i = 0; i < count; ++i)
+            body(context, i, 0);
+        return OK;
+    }
+    pthread_mutex_lock(&executor->lock);
+    for (int i = 0; i < num_workers; ++i) {
+        executor->deques[i].head = (int)((long long)count * i / num_workers);
+        executor->deques[i].tail =
+                (int)((long long)count * (i + 1) / num_workers);
+    }
+    executor->body = body;
+    executor->context = context;
+    executor->busy_workers = num_workers - 1;
+    executor->run++;
+    pthread_cond_broadcast(&executor->run_started);
+    pthread_mutex_unlock(&executor->lock);
+    work(executor, 0);
+    pthread_mutex_lock(&executor->lock);
+    while (executor->busy_workers > 0)
+        pthread_cond_wait(&executor->run_finished, &executor->lock);
+    pthread_mutex_unlock(&executor->lock);
+    return OK;
+}
+
+//static functions
+
+/*  Function is the loop of a worker thread: waits for a run, works on it
+ * until no items are left anywhere, and reports that it is done.*/
+static void *worker_thread(void *argument){
+    WorkerStart start = *(WorkerStart*)argument;
+    TaskExecutor *executor = start.executor;
+    unsigned long seen_run = 0;
+    pthread_mutex_lock(&executor->lock);
+    while (true) {
+        while (executor->run == seen_run && !executor->stopping)
+            pthread_cond_wait(&executor->run_started, &executor->lock);
+        if (executor->stopping)
+            break;
+        seen_run = executor->run;
+        bool has_body = executor->body != NULL;
+        pthread_mutex_unlock(&executor->lock);
+        if (has_body)
+            work(executor, start.worker);
+        pthread_mutex_lock(&executor->lock);
+        if (--executor->busy_workers == 0)
+            pthread_cond_signal(&executor->run_finished);
+    }
+    pthread_mutex_unlock(&executor->lock);
+    return NULL;
+}
+
+/*  Function runs the body on items until there are none left to take.*/
+static void work(TaskExecutor *executor, int worker){
+    int item;
+    while (take_item(executor, worker, &item))
+        executor->body(executor->context, item, worker);
+}
+
+/*  Function takes the last item of the worker's own range, or steals when
+ * the range is empty. returns false if no worker has items left.*/
+static bool take_item(TaskExecutor *executor, int worker, int *item){
+    TaskDeque *own = &executor->deques[worker];
+    pthread_mutex_lock(&own->lock);
+    bool found = own->head < own->tail;
+    if (found)
+        *item = --own->tail;
+    pthread_mutex_unlock(&own->lock);
+    return found || steal_items(executor, worker, item);
+}
+
+/*  Function steals the front half of the first non empty range after the
+ * worker's own. the first stolen item is returned and the rest become the
+ * worker's range. returns false if every range is empty.*/
+static bool steal_items(TaskExecutor *executor, int worker, int *item){
+    for (int i = 1; i < executor->num_workers; ++i) {
+        TaskDeque *victim =
+                &executor->deques[(worker + i) % executor->num_workers];
+        pthread_mutex_lock(&victim->lock);
+        int left = victim->tail - victim->head;
+        int first = victim->head;
+        int stolen = (left + 1) / 2;
+        victim->head += stolen;
+        pthread_mutex_unlock(&victim->lock);
+        if (stolen == 0)
+            continue;
+        *item = first;
+        TaskDeque *own = &executor->deques[worker];
+        pthread_mutex_lock(&own->lock);
+        own->head = first + 1;
+        own->tail = first + stolen;
+        pthread_mutex_unlock(&own->lock);
+        return true;
+    }
+    return false;
+}
+
+/*  Function stops the first num started worker threads and releases the
+ * executor.*/
+static void stop_workers(TaskExecutor *executor, int num_started){
+    pthread_mutex_lock(&executor->lock);
+    executor->stopping = true;
+    pthread_cond_broadcast(&executor->run_started);
+    pthread_mutex_unlock(&executor->lock);
+    for (int i = 1; i < num_started; ++i)
+        pthread_join(executor->threads[i], NULL);
+    for (int i = 0; i < executor->num_workers; ++i)
+        pthread_mutex_destroy(&executor->deques[i].lock);
+    pthread_mutex_destroy(&executor->lock);
+    pthread_cond_destroy(&executor->run_started);
+    pthread_cond_destroy(&executor->run_finished);
+    free(executor->threads);
+    free(executor->deques);
+    free(executor);
+}
@@ -0,0 +1,52 @@
+#ifndef TASK_EXECUTOR_H_
+#define TASK_EXECUTOR_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "constants.h"
+
+/* A small work stealing executor for bulk operations over many rooms. A run
+ * splits the items [0, count) into one contiguous range per worker. Every
+ * worker takes items from the back of its own range, and when it runs dry
+ * steals the front half of another worker's range. Rooms that take long to
+ * process therefore don't leave the other workers idle. The thread that
+ * starts a run works on it as worker 0, and only one run may be in progress
+ * at a time. */
+
+/* body of a run: handles a single item. worker is the index of the worker
+ * that runs it, between 0 and num_workers - 1.*/
+typedef void (*TaskBody)(void *context, int item, int worker);
+
+typedef struct STaskDeque
+{
+   pthread_mutex_t lock;
+   int head; //first item left, thieves take from here.
+   int tail; //one past the last item left, the owner takes from here.
+} TaskDeque;
+
+typedef struct STaskExecutor
+{
+   int num_workers;
+   pthread_t *threads;
+   TaskDeque *deques;
+   pthread_mutex_t lock;
+   pthread_cond_t run_started;
+   pthread_cond_t run_finished;
+   unsigned long run;
+   int busy_workers;
+   bool stopping;
+   TaskBody body;
+   void *context;
+} TaskExecutor;
+
+
+Result create_task_executor(int num_workers, TaskExecutor **executor);
+
+Result destroy_task_executor(TaskExecutor *executor);
+
+Result run_tasks(TaskExecutor *executor, int count, TaskBody body,
+                 void *context);
+
+
+#endif // TASK_EXECUTOR_H_
@@ -0,0 +1,461 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "venue_manager.h"
+
+typedef enum EVenueTaskType {TASK_CREATE, TASK_DESTROY, TASK_ARRIVE,
+                             TASK_QUIT, TASK_MOST_POPULAR, TASK_BEST_TIME
+} VenueTaskType;
+
+/* the best challenge a shard found for a cross venue query*/
+typedef struct SChallengeCandidate
+{
+   char *name;
+   int venue;
+   int value;
+} ChallengeCandidate;
+
+/* tasks live on the stack of the calling thread until they are done*/
+typedef struct SVenueTask
+{
+   VenueTaskType type;
+   int venue;
+   char **init_files;
+   char *room_name;
+   char *visitor_name;
+   int visitor_id;
+   Level level;
+   int time;
+   ChallengeCandidate candidate;
+   Result result;
+   bool done;
+   struct SVenueTask *next;
+} VenueTask;
+
+//Static functions list:
+static void *shard_worker(void *argument);
+static void submit_task(VenueShard *shard, VenueTask *task);
+static void wait_task(VenueShard *shard, VenueTask *task);
+static void run_task(VenueShard *shard, VenueTask *task);
+static Result run_on_all_shards(VenueManager *manager, VenueTask *tasks);
+static Result reduce_shard(VenueShard *shard, VenueTask *task);
+static bool better_candidate(VenueTaskType type, int value, char *name,
+                             ChallengeCandidate *current);
+static Result query_candidates(VenueManager *manager, VenueTaskType type,
+                               ChallengeCandidate *best);
+static Result route_task(VenueManager *manager, VenueTask *task);
+static void stop_shards(VenueManager *manager, int num_started);
+
+
+/*  Function creates a manager with a worker thread per shard, and builds every
+ * venue from its init file on the shard that owns it.
+ * Receives: init files - one file name per venue.
+ *          num venues, num shards - sizes of the manager.
+ *          **manager - return value is the new manager.
+ * Error Codes: NULL_PARAMETER if init files or manager is NULL
+ *              ILLEGAL_PARAMETER if a size is not positive
+ *              MEMORY_PROBLEM if system was unable to allocate memory or start
+ *                             a thread.
+ *              otherwise the first create_system error of a venue*/
+Result create_venue_manager(char **init_files, int num_venues, int num_shards,
+                            VenueManager **manager){
+    if (init_files == NULL || manager == NULL)
+        return NULL_PARAMETER;
+    if (num_venues < 1 || num_shards < 1)
+        return ILLEGAL_PARAMETER;
+    if (num_shards > num_venues)
+        num_shards = num_venues;
+    VenueManager *new_manager = malloc(sizeof(*new_manager));
+    if (!new_manager)
+        return MEMORY_PROBLEM;
+    new_manager->num_venues = num_venues;
+    new_manager->num_shards = num_shards;
+    new_manager->venues = calloc(num_venues, sizeof(ChallengeRoomSystem*));
+    new_manager->shards = calloc(num_shards, sizeof(VenueShard));
+    if (!new_manager->venues || !new_manager->shards){
+        free(new_manager->venues);
+        free(new_manager->shards);
+        free(new_manager);
+        return MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < num_shards; ++i) {
+        VenueShard *shard = &new_manager->shards[i];
+        shard->manager = new_manager;
+        shard->index = i;
+        pthread_mutex_init(&shard->lock, NULL);
+        pthread_cond_init(&shard->has_task, NULL);
+        pthread_cond_init(&shard->task_done, NULL);
+        if (pthread_create(&shard->thread, NULL, shard_worker, shard)){
+            pthread_mutex_destroy(&shard->lock);
+            pthread_cond_destroy(&shard->has_task);
+            pthread_cond_destroy(&shard->task_done);
+            stop_shards(new_manager, i);
+            free(new_manager->venues);
+            free(new_manager->shards);
+            free(new_manager);
+            return MEMORY_PROBLEM;
+        }
+    }
+    VenueTask *tasks = calloc(num_shards, sizeof(VenueTask));
+    if (!tasks){
+        destroy_venue_manager(new_manager, 0);
+        return MEMORY_PROBLEM;
+    }
+    for (int i = 0; i < num_shards; ++i) {
+        tasks[i].type = TASK_CREATE;
+        tasks[i].init_files = init_files;
+    }
+    Result result = run_on_all_shards(new_manager, tasks);
+    free(tasks);
+    if (result != OK){
+        //venues that were built start at time 0, so they can be destroyed.
+        destroy_venue_manager(new_manager, 0);
+        return result;
+    }
+    *manager = new_manager;
+    return OK;
+}
+
+/*  Function destroys every venue on its shard, then stops the workers and
+ * frees the manager.
+ * Receives: manager pointer
+ *          destroy time - passed to destroy_system of every venue.
+ * Error Codes: NULL_PARAMETER if manager is NULL
+ *              ILLEGAL_TIME if the time is earlier than a venue time log. the
+ *                           venues that were already destroyed stay so, and
+ *                           the manager stays alive to retry with a later
+ *                           time.*/
+Result destroy_venue_manager(VenueManager *manager, int destroy_time){
+    if (manager == NULL)
+        return NULL_PARAMETER;
+    VenueTask *tasks = calloc(manager->num_shards, sizeof(VenueTask));
+    if (!tasks)
+        return MEMORY_PROBLEM;
+    for (int i = 0; i < manager->num_shards; ++i) {
+        tasks[i].type = TASK_DESTROY;
+        tasks[i].time = destroy_time;
+    }
+    Result result = run_on_all_shards(manager, tasks);
+    free(tasks);
+    if (result != OK)
+        return result;
+    stop_shards(manager, manager->num_shards);
+    free(manager->venues);
+    free(manager->shards);
+    free(manager);
+    return OK;
+}
+
+/*  Function lets a visitor into a room of the given venue.
+ * Error Codes: NULL_PARAMETER if manager is NULL
+ *              ILLEGAL_PARAMETER if the venue is out of range
+ *              otherwise the result of visitor_arrive in the venue*/
+Result venue_visitor_arrive(VenueManager *manager, int venue, char *room_name,
+                            char *visitor_name, int visitor_id, Level level,
+                            int start_time){
+    VenueTask task;
+    memset(&task, 0, sizeof(task));
+    task.type = TASK_ARRIVE;
+    task.venue = venue;
+    task.room_name = room_name;
+    task.visitor_name = visitor_name;
+    task.visitor_id = visitor_id;
+    task.level = level;
+    task.time = start_time;
+    return route_task(manager, &task);
+}
+
+/*  Function lets a visitor of the given venue quit.
+ * Error Codes: NULL_PARAMETER if manager is NULL
+ *              ILLEGAL_PARAMETER if the venue is out of range
+ *              otherwise the result of visitor_quit in the venue*/
+Result venue_visitor_quit(VenueManager *manager, int venue, int visitor_id,
+                          int quit_time){
+    VenueTask task;
+    memset(&task, 0, sizeof(task));
+    task.type = TASK_QUIT;
+    task.venue = venue;
+    task.visitor_id = visitor_id;
+    task.time = quit_time;
+    return route_task(manager, &task);
+}
+
+/*  Function finds the challenge with the most visits over all venues. ties go
+ * to the lexicographically smaller name, then to the lower venue.
+ * Receives: manager pointer
+ *          challenge name - return value is a copy the caller must free, NULL
+ *                           if no challenge was visited.
+ *          venue - return value is the venue of that challenge (may be NULL)
+ * Error Codes: NULL_PARAMETER if manager or challenge name is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result global_most_popular_challenge(VenueManager *manager,
+                                     char **challenge_name, int *venue){
+    if (manager == NULL || challenge_name == NULL)
+        return NULL_PARAMETER;
+    ChallengeCandidate best;
+    Result result = query_candidates(manager, TASK_MOST_POPULAR, &best);
+    if (result != OK)
+        return result;
+    *challenge_name = best.name;
+    if (venue)
+        *venue = best.venue;
+    return OK;
+}
+
+/*  Function finds the challenge with the best recorded time over all venues.
+ * ties go to the lexicographically smaller name, then to the lower venue.
+ * Receives: manager pointer
+ *          challenge name - return value is a copy the caller must free, NULL
+ *                           if no challenge was completed.
+ *          venue, time - return values of the venue and the best time (may be
+ *                        NULL)
+ * Error Codes: NULL_PARAMETER if manager or challenge name is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result global_best_time(VenueManager *manager, char **challenge_name,
+                        int *venue, int *time){
+    if (manager == NULL || challenge_name == NULL)
+        return NULL_PARAMETER;
+    ChallengeCandidate best;
+    Result result = query_candidates(manager, TASK_BEST_TIME, &best);
+    if (result != OK)
+        return result;
+    *challenge_name = best.name;
+    if (venue)
+        *venue = best.venue;
+    if (time)
+        *time = best.value;
+    return OK;
+}
+
+//static functions
+
+/*  Function is the loop of a shard thread: it runs the queued tasks in order
+ * until the shard is stopped and drained.*/
+static void *shard_worker(void *argument){
+    VenueShard *shard = argument;
+    pthread_mutex_lock(&shard->lock);
+    while (true){
+        while (!shard->first_task && !shard->stopping)
+            pthread_cond_wait(&shard->has_task, &shard->lock);
+        VenueTask *task = shard->first_task;
+        if (!task)
+            break;
+        shard->first_task = task->next;
+        if (!shard->first_task)
+            shard->last_task = NULL;
+        pthread_mutex_unlock(&shard->lock);
+        run_task(shard, task);
+        pthread_mutex_lock(&shard->lock);
+        task->done = true;
+        pthread_cond_broadcast(&shard->task_done);
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return NULL;
+}
+
+/*  Function appends a task to the shard queue and wakes the worker.*/
+static void submit_task(VenueShard *shard, VenueTask *task){
+    task->done = false;
+    task->next = NULL;
+    pthread_mutex_lock(&shard->lock);
+    if (shard->last_task)
+        shard->last_task->next = task;
+    else
+        shard->first_task = task;
+    shard->last_task = task;
+    pthread_cond_signal(&shard->has_task);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/*  Function blocks until the shard has run the task.*/
+static void wait_task(VenueShard *shard, VenueTask *task){
+    pthread_mutex_lock(&shard->lock);
+    while (!task->done)
+        pthread_cond_wait(&shard->task_done, &shard->lock);
+    pthread_mutex_unlock(&shard->lock);
+}
+
+/*  Function performs a task on the shard thread.*/
+static void run_task(VenueShard *shard, VenueTask *task){
+    VenueManager *manager = shard->manager;
+    ChallengeRoomSystem *sys = NULL;
+    if (task->type == TASK_ARRIVE || task->type == TASK_QUIT)
+        sys = manager->venues[task->venue];
+    switch (task->type){
+        case TASK_ARRIVE:
+            task->result = visitor_arrive(sys, task->room_name,
+                                          task->visitor_name, task->visitor_id,
+                                          task->level, task->time);
+            return;
+        case TASK_QUIT:
+            task->result = visitor_quit(sys, task->visitor_id, task->time);
+            return;
+        default:
+            task->result = reduce_shard(shard, task);
+            return;
+    }
+}
+
+/*  Function runs one task per shard, all shards in parallel, and returns the
+ * first error.*/
+static Result run_on_all_shards(VenueManager *manager, VenueTask *tasks){
+    for (int i = 0; i < manager->num_shards; ++i) {
+        submit_task(&manager->shards[i], &tasks[i]);
+    }
+    Result result = OK;
+    for (int i = 0; i < manager->num_shards; ++i) {
+        wait_task(&manager->shards[i], &tasks[i]);
+        if (result == OK)
+            result = tasks[i].result;
+    }
+    return result;
+}
+
+/*  Function performs a whole shard task over every venue the shard owns. for
+ * queries the best local challenge is copied into the task candidate.
+ * Error Codes: the first error of the venues
+ *              MEMORY_PROBLEM if the candidate name can't be copied*/
+static Result reduce_shard(VenueShard *shard, VenueTask *task){
+    VenueManager *manager = shard->manager;
+    Result result = OK;
+    ChallengeCandidate *best = &task->candidate;
+    best->name = NULL;
+    best->venue = -1;
+    best->value = 0;
+    for (int v = shard->index; v < manager->num_venues;
+         v += manager->num_shards) {
+        ChallengeRoomSystem *sys = manager->venues[v];
+        Result venue_result = OK;
+        char *most_popular = NULL, *best_time = NULL;
+        switch (task->type){
+            case TASK_CREATE:
+                venue_result = create_system(task->init_files[v],
+                                             &manager->venues[v]);
+                if (venue_result != OK)
+                    manager->venues[v] = NULL;
+                break;
+            case TASK_DESTROY:
+                if (!sys)
+                    break;
+                venue_result = destroy_system(sys, task->time, &most_popular,
+                                              &best_time);
+                if (venue_result == OK){
+                    free(most_popular);
+                    free(best_time);
+                    manager->venues[v] = NULL;
+                }
+                break;
+            default:
+                for (int i = 0; sys && i < sys->challenge_array_size; ++i) {
+                    Challenge *challenge = sys->challenges[i];
+                    int value = task->type == TASK_MOST_POPULAR ?
+                                challenge->num_visits : challenge->best_time;
+                    if (value > 0 && better_candidate(task->type, value,
+                                                      challenge->name, best)){
+                        best->name = challenge->name;
+                        best->venue = v;
+                        best->value = value;
+                    }
+                }
+                break;
+        }
+        if (result == OK)
+            result = venue_result;
+    }
+    if (best->name){
+        //the venue may be renamed once the shard moves on, so keep a copy.
+        char *copy = malloc(strlen(best->name) + 1);
+        if (!copy)
+            return MEMORY_PROBLEM;
+        strcpy(copy, best->name);
+        best->name = copy;
+    }
+    return result;
+}
+
+/*  Function returns true if the challenge beats the current candidate: more
+ * visits, or a shorter best time, with ties going to the smaller name.*/
+static bool better_candidate(VenueTaskType type, int value, char *name,
+                             ChallengeCandidate *current){
+    if (current->name == NULL)
+        return true;
+    if (value != current->value)
+        return type == TASK_MOST_POPULAR ? value > current->value :
+               value < current->value;
+    return strcmp(name, current->name) < 0;
+}
+
+/*  Function sends a query to every shard in parallel and reduces the shard
+ * candidates into the best one. shards are reduced in index order, so on a
+ * full tie the lower venue wins.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result query_candidates(VenueManager *manager, VenueTaskType type,
+                               ChallengeCandidate *best){
+    VenueTask *tasks = calloc(manager->num_shards, sizeof(VenueTask));
+    if (!tasks)
+        return MEMORY_PROBLEM;
+    for (int i = 0; i < manager->num_shards; ++i) {
+        tasks[i].type = type;
+    }
+    Result result = run_on_all_shards(manager, tasks);
+    best->name = NULL;
+    best->venue = -1;
+    best->value = 0;
+    for (int i = 0; i < manager->num_shards; ++i) {
+        ChallengeCandidate *candidate = &tasks[i].candidate;
+        if (!candidate->name)
+            continue;
+        bool better = better_candidate(type, candidate->value,
+                                       candidate->name, best);
+        if (!better && best->name && candidate->value == best->value &&
+            !strcmp(candidate->name, best->name) &&
+            candidate->venue < best->venue)
+            better = true;
+        if (result == OK && better){
+            free(best->name);
+            *best = *candidate;
+        }
+        else
+            free(candidate->name);
+    }
+    free(tasks);
+    if (result != OK){
+        free(best->name);
+        best->name = NULL;
+    }
+    return result;
+}
+
+/*  Function sends a single venue task to the owning shard and waits for it.
+ * Error Codes: NULL_PARAMETER if manager is NULL
+ *              ILLEGAL_PARAMETER if the venue is out of range*/
+static Result route_task(VenueManager *manager, VenueTask *task){
+    if (manager == NULL)
+        return NULL_PARAMETER;
+    if (task->venue < 0 || task->venue >= manager->num_venues)
+        return ILLEGAL_PARAMETER;
+    VenueShard *shard = &manager->shards[task->venue % manager->num_shards];
+    submit_task(shard, task);
+    wait_task(shard, task);
+    return task->result;
+}
+
+/*  Function stops and joins the first num started shard threads.*/
+static void stop_shards(VenueManager *manager, int num_started){
+    for (int i = 0; i < num_started; ++i) {
+        VenueShard *shard = &manager->shards[i];
+        pthread_mutex_lock(&shard->lock);
+        shard->stopping = true;
+        pthread_cond_signal(&shard->has_task);
+        pthread_mutex_unlock(&shard->lock);
+        pthread_join(shard->thread, NULL);
+    }
+    for (int i = 0; i < num_started; ++i) {
+        pthread_mutex_destroy(&manager->shards[i].lock);
+        pthread_cond_destroy(&manager->shards[i].has_task);
+        pthread_cond_destroy(&manager->shards[i].task_done);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef VENUE_MANAGER_H_
+#define VENUE_MANAGER_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "challenge_system.h"
+
+/* A venue manager owns many ChallengeRoomSystems (venues). Venue v belongs to
+ * shard v % num_shards and is only ever touched by that shard's worker
+ * thread, so the systems themselves need no locking. Calls are routed to the
+ * owning shard and wait for their result; cross venue queries are sent to
+ * every shard at once and the partial results are reduced by the caller. */
+
+struct SVenueTask;
+
+typedef struct SVenueShard
+{
+   pthread_t thread;
+   pthread_mutex_t lock;
+   pthread_cond_t has_task;
+   pthread_cond_t task_done;
+   struct SVenueTask *first_task;
+   struct SVenueTask *last_task;
+   bool stopping;
+   struct SVenueManager *manager;
+   int index;
+} VenueShard;
+
+typedef struct SVenueManager
+{
+   int num_venues;
+   ChallengeRoomSystem **venues;
+   int num_shards;
+   VenueShard *shards;
+} VenueManager;
+
+
+Result create_venue_manager(char **init_files, int num_venues, int num_shards,
+                            VenueManager **manager);
+
+Result destroy_venue_manager(VenueManager *manager, int destroy_time);
+
+Result venue_visitor_arrive(VenueManager *manager, int venue, char *room_name,
+                            char *visitor_name, int visitor_id, Level level,
+                            int start_time);
+
+Result venue_visitor_quit(VenueManager *manager, int venue, int visitor_id,
+                          int quit_time);
+
+Result global_most_popular_challenge(VenueManager *manager,
+                                     char **challenge_name, int *venue);
+
+Result global_best_time(VenueManager *manager, char **challenge_name,
+                        int *venue, int *time);
+
+
+#endif // VENUE_MANAGER_H_
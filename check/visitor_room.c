@@ -12,6 +12,66 @@
 
 static int find_challenge_available(ChallengeRoom *room, Level level);
 //static function to find the smallest lexicography available room
+static void seat_visitor(ChallengeRoom *room, ChallengeActivity *activity,
+                         Visitor *visitor, int start_time);
+static void leave_wait_queue(VisitorTable *table, Visitor *visitor);
+static void empty_wait_queues(ChallengeRoom *room);
+static void note_occupancy(ChallengeRoom *room, ChallengeActivity *activity,
+                           int change);
+static double moving_average(double average, double sample, int num_samples);
+static void note_arrival(ChallengeRoom *room, Level level, int time);
+static void note_service(ChallengeRoom *room, ChallengeActivity *activity,
+                         int time);
+static void hand_off_challenge(VisitorTable *table, ChallengeRoom *room,
+                               ChallengeActivity *activity, int time);
+
+/* the slot scans are specialized per level: LEVEL_KERNELS defines a counting
+ * and a searching kernel for one level filter, and the kernel of the
+ * requested level is picked once per call, so the loops test no Level.*/
+#define MATCH_ALL_LEVELS(activity) true
+#define MATCH_EASY(activity) ((activity)->level == Easy)
+#define MATCH_MEDIUM(activity) ((activity)->level == Medium)
+#define MATCH_HARD(activity) ((activity)->level == Hard)
+
+#define LEVEL_KERNELS(suffix, matches) \
+static int count_free_##suffix(ChallengeRoom *room){ \
+    int sum = 0; \
+    for (int i = 0; i < room->num_of_challenges; ++i) \
+        if (room->challenges[i].visitor == NULL && \
+            matches(&room->challenges[i])) \
+            sum++; \
+    return sum; \
+} \
+static int find_free_##suffix(ChallengeRoom *room){ \
+    int current = NOT_FOUND; \
+    const char *current_name = NULL; \
+    for (int i = 0; i < room->num_of_challenges; ++i) { \
+        ChallengeActivity *activity = &room->challenges[i]; \
+        if (activity->visitor != NULL || !matches(activity)) \
+            continue; \
+        if (current == NOT_FOUND || \
+            strcmp(activity->challenge->name, current_name) < 0){ \
+            current = i; \
+            current_name = activity->challenge->name; \
+        } \
+    } \
+    return current; \
+}
+
+LEVEL_KERNELS(easy, MATCH_EASY)
+LEVEL_KERNELS(medium, MATCH_MEDIUM)
+LEVEL_KERNELS(hard, MATCH_HARD)
+LEVEL_KERNELS(all_levels, MATCH_ALL_LEVELS)
+
+typedef int (*LevelKernel)(ChallengeRoom *room);
+
+//indexed by Level.
+static const LevelKernel count_free_kernels[All_Levels + 1] = {
+        count_free_easy, count_free_medium, count_free_hard,
+        count_free_all_levels};
+static const LevelKernel find_free_kernels[All_Levels + 1] = {
+        find_free_easy, find_free_medium, find_free_hard,
+        find_free_all_levels};
 
 //functions:
 /*  Function initializes a specific challenge activity
@@ -23,6 +83,7 @@ Result init_challenge_activity(ChallengeActivity *activity
         return NULL_PARAMETER;
     activity->challenge = challenge;
     activity->visitor= NULL;
+    activity->level = challenge->level;
     return OK;
 }
 
@@ -49,35 +110,38 @@ Result init_visitor(Visitor* visitor, char* name, int id){
     //checking if received null parameters
     if(visitor==NULL || name==NULL )
         return NULL_PARAMETER;
-    //malloc required in the instruction
-    char* copy_name= malloc(sizeof(char)*(strlen(name)+1));
-    if (copy_name==NULL)
-        return MEMORY_PROBLEM;
-    //check for memory fault
-    strcpy(copy_name,name);
+    //long names are allocated, short ones kept in the visitor
+    visitor->visitor_name=NULL;
+    Result result=store_name(&visitor->visitor_name, visitor->inline_name,
+                             name);
+    if (result!=OK)
+        return result;
     //initialize all fields
-    visitor->visitor_name=copy_name;
     visitor->visitor_id=id;
-    visitor->room_name=NULL;
-    visitor->current_challenge=NULL;
+    visitor->slot=NO_SLOT;
+    visitor->room=NO_ROOM;
+    visitor->next_waiting=NO_VISITOR;
+    visitor->previous_waiting=NO_VISITOR;
     return OK;
 }
 
 /*  Function resets a specific visitor to NULL.
- * receives visitor pointer
- * Error Codes: NULL_PARAMETER if visitor or name is NULL
+ * receives visitor table, that the visitor's links point into
+ *          visitor pointer
+ * Error Codes: NULL_PARAMETER if table or visitor is NULL
  *              MEMORY_PROBLEM if system was unable to allocate memory.*/
-Result reset_visitor(Visitor *visitor){
+Result reset_visitor(VisitorTable *table, Visitor *visitor){
     //checking parameter if null
-    if(visitor == NULL)
+    if(table == NULL || visitor == NULL)
         return NULL_PARAMETER;
-    //checking if the pointer is NULL
-    if(visitor->visitor_name !=NULL){
-        free(visitor->visitor_name);
-    }
+    //releasing the name if it was allocated
+    release_name(&visitor->visitor_name, visitor->inline_name);
+    //a waiting visitor must not stay in the queue of its room
+    if(visitor->room!=NO_ROOM && visitor->slot==NO_SLOT)
+        leave_wait_queue(table, visitor);
     //reseting all struct param to NULL (no info lost due to other pointers)
-    visitor->current_challenge=NULL;
-    visitor->room_name=NULL;
+    visitor->room=NO_ROOM;
+    visitor->slot=NO_SLOT;
     visitor->visitor_id = 0;
     return OK;
 }
@@ -94,18 +158,16 @@ Result init_room(ChallengeRoom *room, char *name, int num_challenges){
         return NULL_PARAMETER;
     if(num_challenges < 1)
         return ILLEGAL_PARAMETER;
-    //checks for input faults
-    char* copy_name=malloc(sizeof(char)*(strlen(name)+1));
-    if (copy_name==NULL)
-        return MEMORY_PROBLEM;
-    strcpy(copy_name,name);
     //setting a copy of name
-    room->name=copy_name;
+    room->name=NULL;
+    Result result=store_name(&room->name, room->inline_name, name);
+    if (result!=OK)
+        return result;
     //starting an array of *challenges fields inside not initialize
     ChallengeActivity *challenges =malloc(sizeof(ChallengeActivity) *
                                            num_challenges);
     if(challenges==NULL){
-        free(copy_name);
+        release_name(&room->name, room->inline_name);
         return MEMORY_PROBLEM;
     }
     //ChallengeActivity curr_challenge;
@@ -123,6 +185,12 @@ Result init_room(ChallengeRoom *room, char *name, int num_challenges){
     }*/
     room->challenges=challenges;
     room->num_of_challenges=num_challenges;
+    empty_wait_queues(room);
+    room->next_ticket=0;
+    memset(room->occupied, 0, sizeof(room->occupied));
+    memset(room->forecast, 0, sizeof(room->forecast));
+    room->retired=false;
+    room->index=NO_ROOM;
     return OK;
 }
 
@@ -132,9 +200,8 @@ Result init_room(ChallengeRoom *room, char *name, int num_challenges){
 Result reset_room(ChallengeRoom *room){
     if(room==NULL || room->name==NULL)
         return NULL_PARAMETER;
-    //free to release the name that was allocated
-    free(room->name);
-    room->name=NULL;
+    //release the name if it was allocated
+    release_name(&room->name, room->inline_name);
 
     for(int i=0 ; i< room->num_of_challenges ; i++){
         Result result = reset_challenge_activity( &(room->challenges[i]) );
@@ -144,6 +211,9 @@ Result reset_room(ChallengeRoom *room){
     free(room->challenges);
     room->challenges = NULL;
     room->num_of_challenges = 0;
+    empty_wait_queues(room);
+    memset(room->occupied, 0, sizeof(room->occupied));
+    memset(room->forecast, 0, sizeof(room->forecast));
     return OK;
 }
 
@@ -157,25 +227,12 @@ Result num_of_free_places_for_level(ChallengeRoom *room, Level level,
                                     int* places){
     if (room== NULL)
         return NULL_PARAMETER;
-    int sum=0;
-    // if its all levels, find the number of free challenges
-    if (level==All_Levels){
-        for (int i = 0; i <room->num_of_challenges ; ++i) {
-            if (room->challenges[i].visitor == NULL)
-                sum++;
-        }
-        *places=sum;
-        return OK;
-    }//if a specific level add a condition that the challenge level is the same
-    else{
-        for (int j = 0; j <room->num_of_challenges ; ++j) {
-            if (room->challenges[j].visitor==NULL &&
-                room->challenges[j].challenge->level==level)
-                sum++;
-        }
-        *places=sum;
+    if ((unsigned)level > All_Levels){
+        *places = 0; //no challenge has an unknown level.
         return OK;
     }
+    *places = count_free_kernels[level](room);
+    return OK;
 }
 
 /*  Function changes a specific room's name to given parameter.
@@ -186,40 +243,56 @@ Result num_of_free_places_for_level(ChallengeRoom *room, Level level,
 Result change_room_name(ChallengeRoom *room, char* new_name){
     if(room==NULL || new_name==NULL)
         return NULL_PARAMETER;
-    // allocating memory for the new name
-    char* copy_name=malloc(sizeof(char)*(strlen(new_name)+1));
-    if (copy_name==NULL)
-        return MEMORY_PROBLEM;
-    //copying and redirecting the room->name to new name
-    strcpy(copy_name,new_name);
-    if(room->name!=NULL)
-        free(room->name);
-    //to prevent memory leak
-    room->name=copy_name;
-    return OK;
+    //copying and redirecting the room->name to new name, the old name is
+    //released to prevent memory leak
+    return store_name(&room->name, room->inline_name, new_name);
 }
 
 /*  Function finds the room a specific visitor is in.
- * Receives: visitor pointer
+ * Receives: visitor table, that holds the visitor's room
+ *           visitor pointer
  *           the room name requested as a pointer to string
  *
- * Error Codes: NULL_PARAMETER if visitor is NULL
+ * Error Codes: NULL_PARAMETER if table or visitor is NULL
  *              MEMORY_PROBLEM if system was unable to allocate memory.
  *              NOT_IN_ROOM  the room name in type visitor is not initialized*/
 //for this function must free the pointer that it returns!
-Result room_of_visitor(Visitor *visitor, char** room_name){
-    if(visitor==NULL)
+Result room_of_visitor(VisitorTable *table, Visitor *visitor,
+                       char** room_name){
+    if(table==NULL || visitor==NULL)
         return NULL_PARAMETER;
-    if(visitor->room_name==NULL)
+    if(visitor->slot==NO_SLOT)
         return NOT_IN_ROOM;
-    char* copy_room_name= malloc((sizeof(char)*strlen(*visitor->room_name))+1);
+    ChallengeRoom *room=VISITOR_ROOM(table, visitor);
+    char* copy_room_name= malloc((sizeof(char)*strlen(room->name))+1);
     if(copy_room_name==NULL)
         return MEMORY_PROBLEM;
-    strcpy(copy_room_name,(*visitor->room_name));
+    strcpy(copy_room_name,room->name);
     *room_name=copy_room_name;
     return OK;
 }
 
+/*  Function finds the room a specific visitor is in, like room_of_visitor,
+ * but lends the room name instead of copying it.
+ * Receives: visitor table, that holds the visitor's room
+ *           visitor pointer
+ *           the room name requested as a pointer to string. it stays valid
+ *           until the room is renamed or the visitor leaves it.
+ *           the length of the room name as a pointer to int. may be NULL.
+ * Error Codes: NULL_PARAMETER if table, visitor or room name is NULL
+ *              NOT_IN_ROOM  the room name in type visitor is not initialized*/
+Result room_of_visitor_view(VisitorTable *table, Visitor *visitor,
+                            const char **room_name, int *length){
+    if(table==NULL || visitor==NULL || room_name==NULL)
+        return NULL_PARAMETER;
+    if(visitor->slot==NO_SLOT)
+        return NOT_IN_ROOM;
+    *room_name=VISITOR_ROOM(table, visitor)->name;
+    if(length!=NULL)
+        *length=(int)strlen(*room_name);
+    return OK;
+}
+
 /*  Function finds the smallest lexicographic name of a challenge
  * that's free and puts visitor in it. updates fields in challenge & visitor.
  * Receives: ChallengeRoom pointer
@@ -234,45 +307,217 @@ Result visitor_enter_room(ChallengeRoom *room, Visitor *visitor,Level level,
                           int start_time) {
     if (room == NULL || visitor == NULL)
         return NULL_PARAMETER;
-    if (visitor->room_name != NULL)
+    if (visitor->room != NO_ROOM)
         return ALREADY_IN_ROOM;
+    note_arrival(room, level, start_time);
     int available_challenges = find_challenge_available(room, level);
     //-1 if no challenge found
     if(available_challenges==NOT_FOUND)
         return NO_AVAILABLE_CHALLENGES;
     else{
-        room->challenges[available_challenges].visitor=visitor;
-        room->challenges[available_challenges].start_time=start_time;
-        inc_num_visits(room->challenges[available_challenges].challenge);
-        visitor->current_challenge=&(room->challenges[available_challenges]);
-        visitor->room_name= &(room->name);
+        seat_visitor(room, &(room->challenges[available_challenges]), visitor,
+                     start_time);
         return OK;
     }
 }
 
 /*  Function updates the best time (if needed) and resets related room fields in
  * visitor type.
- * Receives: visitor pointer
+ * Receives: visitor table, that holds the visitor's room and the waiters
+ *           visitor pointer
  *           quit time as int
- * Error Codes: NULL_PARAMETER if visitor is NULL
+ * Error Codes: NULL_PARAMETER if table or visitor is NULL
  *              NOT_IN_ROOM if the visitor is not in any room*/
-Result visitor_quit_room(Visitor *visitor, int quit_time){
-    if(visitor==NULL)
+Result visitor_quit_room(VisitorTable *table, Visitor *visitor,
+                         int quit_time){
+    if(table==NULL || visitor==NULL)
         return NULL_PARAMETER;
-    if(visitor->room_name==NULL)
+    if(visitor->room==NO_ROOM)
         return NOT_IN_ROOM;
+    if(visitor->slot==NO_SLOT){
+        leave_wait_queue(table, visitor); //gave up waiting for a challenge.
+        return OK;
+    }
+    ChallengeRoom *room=VISITOR_ROOM(table, visitor);
+    ChallengeActivity *activity=&(room->challenges[visitor->slot]);
     //local parameter time_of_challenge holds the difference between quit time
     //and start time
-    int time_of_challenge= quit_time-(visitor->current_challenge->start_time);
-    if( time_of_challenge < visitor->current_challenge->challenge->best_time ||
-        visitor->current_challenge->challenge->best_time == 0)
-        set_best_time_of_challenge(visitor->current_challenge->challenge,
-                                   time_of_challenge);
+    int time_of_challenge= quit_time-(activity->start_time);
+    if( time_of_challenge < activity->challenge->best_time ||
+        activity->challenge->best_time == 0)
+        set_best_time_of_challenge(activity->challenge, time_of_challenge);
     // if its better than best time update best time
-    visitor->current_challenge->visitor=NULL;
-    visitor->current_challenge=NULL;
-    visitor->room_name= NULL;
+    record_challenge_completion(activity->challenge, quit_time,
+                                time_of_challenge);
+    note_service(room, activity, time_of_challenge);
+    activity->visitor=NULL;
+    visitor->slot=NO_SLOT;
+    visitor->room=NO_ROOM;
     //reset all fields of visitor
+    note_occupancy(room, activity, -1);
+    hand_off_challenge(table, room, activity, quit_time);
+    return OK;
+}
+
+/*  Function puts a visitor at the end of the room's queue of a level, to wait
+ * for a challenge when the room has none free. the visitor is seated by
+ * visitor_quit_room, when another visitor frees a challenge of that level.
+ * Receives: visitor table, that holds the room and the visitor
+ *           ChallengeRoom pointer, added to the table
+ *           handle of the visitor
+ *           level to wait for, All_Levels takes a challenge of any level
+ * Error Codes: NULL_PARAMETER if table or room is NULL
+ *              ILLEGAL_PARAMETER if the level is unknown
+ *              ALREADY_IN_ROOM if the visitor is in a room or waits for one*/
+Result visitor_wait_in_room(VisitorTable *table, ChallengeRoom *room,
+                            VisitorHandle handle, Level level){
+    if (table == NULL || room == NULL)
+        return NULL_PARAMETER;
+    if ((unsigned)level > All_Levels)
+        return ILLEGAL_PARAMETER;
+    Visitor *visitor = VISITOR_RECORD(table, handle);
+    if (visitor->room != NO_ROOM)
+        return ALREADY_IN_ROOM;
+    WaitQueue *queue = &room->queues[level];
+    visitor->room = room->index;
+    visitor->waiting_level = level;
+    visitor->ticket = room->next_ticket++;
+    visitor->next_waiting = NO_VISITOR;
+    visitor->previous_waiting = queue->last;
+    if (queue->last != NO_VISITOR)
+        VISITOR_RECORD(table, queue->last)->next_waiting = handle;
+    else
+        queue->first = handle;
+    queue->last = handle;
+    queue->length++;
+    return OK;
+}
+
+/*  Function predicts how soon a place of the level frees up in the room, from
+ * the moving averages of its arrivals and challenge times. the visitors in
+ * the challenges are taken to quit independently after the average time, so
+ * one of the n busy challenges frees up after average / n, and a new visitor
+ * gets a place after the visitors that wait before it.
+ * Receives: ChallengeRoom pointer
+ *           level - the level a new visitor would ask for
+ *           forecast - return value is the prediction. the time to a free
+ *                      place is FORECAST_UNKNOWN before the first quit of
+ *                      the level, or if the room has no challenge of it.
+ * Error Codes: NULL_PARAMETER if room or forecast is NULL
+ *              ILLEGAL_PARAMETER if the level is unknown*/
+Result room_forecast(ChallengeRoom *room, Level level, RoomForecast *forecast){
+    if (room == NULL || forecast == NULL)
+        return NULL_PARAMETER;
+    if ((unsigned)level > All_Levels)
+        return ILLEGAL_PARAMETER;
+    LevelForecast *averages = &room->forecast[level];
+    forecast->arrival_rate = averages->num_arrivals > 1 &&
+                             averages->mean_gap > 0 ?
+                             1 / averages->mean_gap : 0;
+    forecast->mean_service = averages->mean_service;
+    forecast->free_places = count_free_kernels[level](room);
+    forecast->waiting = room->queues[level].length;
+    for (int i = 0; i < All_Levels && level == All_Levels; ++i)
+        forecast->waiting += room->queues[i].length;
+    if (level != All_Levels)
+        forecast->waiting += room->queues[All_Levels].length;
+    int busy = room->occupied[level];
+    if (forecast->free_places > 0)
+        forecast->time_to_free_place = 0;
+    else if (busy == 0 || averages->num_services == 0)
+        forecast->time_to_free_place = FORECAST_UNKNOWN;
+    else {
+        double time = averages->mean_service * (forecast->waiting + 1) / busy;
+        forecast->time_to_free_place = (int)time + ((int)time < time);
+    }
+    return OK;
+}
+
+/*  Function puts a visitor back in a given challenge of the room, the way it
+ * was when the room state was saved. unlike visitor_enter_room the visit is
+ * not counted again.
+ * Receives: ChallengeRoom pointer
+ *           slot - index of the challenge in the room
+ *           visitor pointer
+ *           start time of the visitor in the challenge
+ * Error Codes: NULL_PARAMETER if room or visitor is NULL
+ *              ILLEGAL_PARAMETER if the slot is out of range or taken
+ *              ALREADY_IN_ROOM if the visitor is in a room*/
+Result visitor_resume_challenge(ChallengeRoom *room, int slot,
+                                Visitor *visitor, int start_time){
+    if (room == NULL || visitor == NULL)
+        return NULL_PARAMETER;
+    if (visitor->room != NO_ROOM)
+        return ALREADY_IN_ROOM;
+    if (slot < 0 || slot >= room->num_of_challenges ||
+        room->challenges[slot].visitor != NULL)
+        return ILLEGAL_PARAMETER;
+    room->challenges[slot].visitor = visitor;
+    room->challenges[slot].start_time = start_time;
+    visitor->slot = slot;
+    visitor->room = room->index;
+    note_occupancy(room, &(room->challenges[slot]), 1);
+    return OK;
+}
+
+/*  Function quits every visitor in the room, like visitor_quit_room does for
+ * each of them. the visitors themselves stay allocated.
+ * Receives: visitor table, that holds the room's waiters
+ *           ChallengeRoom pointer
+ *           quit time as int
+ * Error Codes: NULL_PARAMETER if table or room is NULL*/
+Result room_visitors_quit(VisitorTable *table, ChallengeRoom *room,
+                          int quit_time){
+    if(table==NULL || room==NULL)
+        return NULL_PARAMETER;
+    for (int i = 0; i < room->num_of_challenges; ++i)
+        record_activity_quit(&room->challenges[i], quit_time);
+    return room_visitors_leave(table, room, quit_time);
+}
+
+/*  Function records on the challenge of an activity that its visitor quits:
+ * the best time and the completion. the activity keeps its visitor.
+ * Receives: ChallengeActivity pointer
+ *           quit time as int
+ * Error Codes: NULL_PARAMETER if activity is NULL*/
+Result record_activity_quit(ChallengeActivity *activity, int quit_time){
+    if(activity==NULL)
+        return NULL_PARAMETER;
+    if(activity->visitor==NULL)
+        return OK;
+    offer_best_time_of_challenge(activity->challenge,
+                                 quit_time - activity->start_time);
+    record_challenge_completion(activity->challenge, quit_time,
+                                quit_time - activity->start_time);
+    return OK;
+}
+
+/*  Function empties the room like room_visitors_quit, but writes nothing to
+ * the challenges, which record_activity_quit does apart.
+ * Receives: visitor table, that holds the room's waiters
+ *           ChallengeRoom pointer
+ *           quit time as int
+ * Error Codes: NULL_PARAMETER if table or room is NULL*/
+Result room_visitors_leave(VisitorTable *table, ChallengeRoom *room,
+                           int quit_time){
+    if(table==NULL || room==NULL)
+        return NULL_PARAMETER;
+    for (int i = 0; i < room->num_of_challenges; ++i) {
+        ChallengeActivity *activity = &room->challenges[i];
+        if (activity->visitor == NULL)
+            continue;
+        note_service(room, activity, quit_time - activity->start_time);
+        activity->visitor->slot=NO_SLOT;
+        activity->visitor->room=NO_ROOM;
+        activity->visitor=NULL;
+        note_occupancy(room, activity, -1);
+    }
+    //the waiting visitors leave without a challenge to hand over.
+    for (int level = 0; level <= All_Levels; ++level) {
+        while (room->queues[level].first != NO_VISITOR)
+            leave_wait_queue(table,
+                             VISITOR_RECORD(table, room->queues[level].first));
+    }
     return OK;
 }
 
@@ -281,43 +526,116 @@ Result visitor_quit_room(Visitor *visitor, int quit_time){
  *           level to find
  * Error Codes: NOT FOUND there are no available challenges of the cratiria*/
 static int find_challenge_available(ChallengeRoom *room, Level level) {
-    int current = NOT_FOUND;
-    num_of_free_places_for_level(room, level, &current);
-    if (current== 0)
+    if ((unsigned)level > All_Levels)
         return NOT_FOUND;
-    current=NOT_FOUND;
-    bool all_levels = false;
-    if (level == All_Levels)
-        all_levels = true;
-    for (int i = 0; i < room->num_of_challenges; ++i) {
-        if ((room->challenges[i]).visitor == NULL) {
-            if (all_levels) {
-                if (current == NOT_FOUND) {
-                    if (room->challenges[i].visitor == NULL)
-                        current = i;
-                }
-                else {
-                    if (strcmp(room->challenges[i].challenge->name,
-                               room->challenges[current].challenge->name) < 0)
-                        if (room->challenges[i].visitor == NULL)
-                            current = i;
-                }
-            }
-            else {
-                if (current == NOT_FOUND) {
-                    if ((room->challenges[i]).visitor == NULL &&
-                        level == room->challenges[i].challenge->level)
-                        current = i;
-                }
-                else {
-                    if ((room->challenges[i]).challenge->level== level &&
-                        strcmp(room->challenges[i].challenge->name,
-                               room->challenges[current].challenge->name) < 0)
-                        if (room->challenges[i].visitor != NULL)
-                            current = i;
-                }
-            }
-        }
+    return find_free_kernels[level](room);
+}
+
+/*  Function puts a visitor in a free challenge of the room and counts the
+ * visit.*/
+static void seat_visitor(ChallengeRoom *room, ChallengeActivity *activity,
+                         Visitor *visitor, int start_time){
+    activity->visitor = visitor;
+    activity->start_time = start_time;
+    inc_num_visits(activity->challenge);
+    record_challenge_visit(activity->challenge, start_time);
+    visitor->slot = (int)(activity - room->challenges);
+    visitor->room = room->index;
+    note_occupancy(room, activity, 1);
+}
+
+/*  Function takes a waiting visitor out of the queue of its room.*/
+static void leave_wait_queue(VisitorTable *table, Visitor *visitor){
+    WaitQueue *queue =
+            &VISITOR_ROOM(table, visitor)->queues[visitor->waiting_level];
+    if (visitor->previous_waiting != NO_VISITOR)
+        VISITOR_RECORD(table, visitor->previous_waiting)->next_waiting =
+                visitor->next_waiting;
+    else
+        queue->first = visitor->next_waiting;
+    if (visitor->next_waiting != NO_VISITOR)
+        VISITOR_RECORD(table, visitor->next_waiting)->previous_waiting =
+                visitor->previous_waiting;
+    else
+        queue->last = visitor->previous_waiting;
+    queue->length--;
+    visitor->next_waiting = NO_VISITOR;
+    visitor->previous_waiting = NO_VISITOR;
+    visitor->room = NO_ROOM;
+}
+
+/*  Function empties the wait queues of a room, without touching the
+ * visitors.*/
+static void empty_wait_queues(ChallengeRoom *room){
+    for (int level = 0; level <= All_Levels; ++level) {
+        room->queues[level].first = NO_VISITOR;
+        room->queues[level].last = NO_VISITOR;
+        room->queues[level].length = 0;
+    }
+}
+
+/*  Function gives a challenge that was just freed to the visitor that waits
+ * longest for its level or for any level, if there is one. since every
+ * freed challenge is handed over at once, a visitor only waits while no
+ * challenge it accepts is free, so the handed challenge is also the one
+ * visitor_enter_room would choose.*/
+static void hand_off_challenge(VisitorTable *table, ChallengeRoom *room,
+                               ChallengeActivity *activity, int time){
+    VisitorHandle first = room->queues[activity->level].first;
+    VisitorHandle any_level = room->queues[All_Levels].first;
+    Visitor *next = first == NO_VISITOR ? NULL : VISITOR_RECORD(table, first);
+    if (any_level != NO_VISITOR){
+        Visitor *any = VISITOR_RECORD(table, any_level);
+        if (!next || any->ticket < next->ticket)
+            next = any;
+    }
+    if (!next)
+        return;
+    leave_wait_queue(table, next);
+    seat_visitor(room, activity, next, time);
+}
+
+/*  Function counts a place of the activity's level as taken or freed.*/
+static void note_occupancy(ChallengeRoom *room, ChallengeActivity *activity,
+                           int change){
+    if (activity->level != All_Levels)
+        room->occupied[activity->level] += change;
+    room->occupied[All_Levels] += change;
+}
+
+/*  Function adds a sample to an exponentially weighted moving average. the
+ * first sample is the average.*/
+static double moving_average(double average, double sample, int num_samples){
+    if (num_samples == 0)
+        return sample;
+    return average + FORECAST_WEIGHT * (sample - average);
+}
+
+/*  Function counts an arrival for the level asked for and for all levels.*/
+static void note_arrival(ChallengeRoom *room, Level level, int time){
+    if ((unsigned)level > All_Levels)
+        return;
+    Level levels[] = {level, All_Levels};
+    for (int i = 0; i < (level == All_Levels ? 1 : 2); ++i) {
+        LevelForecast *forecast = &room->forecast[levels[i]];
+        if (forecast->num_arrivals > 0)
+            forecast->mean_gap = moving_average(forecast->mean_gap,
+                                                time - forecast->last_arrival,
+                                                forecast->num_arrivals - 1);
+        forecast->last_arrival = time;
+        forecast->num_arrivals++;
+    }
+}
+
+/*  Function counts the time a visitor took in a challenge, for the level of
+ * the challenge and for all levels.*/
+static void note_service(ChallengeRoom *room, ChallengeActivity *activity,
+                         int time){
+    Level levels[] = {activity->level, All_Levels};
+    for (int i = 0; i < (activity->level == All_Levels ? 1 : 2); ++i) {
+        LevelForecast *forecast = &room->forecast[levels[i]];
+        forecast->mean_service = moving_average(forecast->mean_service, time,
+                                                forecast->num_services);
+        forecast->num_services++;
     }
-    return current;
-}
\ No newline at end of file
+}
@@ -5,17 +5,33 @@
 #include <malloc.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
 
 #include "challenge.h"
 
 
-struct SChallengeActivity;
+/* the slot of a visitor that is in no challenge*/
+#define NO_SLOT -1
+/* the room index of a visitor that is in no room, or of a room no visitor
+ * table knows*/
+#define NO_ROOM -1
+
+/* a visitor is addressed by the handle of its record in the visitor table*/
+typedef uint32_t VisitorHandle;
+#define NO_VISITOR UINT32_MAX
+
+struct SVisitorTable;
 typedef struct SVisitor
 {
   char *visitor_name;
+  char inline_name[NAME_INLINE_SIZE];
+  int room; //index of the room the visitor is in or waits for, or NO_ROOM.
+  VisitorHandle next_waiting;
+  VisitorHandle previous_waiting;
+  unsigned long ticket; //order of arrival in the room's wait queues.
   int visitor_id;
-  char **room_name;
-  struct SChallengeActivity *current_challenge;
+  int slot; //of the visitor's challenge in its room, NO_SLOT while waiting.
+  Level waiting_level;
 } Visitor;
 
 
@@ -24,14 +40,56 @@ typedef struct SChallengeActivity
    Challenge *challenge;
    Visitor *visitor;
    int start_time;
+   Level level; //level of the challenge, so slot scans don't load it.
 } ChallengeActivity;
 
 
+/* visitors waiting for a challenge of one level, oldest first*/
+typedef struct SWaitQueue
+{
+   VisitorHandle first; //NO_VISITOR when the queue is empty.
+   VisitorHandle last;
+   int length;
+} WaitQueue;
+
+/* weight of the newest sample in the moving averages of a forecast*/
+#define FORECAST_WEIGHT 0.125
+#define FORECAST_UNKNOWN -1
+
+/* exponentially weighted moving averages of the arrivals to a room for a
+ * level and of the time its challenges of the level take*/
+typedef struct SLevelForecast
+{
+   double mean_gap; //time between two arrivals.
+   double mean_service; //time from entering a challenge to quitting it.
+   int last_arrival;
+   int num_arrivals;
+   int num_services;
+} LevelForecast;
+
+/* what room_forecast predicts for a room and a level*/
+typedef struct SRoomForecast
+{
+   double arrival_rate; //arrivals per time unit, 0 before two arrivals.
+   double mean_service; //0 before the first quit.
+   int free_places;
+   int waiting; //visitors that would get a freed place first.
+   int time_to_free_place; //0 if a place is free, or FORECAST_UNKNOWN.
+} RoomForecast;
+
 typedef struct SChallengeRoom
 {
    char *name;
+   char inline_name[NAME_INLINE_SIZE];
    int num_of_challenges;
    ChallengeActivity *challenges;
+   WaitQueue queues[All_Levels + 1]; //indexed by the level waited for.
+   unsigned long next_ticket;
+   int occupied[All_Levels + 1]; //taken places of every level.
+   int load_position[All_Levels + 1]; //index in the system's RoomLoad heaps.
+   LevelForecast forecast[All_Levels + 1];
+   bool retired; //dropped by a reload, released once its visitors left.
+   int index; //in the rooms of the visitor table, NO_ROOM until added.
 } ChallengeRoom;
 
 
@@ -41,7 +99,7 @@ Result reset_challenge_activity(ChallengeActivity *activity);
 
 Result init_visitor(Visitor *visitor, char *name, int id);
 
-Result reset_visitor(Visitor *visitor);
+Result reset_visitor(struct SVisitorTable *table, Visitor *visitor);
 
 Result init_room(ChallengeRoom *room, char *name, int num_challenges);
 
@@ -51,13 +109,43 @@ Result num_of_free_places_for_level(ChallengeRoom *room, Level level, int *place
 
 Result change_room_name(ChallengeRoom *room, char *new_name);
 
-Result room_of_visitor(Visitor *visitor, char **room_name);
+Result room_of_visitor(struct SVisitorTable *table, Visitor *visitor,
+                       char **room_name);
+
+Result room_of_visitor_view(struct SVisitorTable *table, Visitor *visitor,
+                            const char **room_name, int *length);
 
 Result visitor_enter_room(ChallengeRoom *room, Visitor *visitor, Level level, int start_time);
 /* the challenge to be chosen is the lexicographically named smaller one that has
    the required level. assume all names are different. */
 
-Result visitor_quit_room(Visitor *visitor, int quit_time);
+Result visitor_quit_room(struct SVisitorTable *table, Visitor *visitor,
+                         int quit_time);
+/* a visitor waiting in the room leaves its queue. a visitor in a challenge
+   frees it, and the challenge goes right away to the visitor that waits
+   longest for its level or for any level. */
+
+Result visitor_wait_in_room(struct SVisitorTable *table, ChallengeRoom *room,
+                            VisitorHandle handle, Level level);
+
+Result visitor_resume_challenge(ChallengeRoom *room, int slot,
+                                Visitor *visitor, int start_time);
+
+Result room_visitors_quit(struct SVisitorTable *table, ChallengeRoom *room,
+                          int quit_time);
+
+Result record_activity_quit(ChallengeActivity *activity, int quit_time);
+
+Result room_visitors_leave(struct SVisitorTable *table, ChallengeRoom *room,
+                           int quit_time);
+/* room_visitors_quit is record_activity_quit on every activity of the room
+   and then room_visitors_leave. the two halves let a caller update every
+   challenge from one thread while the rooms are emptied on others. */
+
+Result room_forecast(ChallengeRoom *room, Level level, RoomForecast *forecast);
+/* arrivals are counted by the level asked for, and all of them for
+   All_Levels; challenge times by the level of the challenge, and all of them
+   for All_Levels. */
 
 
 #endif // VISITOR_ROOM_H_
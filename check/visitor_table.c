@@ -0,0 +1,334 @@
+#include <stdlib.h>
+
+#include "visitor_table.h"
+
+/* the hash of the key a record is indexed by*/
+typedef uint32_t (*RecordHash)(Visitor *visitor);
+
+//Static functions list:
+static Result add_visitor_chunk(VisitorTable *table);
+static uint32_t hash_id(int visitor_id);
+static uint32_t hash_name(const char *name);
+static uint32_t record_id_hash(Visitor *visitor);
+static uint32_t record_name_hash(Visitor *visitor);
+static void insert_handle(VisitorTable *table, VisitorHandle *slots,
+                          uint32_t hash, VisitorHandle handle);
+static void erase_handle(VisitorTable *table, VisitorHandle *slots,
+                         RecordHash hash, VisitorHandle handle);
+static Result grow_visitor_index(VisitorTable *table);
+
+
+/*  Function hands out a record that is not in use. the record has no name
+ * until the visitor is initialized in it.
+ * Receives: table - the visitor table of the system
+ *           handle - return value is the handle of the record
+ * Error Codes: NULL_PARAMETER if table or handle is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory, or
+ *                             every handle is taken.*/
+Result take_visitor_record(VisitorTable *table, VisitorHandle *handle){
+    if (table == NULL || handle == NULL)
+        return NULL_PARAMETER;
+    if (table->num_free > 0){
+        *handle = table->free_handles[--table->num_free];
+        return OK;
+    }
+    if (table->num_records == table->num_chunks * VISITOR_CHUNK_SIZE){
+        Result result = add_visitor_chunk(table);
+        if (result != OK)
+            return result;
+    }
+    *handle = table->num_records++;
+    VISITOR_RECORD(table, *handle)->visitor_name = NULL;
+    return OK;
+}
+
+/*  Function hands a record back, once its visitor was reset.*/
+void return_visitor_record(VisitorTable *table, VisitorHandle handle){
+    if (table == NULL || handle >= table->num_records)
+        return;
+    assert(!VISITOR_IN_USE(VISITOR_RECORD(table, handle)));
+    table->free_handles[table->num_free++] = handle;
+}
+
+/*  Function adds a visitor to the id and name indexes, once it has both.
+ * Receives: table - the visitor table of the system
+ *           handle - of a record in use, that is not indexed yet
+ * Error Codes: NULL_PARAMETER if table is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result index_visitor(VisitorTable *table, VisitorHandle handle){
+    if (table == NULL)
+        return NULL_PARAMETER;
+    if ((table->num_indexed + 1) * 2 > table->index_capacity){
+        Result result = grow_visitor_index(table);
+        if (result != OK)
+            return result;
+    }
+    Visitor *visitor = VISITOR_RECORD(table, handle);
+    insert_handle(table, table->ids, record_id_hash(visitor), handle);
+    insert_handle(table, table->names, record_name_hash(visitor), handle);
+    table->num_indexed++;
+    return OK;
+}
+
+/*  Function takes an indexed visitor out of the indexes, before its record
+ * is reset.*/
+void unindex_visitor(VisitorTable *table, VisitorHandle handle){
+    if (table == NULL || table->num_indexed == 0)
+        return;
+    erase_handle(table, table->ids, record_id_hash, handle);
+    erase_handle(table, table->names, record_name_hash, handle);
+    table->num_indexed--;
+}
+
+/*  Function finds an indexed visitor by id.
+ * Returns the handle of the visitor, or NO_VISITOR if no visitor has the id.*/
+VisitorHandle find_visitor_id(VisitorTable *table, int visitor_id){
+    if (table == NULL || table->index_capacity == 0)
+        return NO_VISITOR;
+    uint32_t mask = table->index_capacity - 1;
+    for (uint32_t i = hash_id(visitor_id) & mask; table->ids[i] != NO_VISITOR;
+         i = (i + 1) & mask) {
+        if (VISITOR_RECORD(table, table->ids[i])->visitor_id == visitor_id)
+            return table->ids[i];
+    }
+    return NO_VISITOR;
+}
+
+/*  Function finds an indexed visitor by name.
+ * Returns the handle of the visitor, or NO_VISITOR if no visitor has the
+ * name.*/
+VisitorHandle find_visitor_name(VisitorTable *table, const char *name){
+    if (table == NULL || name == NULL || table->index_capacity == 0)
+        return NO_VISITOR;
+    uint32_t mask = table->index_capacity - 1;
+    for (uint32_t i = hash_name(name) & mask; table->names[i] != NO_VISITOR;
+         i = (i + 1) & mask) {
+        if (strcmp(VISITOR_RECORD(table, table->names[i])->visitor_name,
+                   name) == 0)
+            return table->names[i];
+    }
+    return NO_VISITOR;
+}
+
+/*  Function makes room in the table's list of rooms for more rooms, so
+ * adding them can't fail.
+ * Receives: table - the visitor table of the system
+ *           num_rooms - how many rooms will be added
+ * Error Codes: NULL_PARAMETER if table is NULL
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+Result reserve_visitor_rooms(VisitorTable *table, int num_rooms){
+    if (table == NULL)
+        return NULL_PARAMETER;
+    int needed = table->num_rooms + num_rooms;
+    if (needed <= table->room_capacity)
+        return OK;
+    ChallengeRoom **rooms = realloc(table->rooms, sizeof(ChallengeRoom*) *
+                                                  needed);
+    if (!rooms)
+        return MEMORY_PROBLEM;
+    for (int i = table->room_capacity; i < needed; ++i)
+        rooms[i] = NULL;
+    table->rooms = rooms;
+    table->room_capacity = needed;
+    return OK;
+}
+
+/*  Function gives a room the lowest free index of the table, for its
+ * visitors to keep.*/
+void add_visitor_room(VisitorTable *table, ChallengeRoom *room){
+    if (table == NULL || room == NULL)
+        return;
+    assert(table->num_rooms < table->room_capacity);
+    int index = table->first_free_room;
+    while (table->rooms[index] != NULL)
+        index++;
+    table->rooms[index] = room;
+    room->index = index;
+    table->num_rooms++;
+    table->first_free_room = index + 1;
+}
+
+/*  Function frees the index of a room that is released. no visitor may be in
+ * it or wait for it.*/
+void remove_visitor_room(VisitorTable *table, ChallengeRoom *room){
+    if (table == NULL || room == NULL || room->index == NO_ROOM)
+        return;
+    assert(table->rooms[room->index] == room);
+    table->rooms[room->index] = NULL;
+    if (room->index < table->first_free_room)
+        table->first_free_room = room->index;
+    room->index = NO_ROOM;
+    table->num_rooms--;
+}
+
+/*  Function resets every visitor in use and hands all the records back. the
+ * chunks, the indexes and the rooms are kept for the next visitors. the
+ * visitors must have left their rooms already.*/
+void clear_visitor_table(VisitorTable *table){
+    if (table == NULL)
+        return;
+    for (VisitorHandle handle = 0; handle < table->num_records; ++handle) {
+        Visitor *visitor = VISITOR_RECORD(table, handle);
+        if (VISITOR_IN_USE(visitor))
+            reset_visitor(table, visitor);
+    }
+    table->num_records = 0;
+    table->num_free = 0;
+    if (table->index_capacity > 0){
+        //every byte of NO_VISITOR is set.
+        memset(table->ids, 0xff, sizeof(VisitorHandle) * table->index_capacity);
+        memset(table->names, 0xff,
+               sizeof(VisitorHandle) * table->index_capacity);
+    }
+    table->num_indexed = 0;
+}
+
+/*  Function resets every visitor in use and releases the table's memory.*/
+void destroy_visitor_table(VisitorTable *table){
+    if (table == NULL)
+        return;
+    clear_visitor_table(table);
+    for (uint32_t i = 0; i < table->num_chunks; ++i)
+        free(table->chunks[i]);
+    free(table->chunks);
+    free(table->free_handles);
+    free(table->ids);
+    free(table->names);
+    free(table->rooms);
+    table->chunks = NULL;
+    table->free_handles = NULL;
+    table->num_chunks = 0;
+    table->chunk_capacity = 0;
+    table->ids = NULL;
+    table->names = NULL;
+    table->index_capacity = 0;
+    table->rooms = NULL;
+    table->room_capacity = 0;
+    table->num_rooms = 0;
+    table->first_free_room = 0;
+}
+
+//static functions
+
+/*  Function adds a chunk of records. the chunk array and the free list grow
+ * together, to twice their size when they are full, so they keep room for
+ * the handle of every record.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory, or
+ *                             every handle is taken.*/
+static Result add_visitor_chunk(VisitorTable *table){
+    const uint32_t max_chunks = UINT32_MAX / VISITOR_CHUNK_SIZE;
+    if (table->num_chunks >= max_chunks)
+        return MEMORY_PROBLEM;
+    if (table->num_chunks == table->chunk_capacity){
+        uint32_t capacity = table->chunk_capacity == 0 ? 1 :
+                            table->chunk_capacity * 2;
+        if (capacity > max_chunks)
+            capacity = max_chunks;
+        Visitor **chunks = realloc(table->chunks, sizeof(Visitor*) * capacity);
+        if (!chunks)
+            return MEMORY_PROBLEM;
+        table->chunks = chunks;
+        VisitorHandle *free_handles = realloc(table->free_handles,
+                sizeof(VisitorHandle) * VISITOR_CHUNK_SIZE * (size_t)capacity);
+        if (!free_handles)
+            return MEMORY_PROBLEM;
+        table->free_handles = free_handles;
+        table->chunk_capacity = capacity;
+    }
+    Visitor *chunk = malloc(sizeof(Visitor) * VISITOR_CHUNK_SIZE);
+    if (!chunk)
+        return MEMORY_PROBLEM;
+    table->chunks[table->num_chunks++] = chunk;
+    return OK;
+}
+
+/*  Function hashes an id, mixing the high bits of the product down to the
+ * low ones the indexes mask.*/
+static uint32_t hash_id(int visitor_id){
+    uint32_t hash = (uint32_t)visitor_id * 0x9e3779b1u;
+    return hash ^ (hash >> 16);
+}
+
+/*  Function hashes a name with FNV-1a.*/
+static uint32_t hash_name(const char *name){
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char*)name; *c; ++c)
+        hash = (hash ^ *c) * 16777619u;
+    return hash;
+}
+
+static uint32_t record_id_hash(Visitor *visitor){
+    return hash_id(visitor->visitor_id);
+}
+
+static uint32_t record_name_hash(Visitor *visitor){
+    return hash_name(visitor->visitor_name);
+}
+
+/*  Function puts a handle in the first empty slot of its probe sequence.
+ * the index must have an empty slot.*/
+static void insert_handle(VisitorTable *table, VisitorHandle *slots,
+                          uint32_t hash, VisitorHandle handle){
+    uint32_t mask = table->index_capacity - 1;
+    uint32_t i = hash & mask;
+    while (slots[i] != NO_VISITOR)
+        i = (i + 1) & mask;
+    slots[i] = handle;
+}
+
+/*  Function takes an indexed handle out of an index. the handles after it in
+ * the probe run are shifted back into the hole when their own slot is not
+ * between the hole and them, so lookups never need tombstones.*/
+static void erase_handle(VisitorTable *table, VisitorHandle *slots,
+                         RecordHash hash, VisitorHandle handle){
+    uint32_t mask = table->index_capacity - 1;
+    uint32_t hole = hash(VISITOR_RECORD(table, handle)) & mask;
+    while (slots[hole] != handle)
+        hole = (hole + 1) & mask;
+    for (uint32_t next = (hole + 1) & mask; slots[next] != NO_VISITOR;
+         next = (next + 1) & mask) {
+        uint32_t home = hash(VISITOR_RECORD(table, slots[next])) & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)){
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    }
+    slots[hole] = NO_VISITOR;
+}
+
+/*  Function doubles both indexes and puts their handles in again.
+ * Error Codes: MEMORY_PROBLEM if system was unable to allocate memory, or
+ *                             the indexes can't grow further.*/
+static Result grow_visitor_index(VisitorTable *table){
+    uint32_t capacity = table->index_capacity == 0 ?
+                        VISITOR_INDEX_MIN_CAPACITY : table->index_capacity * 2;
+    if (capacity <= table->index_capacity)
+        return MEMORY_PROBLEM;
+    VisitorHandle *ids = malloc(sizeof(VisitorHandle) * (size_t)capacity);
+    VisitorHandle *names = malloc(sizeof(VisitorHandle) * (size_t)capacity);
+    if (!ids || !names){
+        free(ids);
+        free(names);
+        return MEMORY_PROBLEM;
+    }
+    memset(ids, 0xff, sizeof(VisitorHandle) * (size_t)capacity);
+    memset(names, 0xff, sizeof(VisitorHandle) * (size_t)capacity);
+    VisitorHandle *old_ids = table->ids, *old_names = table->names;
+    uint32_t old_capacity = table->index_capacity;
+    table->ids = ids;
+    table->names = names;
+    table->index_capacity = capacity;
+    for (uint32_t i = 0; i < old_capacity; ++i) {
+        if (old_ids[i] != NO_VISITOR)
+            insert_handle(table, ids,
+                          record_id_hash(VISITOR_RECORD(table, old_ids[i])),
+                          old_ids[i]);
+        if (old_names[i] != NO_VISITOR)
+            insert_handle(table, names,
+                          record_name_hash(VISITOR_RECORD(table, old_names[i])),
+                          old_names[i]);
+    }
+    free(old_ids);
+    free(old_names);
+    return OK;
+}
@@ -0,0 +1,77 @@
+#ifndef VISITOR_TABLE_H_
+#define VISITOR_TABLE_H_
+
+#include <stdint.h>
+
+#include "visitor_room.h"
+
+/* The visitors of a system, kept as records of one table and addressed by
+ * 32 bit handles, instead of a list with a node and a visitor allocated for
+ * every arrival. The records are kept in chunks of VISITOR_CHUNK_SIZE that
+ * never move, so rooms can point at them, and the records of visitors that
+ * left are handed out again first. A record is in use while its visitor has
+ * a name.
+ * The visitors are found by id and by name through two open addressed
+ * indexes of handles, probed linearly and kept at most half full. The table
+ * also lists the rooms of the system, so a visitor keeps the index of its
+ * room and the wait queues link handles, and neither holds a pointer. */
+
+#define VISITOR_CHUNK_BITS 6
+#define VISITOR_CHUNK_SIZE (1u << VISITOR_CHUNK_BITS)
+#define VISITOR_INDEX_MIN_CAPACITY 16u
+
+typedef struct SVisitorTable
+{
+   Visitor **chunks;
+   uint32_t num_chunks;
+   uint32_t chunk_capacity; //of the chunk array, doubled when full.
+   uint32_t num_records; //handed out so far, in use or not.
+   VisitorHandle *free_handles; //records handed back, room for every record.
+   uint32_t num_free;
+   VisitorHandle *ids; //index by id, NO_VISITOR where empty.
+   VisitorHandle *names; //index by name, the same size.
+   uint32_t index_capacity; //a power of 2, 0 before the first visitor.
+   uint32_t num_indexed;
+   ChallengeRoom **rooms; //by index, NULL where a room was removed.
+   int room_capacity;
+   int num_rooms;
+   int first_free_room; //no room index below it is free.
+} VisitorTable;
+
+/* the record of a handle below the table's num_records*/
+#define VISITOR_RECORD(table, handle) \
+   (&(table)->chunks[(handle) >> VISITOR_CHUNK_BITS] \
+                    [(handle) & (VISITOR_CHUNK_SIZE - 1)])
+
+#define VISITOR_IN_USE(visitor) ((visitor)->visitor_name != NULL)
+
+/* the room of a visitor that is in a room or waits for one*/
+#define VISITOR_ROOM(table, visitor) ((table)->rooms[(visitor)->room])
+
+
+Result take_visitor_record(VisitorTable *table, VisitorHandle *handle);
+
+void return_visitor_record(VisitorTable *table, VisitorHandle handle);
+
+Result index_visitor(VisitorTable *table, VisitorHandle handle);
+
+void unindex_visitor(VisitorTable *table, VisitorHandle handle);
+
+VisitorHandle find_visitor_id(VisitorTable *table, int visitor_id);
+
+VisitorHandle find_visitor_name(VisitorTable *table, const char *name);
+
+Result reserve_visitor_rooms(VisitorTable *table, int num_rooms);
+
+void add_visitor_room(VisitorTable *table, ChallengeRoom *room);
+/* the room must have been reserved for. the room takes the lowest free
+   index. */
+
+void remove_visitor_room(VisitorTable *table, ChallengeRoom *room);
+
+void clear_visitor_table(VisitorTable *table);
+
+void destroy_visitor_table(VisitorTable *table);
+
+
+#endif // VISITOR_TABLE_H_
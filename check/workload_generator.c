@@ -0,0 +1,351 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "event_log.h"
+
+/* Generates a test_1.txt style init file and a matching event trace for the
+ * replay tool.
+ * Usage: generator <init_file> <event_log> [--challenges N] [--rooms N]
+ *                  [--slots N] [--arrivals N] [--rate R] [--stay T]
+ *                  [--levels E,M,H,A] [--zipf S] [--queries Q] [--seed N]
+ *                  [--waits W] [--all-quit K] [--binary]
+ *   rate   - mean arrivals per time unit (poisson arrivals)
+ *   stay   - mean time a visitor spends in a challenge (exponential)
+ *   levels - relative weights of easy, medium, hard and all levels requests
+ *   zipf   - skew of room popularity, 0 is uniform
+ *   queries - chance of a room_of_visitor query after every arrival
+ *   waits  - chance that an arrival waits in the room when it is full
+ *   all-quit - an all_visitors_quit after every K arrivals, 0 for none*/
+
+//Defines:
+#define USAGE "usage: generator <init_file> <event_log> [--challenges N] " \
+              "[--rooms N] [--slots N] [--arrivals N] [--rate R] [--stay T] " \
+              "[--levels E,M,H,A] [--zipf S] [--queries Q] [--seed N] " \
+              "[--waits W] [--all-quit K] [--binary]\n"
+#define NUM_LEVELS (All_Levels + 1)
+#define NUM_CHALLENGE_LEVELS 3
+#define DEFAULT_SEED 2017
+
+typedef struct SGeneratorOptions
+{
+   int challenges;
+   int rooms;
+   int slots;
+   int arrivals;
+   double rate;
+   double stay;
+   double level_weights[NUM_LEVELS];
+   double zipf;
+   double queries;
+   double waits;
+   int all_quit_every;
+   unsigned long long seed;
+   EventLogFormat format;
+} GeneratorOptions;
+
+typedef struct SPendingQuit
+{
+   double time;
+   int visitor_id;
+} PendingQuit;
+
+typedef struct SQuitQueue
+{
+   PendingQuit *items;
+   int size;
+} QuitQueue;
+
+//Static functions list:
+static Result parse_options(int argc, char **argv, GeneratorOptions *options);
+static Result write_init_file(char *path, GeneratorOptions *options);
+static Result write_trace(char *path, GeneratorOptions *options);
+static double *zipf_distribution(int size, double skew);
+static int sample(double *cumulative, int size, double uniform);
+static double next_uniform(unsigned long long *state);
+static double next_exponential(unsigned long long *state, double mean);
+static void push_quit(QuitQueue *queue, double time, int visitor_id);
+static PendingQuit pop_quit(QuitQueue *queue);
+static void emit_quit(FILE *file, GeneratorOptions *options,
+                      PendingQuit quit, int *last_time);
+
+
+int main(int argc, char **argv){
+    if (argc < 3){
+        printf(USAGE);
+        return 1;
+    }
+    GeneratorOptions options;
+    if (parse_options(argc, argv, &options) != OK){
+        printf(USAGE);
+        return 1;
+    }
+    if (write_init_file(argv[1], &options) != OK){
+        printf("Error: cannot write init file.\n");
+        return 1;
+    }
+    if (write_trace(argv[2], &options) != OK){
+        printf("Error: cannot write event trace.\n");
+        return 1;
+    }
+    return 0;
+}
+
+//static functions
+
+/*  Function fills the options with defaults and overrides them from argv.
+ * Error Codes: ILLEGAL_PARAMETER if an option is unknown or out of range*/
+static Result parse_options(int argc, char **argv, GeneratorOptions *options){
+    options->challenges = 6;
+    options->rooms = 4;
+    options->slots = 3;
+    options->arrivals = 1000;
+    options->rate = 1;
+    options->stay = 10;
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        options->level_weights[level] = 1;
+    }
+    options->zipf = 0;
+    options->queries = 0;
+    options->waits = 0;
+    options->all_quit_every = 0;
+    options->seed = DEFAULT_SEED;
+    options->format = EVENT_LOG_TEXT;
+    for (int i = 3; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (!strcmp(argv[i], "--binary"))
+            options->format = EVENT_LOG_BINARY;
+        else if (!has_value)
+            return ILLEGAL_PARAMETER;
+        else if (!strcmp(argv[i], "--challenges"))
+            options->challenges = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--rooms"))
+            options->rooms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--slots"))
+            options->slots = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--arrivals"))
+            options->arrivals = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--rate"))
+            options->rate = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--stay"))
+            options->stay = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--zipf"))
+            options->zipf = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--queries"))
+            options->queries = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--waits"))
+            options->waits = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--all-quit"))
+            options->all_quit_every = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed"))
+            options->seed = strtoull(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--levels")){
+            double *weights = options->level_weights;
+            if (sscanf(argv[++i], "%lf,%lf,%lf,%lf", &weights[Easy],
+                       &weights[Medium], &weights[Hard],
+                       &weights[All_Levels]) != NUM_LEVELS)
+                return ILLEGAL_PARAMETER;
+        }
+        else
+            return ILLEGAL_PARAMETER;
+    }
+    if (options->challenges < 1 || options->rooms < 1 || options->slots < 1 ||
+        options->arrivals < 0 || options->rate <= 0 || options->stay <= 0 ||
+        options->zipf < 0 || options->waits < 0 ||
+        options->all_quit_every < 0)
+        return ILLEGAL_PARAMETER;
+    if (options->seed == 0)
+        options->seed = DEFAULT_SEED; //xorshift state must not be zero.
+    return OK;
+}
+
+/*  Function writes the system name, the challenges (ids 1..N with a uniform
+ * level) and the rooms, every slot holding a uniformly chosen challenge.
+ * Error Codes: ILLEGAL_PARAMETER if the file can't be opened*/
+static Result write_init_file(char *path, GeneratorOptions *options){
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return ILLEGAL_PARAMETER;
+    unsigned long long state = options->seed;
+    fprintf(file, "system_generated\n%d\n", options->challenges);
+    for (int i = 1; i <= options->challenges; ++i) {
+        int level = 1 + (int)(next_uniform(&state) * NUM_CHALLENGE_LEVELS);
+        fprintf(file, "challenge_%d %d %d\n", i, i, level);
+    }
+    fprintf(file, "%d\n", options->rooms);
+    for (int i = 1; i <= options->rooms; ++i) {
+        fprintf(file, "room_%d %d", i, options->slots);
+        for (int j = 0; j < options->slots; ++j) {
+            fprintf(file, " %d", 1 +
+                    (int)(next_uniform(&state) * options->challenges));
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    return OK;
+}
+
+/*  Function writes poisson arrivals to zipf distributed rooms, and the quit of
+ * every visitor once its exponential stay is over, in time order.
+ * Error Codes: ILLEGAL_PARAMETER if the file can't be opened
+ *              MEMORY_PROBLEM if system was unable to allocate memory.*/
+static Result write_trace(char *path, GeneratorOptions *options){
+    FILE *file = fopen(path, options->format == EVENT_LOG_BINARY ? "wb" : "w");
+    if (!file)
+        return ILLEGAL_PARAMETER;
+    double *rooms = zipf_distribution(options->rooms, options->zipf);
+    QuitQueue queue;
+    queue.size = 0;
+    queue.items = malloc(sizeof(*queue.items) * (options->arrivals + 1));
+    if (!rooms || !queue.items){
+        free(rooms);
+        free(queue.items);
+        fclose(file);
+        return MEMORY_PROBLEM;
+    }
+    double levels[NUM_LEVELS], total_weight = 0;
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        total_weight += options->level_weights[level];
+        levels[level] = total_weight;
+    }
+    write_event_log_header(file, options->format);
+    unsigned long long state = options->seed ^ (options->seed << 17);
+    char room_name[32], visitor_name[32];
+    double clock = 0;
+    int last_time = 0;
+    Event event;
+    for (int id = 1; id <= options->arrivals; ++id) {
+        clock += next_exponential(&state, 1 / options->rate);
+        while (queue.size > 0 && queue.items[0].time <= clock)
+            emit_quit(file, options, pop_quit(&queue), &last_time);
+        int time = (int)clock < last_time ? last_time : (int)clock;
+        sprintf(room_name, "room_%d", 1 + sample(rooms, options->rooms,
+                                                 next_uniform(&state)));
+        sprintf(visitor_name, "visitor_%d", id);
+        event.op = EVENT_ARRIVE;
+        if (options->waits > 0 && next_uniform(&state) < options->waits)
+            event.op = EVENT_ARRIVE_OR_WAIT;
+        event.first_name = room_name;
+        event.second_name = visitor_name;
+        event.id = id;
+        event.time = time;
+        event.level = (Level)sample(levels, NUM_LEVELS,
+                                    next_uniform(&state) * total_weight);
+        write_event(file, options->format, &event);
+        last_time = time;
+        push_quit(&queue, clock + next_exponential(&state, options->stay), id);
+        if (next_uniform(&state) < options->queries){
+            event.op = EVENT_ROOM_OF_VISITOR;
+            sprintf(visitor_name, "visitor_%d",
+                    1 + (int)(next_uniform(&state) * id));
+            event.first_name = visitor_name;
+            write_event(file, options->format, &event);
+        }
+        if (options->all_quit_every > 0 && id % options->all_quit_every == 0){
+            event.op = EVENT_ALL_QUIT;
+            write_event(file, options->format, &event);
+            queue.size = 0; //every visitor left with the all quit.
+        }
+    }
+    while (queue.size > 0)
+        emit_quit(file, options, pop_quit(&queue), &last_time);
+    free(rooms);
+    free(queue.items);
+    fclose(file);
+    return OK;
+}
+
+/*  Function returns the cumulative zipf weights of ranks 1..size, the caller
+ * must free it. NULL if allocation fails.*/
+static double *zipf_distribution(int size, double skew){
+    double *cumulative = malloc(sizeof(*cumulative) * size);
+    if (!cumulative)
+        return NULL;
+    double total = 0;
+    for (int rank = 1; rank <= size; ++rank) {
+        total += 1 / pow(rank, skew);
+        cumulative[rank - 1] = total;
+    }
+    for (int i = 0; i < size; ++i) {
+        cumulative[i] /= total;
+    }
+    return cumulative;
+}
+
+/*  Function returns the first index whose cumulative weight exceeds the
+ * uniform value, by binary search.*/
+static int sample(double *cumulative, int size, double uniform){
+    int low = 0, high = size - 1;
+    while (low < high){
+        int middle = (low + high) / 2;
+        if (cumulative[middle] > uniform)
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+/*  Function returns a uniform value in [0, 1) from a xorshift64* generator,
+ * so traces are reproducible from the seed on every platform.*/
+static double next_uniform(unsigned long long *state){
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    unsigned long long value = *state * 2685821657736338717ULL;
+    return (value >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*  Function returns an exponentially distributed value with the given mean.*/
+static double next_exponential(unsigned long long *state, double mean){
+    return -mean * log(1 - next_uniform(state));
+}
+
+/*  Function adds a quit to the binary min heap ordered by time.*/
+static void push_quit(QuitQueue *queue, double time, int visitor_id){
+    int child = queue->size++;
+    while (child > 0){
+        int parent = (child - 1) / 2;
+        if (queue->items[parent].time <= time)
+            break;
+        queue->items[child] = queue->items[parent];
+        child = parent;
+    }
+    queue->items[child].time = time;
+    queue->items[child].visitor_id = visitor_id;
+}
+
+/*  Function removes and returns the earliest quit, the queue must not be
+ * empty.*/
+static PendingQuit pop_quit(QuitQueue *queue){
+    PendingQuit first = queue->items[0];
+    PendingQuit last = queue->items[--queue->size];
+    int parent = 0;
+    while (2 * parent + 1 < queue->size){
+        int child = 2 * parent + 1;
+        if (child + 1 < queue->size &&
+            queue->items[child + 1].time < queue->items[child].time)
+            child++;
+        if (last.time <= queue->items[child].time)
+            break;
+        queue->items[parent] = queue->items[child];
+        parent = child;
+    }
+    queue->items[parent] = last;
+    return first;
+}
+
+/*  Function writes a quit event, keeping the trace times non decreasing.*/
+static void emit_quit(FILE *file, GeneratorOptions *options,
+                      PendingQuit quit, int *last_time){
+    Event event;
+    event.op = EVENT_QUIT;
+    event.level = All_Levels;
+    event.id = quit.visitor_id;
+    event.time = (int)quit.time < *last_time ? *last_time : (int)quit.time;
+    event.first_name = NULL;
+    event.second_name = NULL;
+    write_event(file, options->format, &event);
+    *last_time = event.time;
+}